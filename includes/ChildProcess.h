@@ -0,0 +1,96 @@
+#ifndef CHILD_PROCESS_H
+#define CHILD_PROCESS_H
+
+#include <QObject>
+#include <QString>
+#include <QStringDecoder>
+#include <QStringList>
+#include <sys/types.h>
+
+class QSocketNotifier;
+class QTimer;
+
+/*
+ * @brief ChildProcess runs one external command (replaces QProcess)
+ *
+ * - Started through ProcessSpawn: cached PATH lookup, cached envp block,
+ *   posix_spawn.
+ * - stdout and stderr are read from non-blocking pipes as they arrive,
+ *   decoding keeps multi-byte characters split across reads intact.
+ * - Exit is noticed through a pidfd (polled on kernels without pidfd).
+ *
+ */
+class ChildProcess : public QObject {
+  Q_OBJECT
+
+public:
+  explicit ChildProcess(QObject *parent = nullptr);
+
+  /*
+   * @brief Kills a child that is still running
+   */
+  ~ChildProcess();
+
+  /*
+   * @brief Resolves and starts program
+   *
+   * @param program Command name (looked up in PATH) or path.
+   * @param args Arguments, without the program name.
+   *
+   * @return false if the program was not found or could not be started,
+   *         see error().
+   */
+  bool start(const QString &program, const QStringList &args);
+
+  /*
+   * @brief errno of the failed start (ENOENT when not found)
+   */
+  int error() const;
+
+  bool isRunning() const;
+  qint64 processId() const;
+
+  /*
+   * @brief Sends a signal to the running child (SIGINT for Ctrl+C)
+   */
+  void sendSignal(int signal);
+
+signals:
+  void outputReady(QString output);
+  void errorReady(QString error);
+
+  /*
+   * @brief Emitted once the child exited and its output was drained
+   *
+   * @param exitCode The exit status, 128 + signal if it was killed
+   */
+  void finished(int exitCode);
+
+private slots:
+  void readOutput();
+  void readError();
+
+  /*
+   * @brief Reaps the child if it exited
+   */
+  void checkExit();
+
+private:
+  QString readPipe(int &fd, QSocketNotifier *&notifier,
+                   QStringDecoder &decoder);
+  void closeAll();
+
+  pid_t pid = -1;                             // Running child
+  int outputFd = -1;                          // Read end of stdout pipe
+  int errorFd = -1;                           // Read end of stderr pipe
+  int exitFd = -1;                            // pidfd, readable on exit
+  int lastError = 0;                          // errno of a failed start
+  QSocketNotifier *outputNotifier = nullptr;
+  QSocketNotifier *errorNotifier = nullptr;
+  QSocketNotifier *exitNotifier = nullptr;
+  QTimer *exitPoll = nullptr;                 // Fallback without pidfd
+  QStringDecoder outputDecoder{QStringDecoder::System};
+  QStringDecoder errorDecoder{QStringDecoder::System};
+};
+
+#endif // CHILD_PROCESS_H
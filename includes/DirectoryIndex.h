@@ -0,0 +1,108 @@
+#ifndef DIRECTORY_INDEX_H
+#define DIRECTORY_INDEX_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * @brief DirectoryIndex ranks visited directories by frecency ('z')
+ *
+ * - Every visit raises the directory's rank, old ranks decay once their
+ *   sum passes a limit. The score weighs the rank by how recently the
+ *   directory was visited.
+ * - The database is a small binary file (fixed header, packed records)
+ *   read through an mmap. Visits update the in-memory copy at once, a
+ *   writer thread merges them into the file and replaces it atomically,
+ *   so a cd never waits for the disk and shells sharing the file keep
+ *   each other's visits.
+ * - Queries match words against the paths: substrings in order with the
+ *   last one in the last component rank first, in-order subsequences
+ *   still match with a lower weight. Case is ignored unless a word has
+ *   an upper case letter.
+ *
+ */
+class DirectoryIndex {
+public:
+  struct Match {
+    std::string path;
+    double score = 0;
+  };
+
+  /*
+   * @brief Loads the database at path, missing files start empty
+   */
+  explicit DirectoryIndex(const std::string &path);
+
+  /*
+   * @brief Writes the pending changes and stops the writer
+   */
+  ~DirectoryIndex();
+
+  DirectoryIndex(const DirectoryIndex &) = delete;
+  DirectoryIndex &operator=(const DirectoryIndex &) = delete;
+
+  /*
+   * @brief $XDG_DATA_HOME/qshell/dirs.db (~/.local/share by default)
+   */
+  static std::string defaultPath();
+
+  /*
+   * @brief Records a visit of an absolute directory path
+   */
+  void recordVisit(const std::string &directory);
+
+  /*
+   * @brief Forgets a directory (removed, or asked with 'z -x')
+   */
+  void remove(const std::string &directory);
+
+  /*
+   * @brief Directories matching all words, best first
+   *
+   * @param words Query words, empty matches every directory.
+   * @param limit Maximum number of results, 0 for all.
+   */
+  std::vector<Match> query(const std::vector<std::string> &words,
+                           std::size_t limit = 0) const;
+
+  /*
+   * @brief Waits until the pending changes are written
+   */
+  void flush();
+
+private:
+  struct Entry {
+    std::string path;
+    std::string folded;   // Lower case path for matching
+    double rank = 0;      // Visit count, aged
+    std::int64_t time = 0; // Last visit, seconds since the epoch
+  };
+
+  struct Change {
+    std::string path;
+    std::int64_t time = 0; // 0 removes the path
+  };
+
+  static std::vector<Entry> load(const std::string &path);
+  static bool save(const std::string &path, const std::vector<Entry> &entries);
+  static void apply(std::vector<Entry> &entries, const Change &change);
+
+  void queue(const Change &change);
+  void writeChanges();
+
+  std::string databasePath;
+  mutable std::mutex mutex;          // Guards everything below
+  std::condition_variable wake;      // Wakes the writer
+  std::condition_variable written;   // Signals flush()
+  std::vector<Entry> entries;        // Current view, pending changes included
+  std::vector<Change> changes;       // Not yet in the file
+  bool writing = false;              // Writer holds taken changes
+  bool stopping = false;             // Writer drains and exits
+  std::thread writer;                // Started on the first change
+};
+
+#endif // DIRECTORY_INDEX_H
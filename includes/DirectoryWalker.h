@@ -0,0 +1,135 @@
+#ifndef DIRECTORY_WALKER_H
+#define DIRECTORY_WALKER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+ * @brief Options of a DirectoryWalker
+ */
+struct WalkOptions {
+  int threads = 0;             // 0 uses one worker per core
+  int maxDepth = -1;           // deepest entry visited, -1 unlimited
+  bool followLinks = false;    // descend into symlinked directories
+  bool needMetadata = true;    // statx every entry
+  bool trackHardlinks = false; // set Entry::seenLink
+};
+
+/*
+ * @brief DirectoryWalker walks directory trees on several threads
+ *
+ * - Every worker owns a queue of directories, idle workers steal from
+ *   the others.
+ * - Entries are read from an open directory fd, metadata is fetched with
+ *   statx relative to that fd (no path lookup per file).
+ * - statx is skipped when the caller only needs names and types.
+ * - Hardlinked files can be flagged after their first visit, so sizes are
+ *   not counted twice.
+ * - The visitor runs concurrently on the worker threads.
+ *
+ */
+class DirectoryWalker {
+public:
+  enum EntryType { Unknown, Regular, Directory, Symlink, Other };
+
+  struct Entry {
+    std::string path;           // root joined with the relative path
+    std::size_t nameOffset = 0; // start of the last component in path
+    EntryType type = Unknown;
+    bool hasMetadata = false;   // fields below are filled
+    std::uint64_t size = 0;     // apparent size in bytes
+    std::uint64_t blocks = 0;   // allocated 512-byte blocks
+    std::uint64_t device = 0;
+    std::uint64_t inode = 0;
+    std::uint32_t links = 0;
+    int depth = 0;              // 0 for a root
+    int root = 0;               // index of the root being walked
+    bool seenLink = false;      // hardlink already visited (trackHardlinks)
+
+    const char *name() const { return path.c_str() + nameOffset; }
+  };
+
+  /*
+   * @brief Called for every entry, from any worker thread
+   *
+   * @param entry The visited entry.
+   * @param worker Index of the calling worker, below threadCount().
+   *
+   * @return false to not descend into a directory entry.
+   */
+  using Visitor = std::function<bool(const Entry &entry, int worker)>;
+
+  /*
+   * @brief Called for paths that could not be read, from any worker thread
+   */
+  using ErrorHandler =
+      std::function<void(const std::string &path, int error, int worker)>;
+
+  explicit DirectoryWalker(const WalkOptions &options = WalkOptions());
+  ~DirectoryWalker();
+
+  DirectoryWalker(const DirectoryWalker &) = delete;
+  DirectoryWalker &operator=(const DirectoryWalker &) = delete;
+
+  /*
+   * @brief Number of workers, visitors may keep per worker state
+   */
+  int threadCount() const;
+
+  /*
+   * @brief Walks all roots and returns once every entry was visited
+   *
+   * @return false if the walk was cancelled.
+   */
+  bool walk(const std::vector<std::string> &roots, const Visitor &visitor,
+            const ErrorHandler &onError);
+
+  /*
+   * @brief Stops a running walk, safe to call from any thread
+   *
+   * A cancelled walker stays cancelled, a new walk returns at once.
+   */
+  void cancel();
+
+private:
+  struct Job {
+    std::string path;
+    int depth = 0;
+    int root = 0;
+  };
+
+  struct Worker {
+    std::mutex mutex;
+    std::deque<Job> jobs; // owner pops the back, thieves take the front
+  };
+
+  class InodeSet;
+
+  void runWorker(int index);
+  bool takeJob(int index, Job &job);
+  void pushJob(int index, Job job);
+  void readDirectory(const Job &job, int index);
+  bool fillMetadata(int dirFd, const char *name, bool follow, Entry &entry);
+  bool shouldDescend(const Entry &entry);
+
+  WalkOptions options;
+  int threads = 1;
+  std::vector<std::unique_ptr<Worker>> workers;
+  std::unique_ptr<InodeSet> hardlinks;   // files with more than one link
+  std::unique_ptr<InodeSet> directories; // loop guard with followLinks
+  std::atomic<long> pending{0};          // queued or running directories
+  std::atomic<bool> stopped{false};
+  std::mutex idleMutex;
+  std::condition_variable idle;
+  const Visitor *visitor = nullptr;
+  const ErrorHandler *errorHandler = nullptr;
+};
+
+#endif // DIRECTORY_WALKER_H
@@ -0,0 +1,52 @@
+#ifndef FILE_FOLLOWER_H
+#define FILE_FOLLOWER_H
+
+#include <QObject>
+#include <QString>
+
+class QSocketNotifier;
+
+/*
+ * @brief FileFollower streams data appended to a file (tail -f)
+ *
+ * - Waits on inotify, so an idle file costs no CPU and no polling.
+ * - Reads only the bytes appended since the last event.
+ * - Restarts from the beginning when the file is truncated.
+ *
+ */
+class FileFollower : public QObject {
+  Q_OBJECT
+
+public:
+  /*
+   * @brief Starts following path from offset
+   *
+   * @param path File to follow.
+   * @param offset Bytes already shown to the user.
+   */
+  FileFollower(const QString &path, qint64 offset, QObject *parent = nullptr);
+  ~FileFollower();
+
+  /*
+   * @brief True if the inotify watch could be installed
+   */
+  bool isValid() const;
+
+signals:
+  void dataAppended(QString data);
+  void followError(QString error);
+
+private slots:
+  /*
+   * @brief Drains inotify events and reads the new file content
+   */
+  void readEvents();
+
+private:
+  QString path;                       // Followed file
+  qint64 offset = 0;                  // Bytes read so far
+  int inotifyFd = -1;                 // inotify instance
+  QSocketNotifier *notifier = nullptr; // Wakes up on inotify events
+};
+
+#endif // FILE_FOLLOWER_H
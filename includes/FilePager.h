@@ -0,0 +1,139 @@
+#ifndef FILE_PAGER_H
+#define FILE_PAGER_H
+
+#include "WatchCommand.h"
+#include <QByteArray>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QThreadPool>
+#include <atomic>
+#include <memory>
+
+class LineIndex;
+class MappedFile;
+class QTimer;
+
+/*
+ * @brief FilePager shows a file one page at a time (view / less)
+ *
+ * - The file stays mmapped, only the lines on screen are decoded. A
+ *   LineIndex built in the background resolves line numbers, so a
+ *   20 GB log opens at once and jumps are exact as soon as the index
+ *   reaches them (estimated before that, marked with '~').
+ * - Pages are reported as pinned region lines, only rows that differ
+ *   from the last page are sent.
+ * - Keys follow less: space/b page, j/k line, d/u half page, g/G ends,
+ *   Ng line N, N% percent, /text and ?text literal search, n/N repeat,
+ *   :N line N, q quits.
+ * - Searches run on a worker thread and can be replaced by the next one,
+ *   the page keeps moving while a search scans gigabytes.
+ *
+ */
+class FilePager : public QObject {
+  Q_OBJECT
+
+public:
+  /*
+   * @brief Starts indexing the mapped file and shows the first page
+   *
+   * @param path File path, shown in the status line.
+   * @param file Mapping of the file, owned by the pager.
+   * @param rows Terminal rows, the last one is the status line.
+   * @param columns Terminal columns, lines are cut to this width.
+   */
+  FilePager(const QString &path, std::unique_ptr<MappedFile> file, int rows,
+            int columns, QObject *parent = nullptr);
+  ~FilePager();
+
+  /*
+   * @brief Goes to a line (0-based) before the first page is shown
+   */
+  void start(qint64 line);
+
+  void resize(int rows, int columns);
+
+  /*
+   * @brief Handles a key typed while the pager runs
+   *
+   * @param key Qt::Key code.
+   * @param text Text the key produced.
+   */
+  void keyPressed(int key, const QString &text);
+
+signals:
+  /*
+   * @brief The page changed
+   *
+   * @param lineCount Rows of the page, status line included.
+   * @param lines Changed rows.
+   */
+  void pageChanged(int lineCount, QList<WatchLine> lines);
+
+  /*
+   * @brief The user quit the pager
+   */
+  void finished();
+
+private:
+  void render();
+
+  /*
+   * @brief Line starting at offset, decoded and cut to the width
+   *
+   * @param next Set to the offset of the following line.
+   */
+  QString lineAt(std::size_t offset, std::size_t *next) const;
+
+  /*
+   * @brief Position, size and progress shown below the page
+   *
+   * @param end Offset after the last line on screen.
+   * @param textLines File lines on screen.
+   */
+  QString statusLine(std::size_t end, int textLines) const;
+  int pageLines() const;
+
+  std::size_t lineStart(std::size_t offset) const;
+  std::size_t nextLine(std::size_t offset) const;
+
+  /*
+   * @brief Offset of the first line of the last full page
+   */
+  std::size_t lastPage() const;
+  void scrollLines(qint64 delta);
+  void goToLine(qint64 line);
+  void goToPercent(double percent);
+  void goToEnd();
+
+  /*
+   * @brief Runs the typed search or ':' command
+   *
+   * @return false if the pager quit.
+   */
+  bool runCommand();
+  void search(bool forward);
+  void searchFinished(quint64 generation, qint64 offset);
+
+  QString path;                      // Shown in the status line
+  std::unique_ptr<MappedFile> file;  // Mapped file
+  std::unique_ptr<LineIndex> index;  // Line numbers, built in background
+  int rows;                          // Page height, status line included
+  int columns;                       // Line width
+  std::size_t top = 0;               // Offset of the first line on screen
+  QString count;                     // Numeric prefix being typed
+  QChar prompt;                      // '/', '?' or ':' while typing
+  QString input;                     // Text typed after the prompt
+  QString message;                   // Replaces the status once
+  QString pattern;                   // Last search text
+  QByteArray needle;                 // pattern in UTF-8
+  bool forwardSearch = true;         // Direction of the last search
+  QList<WatchLine> shown;            // Page as last reported
+  QTimer *timer;                     // Refreshes the status while indexing
+  QThreadPool pool;                  // Search worker
+  std::shared_ptr<std::atomic<bool>> cancel; // Stops the running search
+  quint64 searchGeneration = 0;      // Ignores results of replaced searches
+  bool searching = false;
+};
+
+#endif // FILE_PAGER_H
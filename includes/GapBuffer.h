@@ -0,0 +1,61 @@
+#ifndef GAP_BUFFER_H
+#define GAP_BUFFER_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/*
+ * @brief GapBuffer stores editable UTF-16 text with a gap at the cursor
+ *
+ * - Inserting and deleting at the cursor is O(1) amortized.
+ * - Moving the cursor moves the gap, O(distance).
+ *
+ */
+class GapBuffer {
+public:
+  explicit GapBuffer(std::size_t capacity = 64);
+
+  std::size_t size() const;
+
+  /*
+   * @brief Position of the gap (editing cursor)
+   */
+  std::size_t cursor() const;
+
+  char16_t at(std::size_t index) const;
+
+  /*
+   * @brief Moves the cursor, clamped to the text
+   */
+  void moveTo(std::size_t position);
+
+  /*
+   * @brief Inserts text at the cursor, the cursor moves past it
+   */
+  void insert(const char16_t *text, std::size_t length);
+
+  /*
+   * @brief Removes length code units starting at position
+   *
+   * The cursor ends at position.
+   */
+  void erase(std::size_t position, std::size_t length);
+
+  /*
+   * @brief Copy of length code units starting at position
+   */
+  std::u16string slice(std::size_t position, std::size_t length) const;
+
+  std::u16string text() const;
+  void clear();
+
+private:
+  void reserveGap(std::size_t length);
+
+  std::vector<char16_t> data; // Text before and after the gap
+  std::size_t gapStart = 0;   // First unit of the gap (cursor)
+  std::size_t gapEnd = 0;     // First unit after the gap
+};
+
+#endif // GAP_BUFFER_H
@@ -0,0 +1,104 @@
+#ifndef GLOB_H
+#define GLOB_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+/*
+ * @brief Pathname expansion: *, ?, [...], ** and {a,b} / {1..3}
+ *
+ * - Patterns are UTF-8 with backslash escapes, quoted characters of a
+ *   command word arrive escaped and never match as wildcards.
+ * - Each path segment is compiled once. Segments without wildcards are
+ *   plain names (no directory read), "prefix*suffix" segments compare
+ *   both ends only, anything else runs a backtracking matcher.
+ * - Every directory a segment applies to is read once. '**' walks the
+ *   tree on the parallel DirectoryWalker and, when one segment follows
+ *   it, matches that segment during the same walk.
+ * - Leading dots only match explicitly, '**' skips hidden directories.
+ * - Segments match like fnmatch(3) without flags, tests/GlobMatcherTest
+ *   checks it on random patterns.
+ *
+ */
+namespace Glob {
+
+/*
+ * @brief Compiled matcher for one path segment
+ */
+class Matcher {
+public:
+  explicit Matcher(const std::string &segment);
+
+  bool matches(const char *name, std::size_t length) const;
+  bool matches(const std::string &name) const {
+    return matches(name.data(), name.size());
+  }
+
+  /*
+   * @brief True if the segment has no wildcards, see literal()
+   */
+  bool isLiteral() const;
+  const std::string &literal() const;
+
+  /*
+   * @brief True if names starting with '.' may match
+   */
+  bool matchesHidden() const;
+
+private:
+  struct Token {
+    enum Type { Literal, Any, Star, Class };
+
+    Type type = Literal;
+    std::string text;                                // Literal
+    std::vector<std::pair<char32_t, char32_t>> ranges; // Class
+    bool negated = false;                            // Class
+    std::size_t unknownClass = std::string::npos; // Class: ranges before an
+                                                  // unknown [:name:]
+  };
+
+  enum Kind { Exact, PrefixSuffix, General };
+
+  bool classMatches(const Token &token, char32_t codePoint) const;
+
+  Kind kind = Exact;
+  std::string prefix; // Exact: whole name, PrefixSuffix: text before '*'
+  std::string suffix; // PrefixSuffix: text after '*'
+  std::vector<Token> tokens;
+  bool hidden = false;
+  bool valid = true; // false for patterns fnmatch rejects, they match nothing
+};
+
+/*
+ * @brief True if pattern has an unescaped *, ? or [
+ */
+bool hasWildcards(const std::string &pattern);
+
+/*
+ * @brief Expands unescaped braces: a{b,c}d -> abd acd, {1..3} -> 1 2 3
+ *
+ * Braces without a comma or range stay as they are ({} for find -exec).
+ */
+std::vector<std::string> expandBraces(const std::string &pattern);
+
+/*
+ * @brief Removes the backslash escapes
+ */
+std::string unescape(const std::string &pattern);
+
+/*
+ * @brief Calls visitor with every path matching pattern, in byte order
+ *
+ * The matches are all collected, sorted and deduplicated first, the
+ * visitor only saves the caller a second copy.
+ *
+ * @return Number of matches.
+ */
+std::size_t expand(const std::string &pattern,
+                   const std::function<void(const std::string &)> &visitor);
+
+} // namespace Glob
+
+#endif // GLOB_H
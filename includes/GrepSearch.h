@@ -0,0 +1,142 @@
+#ifndef GREP_SEARCH_H
+#define GREP_SEARCH_H
+
+#include "DirectoryWalker.h"
+#include "OutputSpan.h"
+#include <QList>
+#include <QObject>
+#include <QRegularExpression>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <atomic>
+
+class QThread;
+
+/*
+ * @brief Options of the grep builtin
+ */
+struct GrepOptions {
+  bool ignoreCase = false;       // -i
+  bool invert = false;           // -v
+  bool lineNumbers = false;      // -n
+  bool countOnly = false;        // -c
+  bool filesWithMatches = false; // -l
+  bool recursive = false;        // -r
+  bool followLinks = false;      // -R
+  bool fixedStrings = false;     // -F
+  bool extendedRegexp = false;   // -E (-G for basic)
+  bool wordRegexp = false;       // -w
+  int fileNames = -1;            // -H (1), -h (0), automatic (-1)
+};
+
+/*
+ * @brief GrepSearch runs an in-process grep over files and directories
+ *
+ * - Literal patterns use the SIMD first/last byte prefilter (TextScan).
+ * - Other patterns are POSIX basic (extended with -E) regexps, rewritten
+ *   for QRegularExpression (PCRE2, JIT).
+ * - Directories (-r) are enumerated by the parallel DirectoryWalker.
+ * - Files are mmapped and split into chunks searched on a thread pool,
+ *   chunk edges are moved to line boundaries.
+ * - Results are emitted in file and line order, with match and label
+ *   ranges ready for highlighting.
+ * - The search runs on its own thread, the event loop stays responsive
+ *   and Ctrl+C can stop it.
+ *
+ */
+class GrepSearch : public QObject {
+  Q_OBJECT
+
+public:
+  GrepSearch(const QString &pattern, const GrepOptions &options,
+             QObject *parent = nullptr);
+
+  /*
+   * @brief Cancels a running search and waits for its workers
+   */
+  ~GrepSearch();
+
+  /*
+   * @brief Starts searching files and (with -r) directories
+   *
+   * @param paths Files and directories to search.
+   */
+  void start(const QStringList &paths);
+
+signals:
+  void matchesReady(QString output, QList<OutputSpan> highlights);
+  void searchError(QString error);
+
+  /*
+   * @brief Emitted once the search completed
+   *
+   * @param exitCode 0 if a line was selected, 1 if none, 2 on errors.
+   */
+  void finished(int exitCode);
+
+private:
+  // Part of a file searched by one pool task
+  struct Task {
+    QString fileName;
+    qint64 begin = 0;
+    qint64 end = 0;
+    bool lastOfFile = true;
+  };
+
+  // Selected line, text already converted, spans relative to the line
+  struct LineMatch {
+    qint64 line = 0; // line number relative to the chunk start
+    QString text;
+    QList<OutputSpan> spans;
+  };
+
+  struct ChunkResult {
+    QList<LineMatch> matches;
+    qint64 selected = 0; // selected lines (for -c / -l)
+    qint64 newlines = 0; // lines in chunk (for -n of later chunks)
+    bool binary = false; // NUL byte in the first 8 KB of the file
+    QString error;
+    bool done = false;
+  };
+
+  /*
+   * @brief Searches on the search thread, output is posted in order
+   *
+   * @return The exit status, see finished().
+   */
+  int run(const QStringList &paths);
+
+  /*
+   * @brief Posts output or an error to the thread of this object
+   *
+   * Posts are dropped once the search is deleted.
+   */
+  void report(const QString &output, const QList<OutputSpan> &highlights);
+  void reportError(const QString &error);
+
+  QList<Task> collectTasks(const QStringList &paths);
+  void searchChunk(const Task &task, ChunkResult &result) const;
+  void searchLiteral(const char *begin, const char *end,
+                     ChunkResult &result) const;
+  void searchRegex(const char *begin, const char *end,
+                   ChunkResult &result) const;
+  void addLine(ChunkResult &result, qint64 line, const char *start,
+               qint64 length, const QList<QPair<qint64, qint64>> &hits) const;
+
+  QString pattern;           // Pattern as typed
+  GrepOptions options;       // Search options
+  bool literal = false;      // Pattern searched as bytes
+  QByteArray needle;         // UTF-8 literal pattern
+  QString regexPattern;      // Pattern handed to QRegularExpression
+  QRegularExpression::PatternOptions regexOptions;
+  bool showFileNames = false; // Prefix lines with the file name
+  bool hadError = false;      // Some path could not be searched
+  int exitCode = 0;           // Status of the finished search
+  std::atomic<bool> cancelled{false}; // Stop requested
+  DirectoryWalker walker;     // Expands directories (-r)
+  QThreadPool pool;           // Chunk search workers
+  QThread *thread = nullptr;  // Runs the search
+};
+
+#endif // GREP_SEARCH_H
@@ -0,0 +1,106 @@
+#ifndef HEADLESS_SHELL_H
+#define HEADLESS_SHELL_H
+
+#include "ProcessManager.h"
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QTextStream>
+
+/*
+ * @brief HeadlessShell runs commands without a display server
+ *
+ * - Drives the same ProcessManager engine used by QShellUI.
+ * - Writes command output to stdout and errors to stderr.
+ * - Runs one command at a time, waiting for each to finish.
+ * - Runs whole scripts through the ScriptInterpreter (parsed once).
+ * - Used by `qshell -c "cmd"`, `qshell script.qsh` and `qshell < script`.
+ *
+ */
+class HeadlessShell : public QObject {
+  Q_OBJECT
+
+public:
+  explicit HeadlessShell(QObject *parent = nullptr);
+  ~HeadlessShell();
+
+  /*
+   * @brief Runs a single command line and waits for it to complete
+   *
+   * @param commandLine The command to run.
+   *
+   * @return The command exit status.
+   */
+  int runCommand(const QString &commandLine);
+
+  /*
+   * @brief Parses a whole script from input and runs it
+   *
+   * @param input Stream providing the script source.
+   *
+   * @return The script exit status.
+   */
+  int runScript(QTextStream &input);
+
+  /*
+   * @brief Runs a script file with positional parameters
+   *
+   * @param path Script file path.
+   * @param args Positional parameters ($1, $2, ...).
+   *
+   * @return The script exit status.
+   */
+  int runFile(const QString &path, const QStringList &args);
+
+private slots:
+  /*
+   * @brief Writes engine output to stdout
+   */
+  void writeOutput(QString output);
+
+  /*
+   * @brief Writes highlighted output, with ANSI colors on a terminal
+   */
+  void writeHighlightedOutput(QString output, QList<OutputSpan> highlights);
+
+  /*
+   * @brief Writes engine errors to stderr
+   */
+  void writeError(QString error);
+
+  /*
+   * @brief Redraws the changed lines of the pinned region (watch)
+   *
+   * On a terminal the cursor moves back over the region and rewrites only
+   * the changed lines, otherwise each update is written as a whole screen.
+   */
+  void updateRegion(int lineCount, QList<WatchLine> lines);
+
+  /*
+   * @brief Shows a status line (parallel) on stderr when it is a terminal
+   */
+  void showProgress(QString progress);
+
+  /*
+   * @brief Removes the status line before other output is written
+   */
+  void clearProgress();
+
+  /*
+   * @brief Ends a partially written output line and flushes both streams
+   */
+  void finishLine();
+
+private:
+  ProcessManager *processManager; // Shared command engine
+  QTextStream out;                // Standard output stream
+  QTextStream err;                // Standard error stream
+  int exitCode = 0;               // Status of the last command
+  bool atLineStart = true;        // Last output ended with a newline
+  bool colorOutput = false;       // stdout is a terminal
+  QStringList region;             // Lines of the pinned region on screen
+  bool progressOutput = false;    // stderr is a terminal
+  bool progressShown = false;     // Status line currently on screen
+};
+
+#endif // HEADLESS_SHELL_H
@@ -0,0 +1,62 @@
+#ifndef INPUT_LINE_H
+#define INPUT_LINE_H
+
+#include "PromptEngine.h"
+#include <QList>
+#include <QString>
+#include <QWidget>
+
+/*
+ * @brief InputLine draws the prompt and the command being typed
+ *
+ * - Sits below the output, separate from the terminal document, so a
+ *   keystroke repaints one line whatever the scrollback holds.
+ * - Columns come from TextWidth (monospace cells), long lines scroll
+ *   horizontally to keep the cursor in view and only their visible part
+ *   is drawn.
+ * - Only displays, editing happens in LineEditor.
+ *
+ */
+class InputLine : public QWidget {
+  Q_OBJECT
+
+public:
+  explicit InputLine(QWidget *parent = nullptr);
+
+  /*
+   * @brief Sets the prompt, empty while a command runs
+   */
+  void setPrompt(const QList<PromptPart> &parts);
+
+  /*
+   * @brief Sets the line text and cursor position (UTF-16 offset)
+   */
+  void setText(const QString &text, int cursor);
+
+  QSize sizeHint() const override;
+  QSize minimumSizeHint() const override;
+
+protected:
+  void paintEvent(QPaintEvent *event) override;
+
+private:
+  /*
+   * @brief Finds where the text on screen begins
+   *
+   * @param visibleColumns Columns that fit in the widget.
+   * @param firstColumn First visible column of the text (prompt excluded).
+   * @param start Set to the text offset of the first visible character.
+   * @param startColumn Set to the column of that character.
+   */
+  void visibleText(int visibleColumns, int firstColumn, int *start,
+                   int *startColumn) const;
+
+  QList<PromptPart> prompt; // Prompt drawn before the text
+  QString text;             // Line being edited
+  int cursor = 0;           // Cursor offset into text
+  int scrollColumn = 0;     // First visible column
+  int cursorColumns = 0;    // Columns of the text before the cursor
+  int textColumns = 0;      // Columns of the whole text
+};
+
+#endif // INPUT_LINE_H
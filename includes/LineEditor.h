@@ -0,0 +1,69 @@
+#ifndef LINE_EDITOR_H
+#define LINE_EDITOR_H
+
+#include "GapBuffer.h"
+#include <QString>
+#include <QStringList>
+
+/*
+ * @brief LineEditor edits the command line with readline commands
+ *
+ * - Text lives in a gap buffer, edits cost the same whatever the
+ *   scrollback holds.
+ * - Cursor motion steps over whole grapheme clusters.
+ * - Killed text goes to a kill ring: consecutive kills are joined,
+ *   yank-pop cycles through older kills after a yank.
+ *
+ * Method names follow the readline commands they implement.
+ */
+class LineEditor {
+public:
+  QString text() const;
+  int cursor() const;
+  bool isEmpty() const;
+
+  /*
+   * @brief Replaces the line, the cursor goes to the end
+   */
+  void setText(const QString &text);
+  void clear();
+
+  void insert(const QString &text);
+
+  void forwardChar();      // Right, Ctrl+F
+  void backwardChar();     // Left, Ctrl+B
+  void forwardWord();      // Ctrl+Right, Alt+F
+  void backwardWord();     // Ctrl+Left, Alt+B
+  void beginningOfLine();  // Home, Ctrl+A
+  void endOfLine();        // End, Ctrl+E
+
+  void deleteChar();         // Delete, Ctrl+D
+  void backwardDeleteChar(); // Backspace, Ctrl+H
+
+  void killLine();         // Ctrl+K, to the end of the line
+  void unixLineDiscard();  // Ctrl+U, to the start of the line
+  void unixWordRubout();   // Ctrl+W, previous whitespace separated word
+  void backwardKillWord(); // Alt+Backspace, previous word
+  void killWord();         // Alt+D, to the end of the word
+
+  void yank();    // Ctrl+Y, inserts the last kill
+  void yankPop(); // Alt+Y, replaces the yank with the previous kill
+
+private:
+  enum Command { Other, Kill, Yank };
+
+  void startCommand(Command command);
+  void kill(int start, int end, bool backward);
+  int nextCluster(int position) const;
+  int previousCluster(int position) const;
+  bool isWordChar(int position) const;
+
+  GapBuffer buffer;        // Line text
+  QStringList killRing;    // Most recent kill first
+  Command lastCommand = Other;
+  int yankStart = 0;       // Text inserted by the last yank
+  int yankLength = 0;
+  int yankIndex = 0;       // Kill ring entry of the last yank
+};
+
+#endif // LINE_EDITOR_H
@@ -0,0 +1,93 @@
+#ifndef LINE_INDEX_H
+#define LINE_INDEX_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * @brief LineIndex maps line numbers to offsets of a large file
+ *
+ * - Sparse: only the offset of every stride-th line is kept, a 20 GB log
+ *   needs a few MB. Lines in between are found scanning forward from the
+ *   nearest checkpoint over the mmapped data.
+ * - Built by a background thread reading the file in blocks of its own
+ *   (the mapping is only touched for the lines on screen), newlines are
+ *   counted with SIMD and only blocks holding a checkpoint are walked.
+ * - Usable at once: lookups past the indexed part are estimated from the
+ *   average line length so far and reported as inexact.
+ *
+ */
+class LineIndex {
+public:
+  static constexpr std::size_t stride = 1024;
+
+  /*
+   * @brief Starts indexing
+   *
+   * @param path File the background thread reads.
+   * @param data Mapping of the same file, used by lookups.
+   * @param size Bytes at data.
+   */
+  LineIndex(const std::string &path, const char *data, std::size_t size);
+
+  /*
+   * @brief Stops the background thread
+   */
+  ~LineIndex();
+
+  LineIndex(const LineIndex &) = delete;
+  LineIndex &operator=(const LineIndex &) = delete;
+
+  bool isComplete() const;
+
+  /*
+   * @brief Bytes indexed so far, from the start of the file
+   */
+  std::size_t indexedBytes() const;
+
+  /*
+   * @brief Lines of the file, estimated until the index is complete
+   */
+  std::size_t lineCount() const;
+
+  /*
+   * @brief Offset where a line (0-based) starts, size() past the end
+   *
+   * @param exact Set to false if the line is past the indexed part.
+   */
+  std::size_t lineOffset(std::size_t line, bool *exact = nullptr) const;
+
+  /*
+   * @brief Line (0-based) holding the byte at offset
+   *
+   * @param exact Set to false if the offset is past the indexed part.
+   */
+  std::size_t lineNumber(std::size_t offset, bool *exact = nullptr) const;
+
+private:
+  struct Checkpoint {
+    std::size_t line = 0;
+    std::size_t offset = 0;
+  };
+
+  void build(const std::string &path);
+  Checkpoint lastCheckpoint() const;
+  double bytesPerLine() const;
+
+  const char *data;
+  std::size_t size;
+  mutable std::mutex mutex;                // Guards checkpoints
+  std::vector<std::uint64_t> checkpoints;  // Offset of line k * stride
+  std::atomic<std::size_t> scannedBytes{0};
+  std::atomic<std::size_t> scannedLines{0}; // Newlines in scannedBytes
+  std::atomic<bool> complete{false};
+  std::atomic<bool> stopping{false};
+  std::thread builder;
+};
+
+#endif // LINE_INDEX_H
@@ -0,0 +1,60 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/*
+ * @brief MappedFile maps a whole file read-only into memory
+ *
+ * - Regular files are mmapped, nothing is copied.
+ * - Pipes and special files (no mmap support) are read into a buffer.
+ * - Empty files are valid with size() == 0.
+ * - Unmaps and closes on destruction.
+ *
+ */
+class MappedFile {
+public:
+  enum Access { Sequential, Random };
+
+  /*
+   * @brief Maps file at path
+   *
+   * @param path Local 8-bit encoded path.
+   * @param access Expected access pattern, passed to madvise.
+   */
+  explicit MappedFile(const char *path, Access access = Sequential);
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  /*
+   * @brief True if the file could be opened and read
+   */
+  bool isValid() const;
+
+  /*
+   * @brief errno of the failed open/read, 0 when valid
+   */
+  int error() const;
+
+  /*
+   * @brief True if path is a directory (open succeeds, reading does not)
+   */
+  bool isDirectory() const;
+
+  const char *data() const;
+  std::size_t size() const;
+
+private:
+  const char *mapping = nullptr; // mmapped region or fallback buffer data
+  std::size_t length = 0;        // bytes available at mapping
+  bool mapped = false;           // mapping must be munmapped
+  bool directory = false;        // path was a directory
+  int errorCode = 0;             // errno on failure
+  std::vector<char> buffer;      // fallback storage for unmappable files
+};
+
+#endif // MAPPED_FILE_H
@@ -0,0 +1,104 @@
+#ifndef OUTPUT_BLOCK_INDEX_H
+#define OUTPUT_BLOCK_INDEX_H
+
+#include <QList>
+#include <QString>
+#include <QtGlobal>
+
+/*
+ * @brief Record of one command and the output it produced
+ *
+ * Offsets are characters since the start of the session: document
+ * positions plus the text moved into the compressed scrollback, so they
+ * stay valid while lines move in and out of the document.
+ */
+struct OutputBlock {
+  QString command;
+  QString directory;      // Working directory relative output refers to
+  qint64 start = 0;       // Echoed command line
+  qint64 outputStart = 0; // First output line
+  qint64 end = 0;         // End of the output, outputStart if there is none
+  int exitCode = -1;      // -1 while the command runs
+  qint64 startTime = 0;   // Milliseconds since the epoch
+  qint64 endTime = 0;
+  qint64 bytes = 0;       // UTF-8 size of the output
+  bool folded = false;    // Output lines hidden
+};
+
+/*
+ * @brief OutputBlockIndex keeps the commands of a session in order
+ *
+ * - Blocks are appended as commands start, so they are sorted by offset
+ *   and lookups are binary searches.
+ * - The last block grows while its command produces output.
+ *
+ */
+class OutputBlockIndex {
+public:
+  /*
+   * @brief Starts the block of a command that was just echoed
+   *
+   * @param directory Working directory the command starts in.
+   *
+   * @return Index of the new block.
+   */
+  int begin(const QString &command, qint64 start, qint64 outputStart,
+            const QString &directory);
+
+  /*
+   * @brief The running command changed directory ('cd x && make')
+   */
+  void setDirectory(const QString &directory);
+
+  /*
+   * @brief Output of the running command now ends at end
+   *
+   * @param bytes UTF-8 size of the output added.
+   */
+  void extend(qint64 end, qint64 bytes);
+
+  /*
+   * @brief Completes the last block
+   */
+  void finish(int exitCode);
+
+  /*
+   * @brief Adds a complete block after the others (session restore)
+   */
+  void append(const OutputBlock &block);
+
+  int count() const;
+  const OutputBlock &block(int index) const;
+  void setFolded(int index, bool folded);
+  void clear();
+
+  /*
+   * @brief Block whose command line or output contains offset, -1 if none
+   */
+  int blockAt(qint64 offset) const;
+
+  /*
+   * @brief First block starting after offset, -1 if none
+   */
+  int next(qint64 offset) const;
+
+  /*
+   * @brief Last block starting before offset, -1 if none
+   */
+  int previous(qint64 offset) const;
+
+  /*
+   * @brief UTF-8 size of text without converting it
+   */
+  static qint64 utf8Length(const QString &text);
+
+private:
+  /*
+   * @brief Index of the first block starting after offset
+   */
+  int upperBound(qint64 offset) const;
+
+  QList<OutputBlock> blocks; // Sorted by start
+};
+
+#endif // OUTPUT_BLOCK_INDEX_H
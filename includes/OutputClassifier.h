@@ -0,0 +1,41 @@
+#ifndef OUTPUT_CLASSIFIER_H
+#define OUTPUT_CLASSIFIER_H
+
+#include "OutputSpan.h"
+#include <QList>
+#include <QString>
+
+/*
+ * @brief Finds meaningful parts of an output line for highlighting
+ *
+ * - URLs (http, https, ftp, file).
+ * - Source locations: 'src/main.cpp:42:7', 'path/file.py:12'.
+ * - Paths containing '/' that exist on disk (relative to cwd).
+ * - Error and warning keywords, the message of a compiler diagnostic.
+ *
+ * Pure and thread-safe, meant to run on a worker thread. Spans are sorted
+ * and never overlap.
+ */
+namespace OutputClassifier {
+
+/*
+ * @brief Classifies one line of output
+ *
+ * @param line Line text without the newline.
+ * @param cwd Directory relative paths are resolved against.
+ */
+QList<OutputSpan> classify(const QString &line, const QString &cwd);
+
+/*
+ * @brief File path of a Path or Location span, without line and column
+ *
+ * @param text Span text.
+ * @param cwd Directory relative paths are resolved against.
+ *
+ * @return Absolute path.
+ */
+QString filePath(const QString &text, const QString &cwd);
+
+} // namespace OutputClassifier
+
+#endif // OUTPUT_CLASSIFIER_H
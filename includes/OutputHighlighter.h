@@ -0,0 +1,84 @@
+#ifndef OUTPUT_HIGHLIGHTER_H
+#define OUTPUT_HIGHLIGHTER_H
+
+#include "OutputSpan.h"
+#include <QCache>
+#include <QList>
+#include <QSet>
+#include <QString>
+#include <QSyntaxHighlighter>
+#include <QThreadPool>
+#include <QTimer>
+#include <functional>
+
+class QTextBlock;
+class QTextEdit;
+
+/*
+ * @brief OutputHighlighter marks paths, URLs, diagnostics and errors
+ *
+ * - Only lines in or near the viewport are classified, on a worker thread.
+ * - Results are cached per line text and the directory its relative paths
+ *   refer to (LRU), lines that leave the cache are classified again when
+ *   they come back into view.
+ * - Formats are drawn over the text and never change the document.
+ *
+ */
+class OutputHighlighter : public QSyntaxHighlighter {
+  Q_OBJECT
+
+public:
+  explicit OutputHighlighter(QTextEdit *editor);
+  ~OutputHighlighter();
+
+  /*
+   * @brief Span under a viewport position
+   *
+   * @param position Point in viewport coordinates.
+   * @param span Set to the span found.
+   * @param text Set to the span text.
+   *
+   * @return false if there is no highlighted span at position.
+   */
+  bool spanAt(const QPoint &position, OutputSpan *span, QString *text) const;
+
+  /*
+   * @brief Sets how the directory of a line is found
+   *
+   * @param resolver Working directory for a document position, the
+   * current directory is used without one.
+   */
+  void setDirectoryResolver(std::function<QString(int position)> resolver);
+
+protected:
+  /*
+   * @brief Applies cached spans, lines not classified yet stay plain
+   */
+  void highlightBlock(const QString &text) override;
+
+private slots:
+  /*
+   * @brief Classifies uncached lines around the viewport
+   */
+  void classifyVisible();
+
+private:
+  void classified(const QStringList &keys,
+                  const QList<QList<OutputSpan>> &results);
+
+  QString directory(const QTextBlock &block) const;
+
+  /*
+   * @brief Cache key of a line: its directory and text
+   */
+  QString cacheKey(const QTextBlock &block) const;
+
+  QTextEdit *editor;                          // Highlighted terminal
+  std::function<QString(int)> directoryOf;    // Directory of a position
+  QCache<QString, QList<OutputSpan>> cache;   // Spans per line key (LRU)
+  QSet<QString> pending;                      // Line keys on the worker
+  QThreadPool pool;                           // Classifies lines
+  QTimer visibleTimer;                        // Coalesces scroll events
+};
+
+#endif // OUTPUT_HIGHLIGHTER_H
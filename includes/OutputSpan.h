@@ -0,0 +1,32 @@
+#ifndef OUTPUT_SPAN_H
+#define OUTPUT_SPAN_H
+
+#include <QList>
+#include <QMetaType>
+
+/*
+ * @brief Highlighted range of a command output chunk
+ *
+ * Offsets are QString (UTF-16) positions into the emitted text, so the
+ * display can format them without searching the text again.
+ */
+struct OutputSpan {
+  enum Role {
+    Match,     // search hit
+    Label,     // file name / line number prefix
+    Directory, // directory entry (ls)
+    Url,       // web link
+    Path,      // existing file or directory
+    Location,  // file:line[:column]
+    Error,     // error keyword or diagnostic message
+    Warning    // warning keyword or diagnostic message
+  };
+
+  int start = 0;
+  int length = 0;
+  Role role = Match;
+};
+
+Q_DECLARE_METATYPE(OutputSpan)
+
+#endif // OUTPUT_SPAN_H
@@ -0,0 +1,96 @@
+#ifndef PARALLEL_RUNNER_H
+#define PARALLEL_RUNNER_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+class ChildProcess;
+class QTimer;
+
+/*
+ * @brief ParallelRunner runs a command template once per input (parallel)
+ *
+ * - Up to `jobs` commands run at the same time through /bin/sh -c.
+ * - {} in a command word is replaced by the input, {.} by the input
+ *   without its extension and {/} by its file name. Without any of them
+ *   the input is appended. Every word is quoted, the shell sees the words
+ *   the user typed; a single word holding spaces is run as a command line
+ *   with only the inputs quoted.
+ * - Each job's stdout and stderr are buffered and reported in one piece
+ *   when it finishes, so the output of concurrent jobs never interleaves.
+ *   With keepOrder, jobs are reported in input order.
+ *
+ */
+class ParallelRunner : public QObject {
+  Q_OBJECT
+
+public:
+  ParallelRunner(const QStringList &command, const QStringList &inputs,
+                 int jobs, bool keepOrder, QObject *parent = nullptr);
+
+  /*
+   * @brief Kills the jobs that are still running
+   */
+  ~ParallelRunner();
+
+  void start();
+
+  /*
+   * @brief Command line run for input
+   */
+  static QString commandLine(const QStringList &command,
+                             const QString &input);
+
+signals:
+  /*
+   * @brief Complete output of one job
+   */
+  void jobFinished(QString output, QString error);
+
+  /*
+   * @brief Done / running counts and estimated time left, empty once done
+   */
+  void progressChanged(QString progress);
+
+  /*
+   * @brief All jobs finished
+   *
+   * @param failed Number of jobs that exited with a non-zero status
+   */
+  void finished(int failed);
+
+private:
+  struct Job {
+    QString input;
+    QString output;
+    QString error;
+    ChildProcess *child = nullptr;
+    bool done = false;
+  };
+
+  /*
+   * @brief Starts queued jobs while slots are free
+   */
+  void fillSlots();
+  void jobExited(int index, int exitCode);
+
+  void reportJob(Job &job);
+  void reportProgress();
+
+  QStringList command;     // Command words with {} placeholders
+  QList<Job> queue;        // One job per input
+  int jobs;                // Slots
+  bool keepOrder;          // Report in input order
+  int nextJob = 0;         // First job not started
+  int nextReport = 0;      // First job not reported (keepOrder)
+  int running = 0;
+  int done = 0;
+  int failed = 0;
+  QElapsedTimer clock;     // Time since start, for the estimate
+  QTimer *progressTimer;   // Refreshes the estimate between job exits
+};
+
+#endif // PARALLEL_RUNNER_H
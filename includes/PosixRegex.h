@@ -0,0 +1,30 @@
+#ifndef POSIX_REGEX_H
+#define POSIX_REGEX_H
+
+#include <QString>
+
+/*
+ * @brief POSIX regexps (GNU grep flavour) rewritten for QRegularExpression
+ *
+ * - Basic: \( \) \{ \} \| \+ \? are operators, their bare forms literals,
+ *   '^' and '$' anchor only at the ends of the pattern or a group.
+ * - A basic operator with nothing to repeat is a literal, an extended one
+ *   is ignored, or repeats the anchor before it. Repeated repetitions are
+ *   grouped, PCRE2 would read a*+ as possessive and a*? as lazy.
+ * - A backslash in a bracket expression is a literal, [=x=] and [.x.] are
+ *   left to PCRE2, which rejects them.
+ * - \< and \> are word starts and ends, \` and \' the ends of the line.
+ *
+ */
+namespace PosixRegex {
+
+/*
+ * @brief PCRE2 pattern matching what pattern matches in grep
+ *
+ * @param extended Extended syntax (grep -E), basic otherwise.
+ */
+QString toPcre(const QString &pattern, bool extended);
+
+} // namespace PosixRegex
+
+#endif // POSIX_REGEX_H
@@ -1,11 +1,27 @@
 #ifndef PROCESS_MANAGER_H
 #define PROCESS_MANAGER_H
 
+#include "OutputSpan.h"
+#include "ScriptAst.h"
+#include "WatchCommand.h"
+#include <QList>
 #include <QObject>
-#include <QProcess>
 #include <QString>
 #include <QStringList>
 
+class ChildProcess;
+class DirectoryIndex;
+class FileFollower;
+class FilePager;
+class GrepSearch;
+class ParallelRunner;
+class QEventLoop;
+class ScriptInterpreter;
+class SessionRecorder;
+class SessionReplay;
+class TreeWalk;
+struct WalkOptions;
+
 /*
  * @brief ProcessManager handles running processes
  *
@@ -36,6 +52,72 @@ class ProcessManager : public QObject {
    */
   bool commandIsValid(QString command);
 
+  /*
+   * @brief Exit status of the last finished command (0 on success)
+   */
+  int exitStatus() const;
+
+  /*
+   * @brief Sets the display width used for column layout (ls)
+   *
+   * @param columns Terminal columns, 0 if output is not a terminal.
+   */
+  void setTerminalColumns(int columns);
+
+  /*
+   * @brief Sets the display height used by the pager (view)
+   *
+   * @param rows Terminal rows, 0 if keys can't reach the engine.
+   */
+  void setTerminalRows(int rows);
+
+  /*
+   * @brief Passes a key to an interactive builtin (view)
+   *
+   * @param key Qt::Key code.
+   * @param text Text the key produced.
+   *
+   * @return false if no builtin takes keys.
+   */
+  bool keyPressed(int key, const QString &text);
+
+  /*
+   * @brief Script interpreter sharing this engine (variables, functions)
+   */
+  ScriptInterpreter *scriptInterpreter() const;
+
+  /*
+   * @brief Runs a builtin synchronously
+   *
+   * @param program The builtin name.
+   * @param args The arguments passed to the builtin.
+   *
+   * @return The builtin exit status, or -1 if program is not a builtin.
+   */
+  int runBuiltin(const QString &program, const QStringList &args);
+
+  /*
+   * @brief Runs an external program and waits for it to finish
+   *
+   * Output is forwarded through processOutputReady/processErrorReady while
+   * the program runs. Used by the script interpreter.
+   *
+   * @return The program exit status (127 if not found).
+   */
+  int runExternal(const QString &program, const QStringList &args);
+
+  /*
+   * @brief Enters a directory and records the visit for 'z'
+   *
+   * Emits directoryChanged, so the prompt and the output blocks follow.
+   *
+   * @param name Builtin or script name used in the error message.
+   * @param path Directory to enter.
+   *
+   * @return false if the directory could not be entered.
+   */
+  bool changeDirectory(const QString &name, const QString &path);
+
 /**
  * @brief Handles internal file system commands like mkdir, touch, etc.
  * 
@@ -104,14 +186,383 @@ bool handleMv(const QStringList &args);
  */
 bool handleCat(const QStringList &args);
 
+/*
+ * @brief Handles 'wc' command to count lines, words and bytes.
+ *
+ * Files are mmapped, newlines are counted with SIMD and large files are
+ * split across threads. Supports -l, -w and -c, other flags (-m, -L)
+ * leave it to the external wc.
+ *
+ * @param args Optional flags and filenames.
+ *
+ * @return true if the command was handled internally, false otherwise.
+ */
+bool handleWc(const QStringList &args);
+
+/*
+ * @brief Handles 'head' command to print the first lines of files.
+ *
+ * Supports -n N and -N (default 10 lines), other options (-c, -n -N)
+ * leave it to the external head.
+ *
+ * @param args Optional line count and filenames.
+ *
+ * @return true if the command was handled internally, false otherwise.
+ */
+bool handleHead(const QStringList &args);
+
+/*
+ * @brief Handles 'tail' command to print the last lines of files.
+ *
+ * Scans backward from the end of the mmapped file, -n +N prints from line
+ * N on. With -f keeps following the file (inotify) until interrupted.
+ * Other options (-c) leave it to the external tail.
+ *
+ * @param args Optional -n N / -n +N / -N / -f flags and filenames.
+ *
+ * @return true if the command was handled internally, false otherwise.
+ */
+bool handleTail(const QStringList &args);
+
+/*
+ * @brief Handles 'grep' command to search files for a pattern.
+ *
+ * Searches in-process on a thread pool, in the background until done or
+ * interrupted, literal patterns use a SIMD prefilter. Supports -i, -v,
+ * -n, -c, -l, -r, -R, -F, -E, -G, -w, -H, -h and one -e, other options
+ * and several patterns leave it to the external grep.
+ * Matches are emitted through processHighlightedOutputReady.
+ *
+ * @param args Flags, pattern and files or directories.
+ *
+ * @return true if the command was handled internally, false otherwise.
+ */
+bool handleGrep(const QStringList &args);
+
+/*
+ * @brief Handles 'du' command to summarize disk usage.
+ *
+ * Walks the trees on several threads in the background, hardlinked files
+ * are counted once. Supports -s, -h, -a, -c, -k and -d N, other options
+ * run the external du.
+ *
+ * @param args Optional flags and paths (default '.').
+ *
+ * @return true if the command was handled internally, false otherwise.
+ */
+bool handleDu(const QStringList &args);
+
+/*
+ * @brief Handles 'find' command to search directory trees.
+ *
+ * Uses the parallel walker, only -size needs per file metadata. Supports
+ * -name, -iname, -type f|d|l, -size [+-]N[ckMG], -maxdepth and -mindepth,
+ * other expressions run the external find. Results are printed in walk order.
+ *
+ * @param args Starting paths followed by tests.
+ *
+ * @return true if the command was handled internally, false otherwise.
+ */
+bool handleFind(const QStringList &args);
+
+/*
+ * @brief Handles 'cd' command to change the current working directory.
+ *
+ * Without arguments changes to the home directory.
+ *
+ * @param args Optional target directory.
+ *
+ * @return true if the command was handled internally, false otherwise.
+ */
+bool handleCd(const QStringList &args);
+
+/*
+ * @brief Handles 'pushd' command to enter a directory, keeping the old one.
+ *
+ * 'pushd DIR' pushes the current directory on the directory stack,
+ * 'pushd' alone swaps the top two and 'pushd +N' rotates entry N of
+ * 'dirs' to the top. Prints the stack.
+ *
+ * @param args Optional target directory or +N.
+ *
+ * @return true if the command was handled internally, false otherwise.
+ */
+bool handlePushd(const QStringList &args);
+
+/*
+ * @brief Handles 'popd' command to return to the directory on the stack.
+ *
+ * 'popd +N' removes entry N of 'dirs' instead. Prints the stack.
+ *
+ * @param args Optional +N.
+ *
+ * @return true if the command was handled internally, false otherwise.
+ */
+bool handlePopd(const QStringList &args);
+
+/*
+ * @brief Handles 'dirs' command to print the directory stack.
+ *
+ * The current directory comes first. -v numbers the entries one per
+ * line, -l prints full paths instead of '~' and -c clears the stack.
+ *
+ * @param args Optional flags.
+ *
+ * @return true if the command was handled internally, false otherwise.
+ */
+bool handleDirs(const QStringList &args);
+
+/*
+ * @brief Handles 'z' command to jump to a frequently used directory.
+ *
+ * Directories entered with cd, pushd, popd or z are ranked by frecency
+ * in a persistent index. 'z WORDS' enters the best directory matching
+ * the words, -l lists the matches with their scores and -x forgets the
+ * current directory.
+ *
+ * @param args Optional flags and query words.
+ *
+ * @return true if the command was handled internally, false otherwise.
+ */
+bool handleZ(const QStringList &args);
+
+/*
+ * @brief Handles 'echo' command to print its arguments.
+ *
+ * Supports -n to omit the trailing newline.
+ *
+ * @param args Words to print.
+ *
+ * @return true if the command was handled internally, false otherwise.
+ */
+bool handleEcho(const QStringList &args);
+
+/*
+ * @brief Handles 'ls' command to list directory contents.
+ *
+ * Lays names out in columns by display width (CJK, emoji, combining
+ * marks) when output goes to a terminal, one per line otherwise.
+ * Directories are emitted as highlighted spans. Supports -a, -A and -1,
+ * other flags (-l, -t, long options) leave it to the external ls.
+ *
+ * @param args Optional flags and paths (default '.').
+ *
+ * @return true if the command was handled internally, false otherwise.
+ */
+bool handleLs(const QStringList &args);
+
+/*
+ * @brief Handles 'record' command to record the session (asciicast v2).
+ *
+ * 'record FILE' starts writing output and command lines to FILE,
+ * 'record stop' closes it, 'record' alone shows the state.
+ *
+ * @param args FILE, 'stop' or nothing.
+ *
+ * @return true if the command was handled internally, false otherwise.
+ */
+bool handleRecord(const QStringList &args);
+
+/*
+ * @brief Handles 'replay' command to play a recording back as output.
+ *
+ * Plays at the recorded pace, -s N scales it and -f plays as fast as
+ * possible and prints the display throughput.
+ *
+ * @param args Optional -f / -s N flags and the recording.
+ *
+ * @return true if the command was handled internally, false otherwise.
+ */
+bool handleReplay(const QStringList &args);
+
+/*
+ * @brief Handles 'watch' command to re-run a command periodically.
+ *
+ * The output is shown in a pinned region that only repaints the lines
+ * that changed since the previous run. -n N sets the interval (default
+ * 2 seconds), -d highlights changed characters and -t hides the header.
+ * Runs until interrupted.
+ *
+ * @param args Optional flags and the command line.
+ *
+ * @return true if the command was handled internally, false otherwise.
+ */
+bool handleWatch(const QStringList &args);
+
+/*
+ * @brief Handles 'parallel' command to run a command once per input.
+ *
+ * Inputs come from '::: ARGS', ':::: FILES' (lines, '-' for standard
+ * input) or standard input. Runs -j N jobs at a time (default: one per
+ * core), each job's output is shown in one piece when it finishes, in
+ * input order with -k. A progress line with an estimate is reported
+ * while jobs run.
+ *
+ * @param args Optional flags, the command template and the inputs.
+ *
+ * @return true if the command was handled internally, false otherwise.
+ */
+bool handleParallel(const QStringList &args);
+
+/*
+ * @brief Handles 'view' (or 'less') command to page through a file.
+ *
+ * The file is mmapped and indexed by line in the background, only the
+ * page on screen is read, so huge files open at once. Keys follow less
+ * (space, b, j, k, g, G, N%, /text, n, q). +N starts at line N. Prints
+ * the file like cat when there is no screen to page on.
+ *
+ * @param args Optional +LINE and the file.
+ *
+ * @return true if the command was handled internally, false otherwise.
+ */
+bool handleView(const QStringList &args);
+
+/*
+ * @brief Handles 'trace' command to save the UI pipeline trace.
+ *
+ * 'trace dump FILE' writes the in-memory ring of trace events (pipe
+ * reads, output delivery, display, prompt, paint) as Chrome trace JSON
+ * for chrome://tracing or ui.perfetto.dev, 'trace clear' starts the
+ * next dump from now.
+ *
+ * @param args dump FILE, or clear.
+ *
+ * @return true if the command was handled internally, false otherwise.
+ */
+bool handleTrace(const QStringList &args);
+
+public slots:
+  /*
+   * @brief Interrupts the running command (Ctrl+C)
+   *
+   * Stops long running builtins like 'tail -f' or 'find' and sends SIGINT
+   * to the child process.
+   */
+  void interrupt();
+
 signals:
   void processOutputReady(QString output);
   void processErrorReady(QString error);
 
+  /*
+   * @brief Output with ranges to highlight (grep matches, file labels)
+   *
+   * @param output The output text
+   * @param highlights Ranges of output to highlight
+   */
+  void processHighlightedOutputReady(QString output,
+                                     QList<OutputSpan> highlights);
+
+  /*
+   * @brief Emitted once a command (builtin or child process) has completed
+   *
+   * @param exitCode The command exit status
+   */
+  void processFinished(int exitCode);
+
+  /*
+   * @brief Emitted after 'cd' changed the working directory
+   *
+   * @param path The new absolute working directory
+   */
+  void directoryChanged(QString path);
+
+  /*
+   * @brief Emitted when a command line ran 'exit' (or failed under 'set -e')
+   *
+   * @param exitCode The requested shell exit status
+   */
+  void shellExitRequested(int exitCode);
+
+  /*
+   * @brief Lines of the pinned output region changed (watch)
+   *
+   * The region starts on the first update and sits below all other output.
+   *
+   * @param lineCount Lines the region has now, rows past it are removed.
+   * @param lines Changed lines in increasing row order.
+   */
+  void pinnedRegionUpdated(int lineCount, QList<WatchLine> lines);
+
+  /*
+   * @brief The pinned region stopped updating, its text stays as output
+   */
+  void pinnedRegionClosed();
+
+  /*
+   * @brief Status line of a running builtin (parallel), empty to remove it
+   */
+  void progressChanged(QString progress);
+
 private:
-  QProcess *process;    // Process instance to run commands
+  /*
+   * @brief Reports builtin completion with the collected exit status
+   */
+  void finishBuiltin();
+
+  /*
+   * @brief Reports a builtin error message and sets a failing exit status
+   */
+  void builtinError(const QString &message);
+
+  /*
+   * @brief Completes a builtin that kept running after it returned
+   *
+   * @param exitCode The builtin exit status
+   */
+  void finishPendingBuiltin(int exitCode);
+
+  /*
+   * @brief Creates a pending background walk reporting through this engine
+   *
+   * @param name Builtin name used in error messages.
+   * @param options Walker options.
+   */
+  TreeWalk *startTreeWalk(const QString &name, const WalkOptions &options);
+
+  /*
+   * @brief Reports a child that could not be started
+   *
+   * @return 127 if the program was not found, 126 otherwise.
+   */
+  int reportStartFailure(const QString &program, int error);
+
+  /*
+   * @brief Runs a parsed command line in the script interpreter
+   */
+  void runScriptLine(const ScriptNodePtr &script);
+
+  /*
+   * @brief Prints the current directory followed by the directory stack
+   */
+  void printDirectoryStack(bool verbose, bool fullPaths);
+
+  /*
+   * @brief Removes the pager and its page
+   */
+  void closePager();
+
+  ChildProcess *process; // Process instance to run commands
+  ScriptInterpreter *interpreter; // Runs compound lines and .qsh scripts
   QString command;      // Stores user input command
   QString errorMessage; // Last error message
+  int lastExitCode = 0; // Exit status of the last finished command
+  int terminalColumns = 0; // Display width, 0 when not a terminal
+  int terminalRows = 0;    // Display height, 0 without key input
+  bool builtinPending = false;        // Builtin still running (tail -f)
+  QEventLoop *builtinLoop = nullptr;  // Script waiting on a pending builtin
+  FileFollower *follower = nullptr;   // Active 'tail -f'
+  TreeWalk *treeWalk = nullptr;       // Active 'du' / 'find'
+  GrepSearch *grep = nullptr;         // Active 'grep'
+  SessionReplay *replay = nullptr;    // Active 'replay'
+  WatchCommand *watch = nullptr;      // Active 'watch'
+  ParallelRunner *parallel = nullptr; // Active 'parallel'
+  FilePager *pager = nullptr;         // Active 'view'
+  SessionRecorder *recorder;          // Session recording ('record')
+  DirectoryIndex *directoryIndex;     // Frecency of visited directories
+  QStringList directoryStack;         // pushd / popd, top first
+  ChildProcess *foregroundChild = nullptr; // Script child (runExternal)
 };
 
 #endif // PROCESS_MANAGER_H
@@ -0,0 +1,60 @@
+#ifndef PROCESS_SPAWN_H
+#define PROCESS_SPAWN_H
+
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+/*
+ * @brief Low level child process launching used by ChildProcess
+ *
+ * - Executables are looked up in PATH once and cached, the cache is
+ *   dropped when PATH changes.
+ * - The environment block (envp) is built once and shared, it is rebuilt
+ *   only after environmentChanged().
+ * - Children start with posix_spawn (vfork semantics, no page table copy).
+ *
+ */
+namespace ProcessSpawn {
+
+/*
+ * @brief Finds the executable run for a command name
+ *
+ * Names containing '/' are checked as given.
+ *
+ * @return Path of the executable, empty if there is none.
+ */
+std::string resolveExecutable(const std::string &name);
+
+/*
+ * @brief Drops a cached lookup (the executable went away)
+ */
+void forgetExecutable(const std::string &name);
+
+/*
+ * @brief Marks the cached environment block as outdated
+ *
+ * Must be called after setenv/unsetenv (qputenv/qunsetenv).
+ */
+void environmentChanged();
+
+/*
+ * @brief Starts a child process
+ *
+ * stdin is /dev/null, stdout and stderr are the given fds. Signals
+ * ignored or blocked by the shell are reset for the child.
+ *
+ * @param path Resolved executable path.
+ * @param args Arguments, including argv[0].
+ * @param outputFd Descriptor for the child's stdout.
+ * @param errorFd Descriptor for the child's stderr.
+ * @param error Set to the errno on failure.
+ *
+ * @return The child pid, -1 on failure.
+ */
+pid_t spawn(const std::string &path, const std::vector<std::string> &args,
+            int outputFd, int errorFd, int *error);
+
+} // namespace ProcessSpawn
+
+#endif // PROCESS_SPAWN_H
@@ -0,0 +1,107 @@
+#ifndef PROMPT_ENGINE_H
+#define PROMPT_ENGINE_H
+
+#include "PromptSegment.h"
+#include <QElapsedTimer>
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QThreadPool>
+#include <memory>
+
+/*
+ * @brief Rendered piece of the prompt, ready to insert
+ */
+struct PromptPart {
+  QString text;
+  QString color;            // Empty for the terminal default
+  bool placeholder = false; // Asynchronous segment still computing
+};
+
+/*
+ * @brief PromptEngine builds the shell prompt from segments
+ *
+ * - prompt() returns at once: asynchronous segments show their cached
+ *   text, or a placeholder the first time.
+ * - Asynchronous segments render on a worker thread, promptUpdated() is
+ *   emitted when a shown segment changed.
+ * - Cached text is refreshed in the background after every command and
+ *   when a watched file (e.g. .git/index) changes.
+ *
+ */
+class PromptEngine : public QObject {
+  Q_OBJECT
+
+public:
+  explicit PromptEngine(QObject *parent = nullptr);
+  ~PromptEngine();
+
+  /*
+   * @brief Appends a segment, segments render in the order added
+   */
+  void addSegment(std::shared_ptr<PromptSegment> segment);
+
+  /*
+   * @brief Starts timing a command (duration segment)
+   */
+  void commandStarted();
+
+  /*
+   * @brief Records the command result and marks cached segments for refresh
+   *
+   * @param exitCode The command exit status
+   */
+  void commandFinished(int exitCode);
+
+  /*
+   * @brief Builds the prompt for a working directory without waiting
+   *
+   * @param cwd Absolute working directory.
+   */
+  QList<PromptPart> prompt(const QString &cwd);
+
+  /*
+   * @brief Latest parts of the last built prompt, including filled segments
+   */
+  QList<PromptPart> currentPrompt() const;
+
+  /*
+   * @brief Concatenated text of prompt parts
+   */
+  static QString plainText(const QList<PromptPart> &parts);
+
+signals:
+  /*
+   * @brief Emitted when an asynchronous segment of the current prompt
+   * changed, currentPrompt() has the new text
+   */
+  void promptUpdated();
+
+private slots:
+  /*
+   * @brief Marks segments depending on a watched file as outdated
+   */
+  void watchedPathChanged(const QString &path);
+
+private:
+  QString cacheKey(int index) const;
+  PromptPart partFor(int index, const QString &text) const;
+  void schedule(int index);
+  void segmentRendered(int index, const QString &key, const PromptValue &value);
+
+  QList<std::shared_ptr<PromptSegment>> segments; // Prompt layout
+  PromptContext context;                          // Current prompt state
+  QList<PromptPart> parts;                        // Current prompt
+  QHash<QString, QString> cache;                  // Async segment text
+  QSet<QString> stale;                  // Cached text needs a refresh
+  QSet<QString> rendering;              // Keys computing on the worker
+  QHash<QString, QSet<QString>> watchedKeys; // Watched file -> cache keys
+  QFileSystemWatcher watcher;           // Invalidates on file changes
+  QThreadPool pool;                     // Renders async segments
+  QElapsedTimer commandTimer;           // Measures command duration
+};
+
+#endif // PROMPT_ENGINE_H
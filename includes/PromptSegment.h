@@ -0,0 +1,138 @@
+#ifndef PROMPT_SEGMENT_H
+#define PROMPT_SEGMENT_H
+
+#include <QString>
+#include <QStringList>
+
+/*
+ * @brief State a prompt is rendered for
+ */
+struct PromptContext {
+  QString cwd;             // Absolute working directory
+  QString home;            // Home directory, shown as '~'
+  int exitCode = 0;        // Status of the last command
+  qint64 durationMs = -1;  // Run time of the last command, -1 if none ran
+};
+
+/*
+ * @brief Rendered segment text and the files it depends on
+ */
+struct PromptValue {
+  QString text;           // Empty hides the segment
+  QStringList watchPaths; // Changes to these invalidate the cached text
+};
+
+/*
+ * @brief One piece of the prompt (cwd, git branch, exit code, ...)
+ *
+ * - Synchronous segments render on the UI thread and must be cheap.
+ * - Asynchronous segments render on the prompt worker thread, their
+ *   cached text (or a placeholder) is shown until the result arrives.
+ * - Results are cached per cacheKey(), 'cd' changes the key.
+ *
+ */
+class PromptSegment {
+public:
+  virtual ~PromptSegment() = default;
+
+  /*
+   * @brief Unique name, used as the cache key prefix
+   */
+  virtual QString name() const = 0;
+
+  /*
+   * @brief Renders the segment, from the worker thread if isAsync()
+   */
+  virtual PromptValue render(const PromptContext &context) const = 0;
+
+  /*
+   * @brief True if render() is too slow for the UI thread
+   */
+  virtual bool isAsync() const { return false; }
+
+  /*
+   * @brief Key the rendered text is cached under
+   */
+  virtual QString cacheKey(const PromptContext &context) const {
+    return context.cwd;
+  }
+
+  /*
+   * @brief Text shown while an asynchronous segment is computed, called on
+   * the GUI thread so it must stay cheap
+   */
+  virtual QString placeholder(const PromptContext & /*context*/) const {
+    return QString();
+  }
+
+  /*
+   * @brief Text color, empty for the terminal default
+   */
+  virtual QString color() const { return "#11E3DF"; }
+};
+
+/*
+ * @brief Fixed text (user@host, separators, '$ ')
+ */
+class TextSegment : public PromptSegment {
+public:
+  TextSegment(const QString &name, const QString &text, const QString &color);
+
+  QString name() const override;
+  PromptValue render(const PromptContext &context) const override;
+  QString color() const override;
+
+private:
+  QString segmentName;
+  QString text;
+  QString textColor;
+};
+
+/*
+ * @brief Working directory with the home directory shown as '~'
+ */
+class DirectorySegment : public PromptSegment {
+public:
+  QString name() const override;
+  PromptValue render(const PromptContext &context) const override;
+};
+
+/*
+ * @brief Git branch and dirty marker: ' (main*)'
+ *
+ * The branch is read from .git/HEAD, the dirty state comes from
+ * 'git status' on the worker thread. Watches HEAD and index. The
+ * placeholder only shows inside a repository.
+ */
+class GitSegment : public PromptSegment {
+public:
+  QString name() const override;
+  PromptValue render(const PromptContext &context) const override;
+  bool isAsync() const override;
+  QString placeholder(const PromptContext &context) const override;
+  QString color() const override;
+};
+
+/*
+ * @brief Exit status of the last command if it failed: ' [1]'
+ */
+class StatusSegment : public PromptSegment {
+public:
+  QString name() const override;
+  PromptValue render(const PromptContext &context) const override;
+  QString cacheKey(const PromptContext &context) const override;
+  QString color() const override;
+};
+
+/*
+ * @brief Run time of the last command if it took a second or more: ' 2.4s'
+ */
+class DurationSegment : public PromptSegment {
+public:
+  QString name() const override;
+  PromptValue render(const PromptContext &context) const override;
+  QString cacheKey(const PromptContext &context) const override;
+  QString color() const override;
+};
+
+#endif // PROMPT_SEGMENT_H
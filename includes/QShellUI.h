@@ -1,17 +1,33 @@
 #ifndef QSHELLUI_H
 #define QSHELLUI_H
 
+#include "LineEditor.h"
+#include "OutputBlockIndex.h"
 #include "ProcessManager.h"
 #include <QMainWindow>
 #include <QString>
+#include <QTextCursor>
 #include <QTextEdit>
 #include <QVBoxLayout>
+
+class InputLine;
+class OutputHighlighter;
+class PromptEngine;
+class QLabel;
+class QTimer;
+class ScrollbackStore;
+class SessionSnapshot;
+struct PromptPart;
+struct ScrollbackChunk;
+struct SessionState;
+
 /**
  * @brief The QShellUI class creates a simple terminal emulator.
  *
- * - Uses a single QTextEdit to handle both input and output.
- * - Prevents backspacing past the prompt.
- * - Displays the command after Enter is pressed (without execution).
+ * - Output goes to a read-only QTextEdit.
+ * - The prompt and the command being typed live in a separate InputLine,
+ *   edited with readline keys through LineEditor.
+ * - Submitted commands are echoed into the output with their prompt.
  */
 class QShellUI : public QMainWindow {
   Q_OBJECT
@@ -51,7 +67,14 @@ private slots:
    *
    */
   void displayOutput(QString output);
-  void displayOutput(QString output, QString command);    // Used internally to handle ls command formatting
+
+  /*
+   * @brief Receives output with highlighted ranges (grep) from ProcessManager
+   *
+   * @param output The output text
+   * @param highlights Ranges to color, in increasing order
+   */
+  void displayHighlightedOutput(QString output, QList<OutputSpan> highlights);
 
   /*
    * @brief Recieves output error from ProcessManager*
@@ -60,16 +83,69 @@ private slots:
    */
    void displayError(QString error);
 
+  /*
+   * @brief Shows the next prompt once ProcessManager finished a command
+   *
+   * @param exitCode The command exit status
+   */
+  void commandFinished(int exitCode);
+
+  /*
+   * @brief Replaces the changed lines of the pinned region (watch)
+   *
+   * @param lineCount Lines the region has now
+   * @param lines Changed lines in increasing row order
+   */
+  void updatePinnedRegion(int lineCount, QList<WatchLine> lines);
+
+  /*
+   * @brief Leaves the pinned region as regular output
+   */
+  void closePinnedRegion();
+
+  /*
+   * @brief Shows the status line of a running builtin (parallel) in place
+   * of the prompt
+   */
+  void showProgress(QString progress);
+
+  /*
+   * @brief Redraws the live prompt after a slow segment (git) completed
+   */
+  void refreshPrompt();
+
+  /*
+   * @brief Brings back older output when the view reaches the top, and
+   * compresses what was brought back once it is at the bottom again
+   *
+   * @param value The scroll bar position
+   */
+  void scrollbackScrolled(int value);
+
+  /*
+   * @brief Writes a session snapshot in the background if anything changed
+   */
+  void saveSession();
+
+  /*
+   * @brief Refreshes the HUD from the trace events since the last tick
+   */
+  void updateHud();
 
 protected:
   /**
    * @brief Handles keyboard input to:
-   * - Prevent deleting past the prompt.
-   * - Detect when Enter is pressed to echo the command.
+   * - Edit the command line with readline keys.
+   * - Detect when Enter is pressed to run the command.
    * @param event The key event triggered by user input.
    */
   void keyPressEvent(QKeyEvent *event) override;
 
+  /*
+   * @brief Updates the terminal columns when the window is resized
+   */
+  void resizeEvent(QResizeEvent *event) override;
+
 private:
   /**
    * @brief Sets up the UI, creating a QTextEdit as the terminal.
@@ -103,14 +179,44 @@ private:
   QString createPrompt();
 
   /**
-   * @brief Displays a new shell prompt at the bottom of the terminal.
+   * @brief Shows a new shell prompt in the input line.
    */
   void displayShellPrompt();
 
-  /**
-   * @brief Handles user input and echoes it to the terminal.
+  /*
+   * @brief Inserts prompt parts with their colors at cursor
    */
-  void handleUserInput();
+  void insertPrompt(QTextCursor &cursor, const QList<PromptPart> &parts);
+
+  /*
+   * @brief Applies a readline key to the command line
+   *
+   * @return false if the key doesn't edit the line
+   */
+  bool editLine(QKeyEvent *event);
+
+  /*
+   * @brief Echoes the prompt and line into the output and runs it
+   */
+  void submitLine(const QString &line);
+
+  /*
+   * @brief Pastes text into the command line
+   *
+   * A single line is inserted in chunks between events, several lines
+   * are queued as commands (after a confirmation for many of them).
+   */
+  void pasteText(QString text);
+
+  /*
+   * @brief Inserts the next chunk of a large paste
+   */
+  void insertPasteChunk();
+
+  /*
+   * @brief Submits the next queued pasted command if the prompt is shown
+   */
+  void runPastedCommand();
 
   /*
    * @brief Clear screen by pushing output upward
@@ -118,27 +224,143 @@ private:
   void clearScreen(); 
 
   /*
-   * @brief Output parser to add destintion between directories and regular files
+   * @brief Tells ProcessManager how many columns and rows fit in the
+   * terminal
+   */
+  void updateTerminalSize();
+
+  /*
+   * @brief Moves the oldest lines into the compressed scrollback once the
+   * document grew past the hot window
+   */
+  void trimScrollback();
+
+  /*
+   * @brief Runs trimScrollback from the event loop, once per turn
+   *
+   * Restored output (search, scrolling up) is compressed again a chunk at
+   * a time, the view stays responsive.
+   */
+  void queueTrim();
+
+  /*
+   * @brief Inserts the newest cold chunk back at the top of the document
+   *
+   * @return Number of characters inserted, 0 if nothing was stored
+   */
+  int restoreScrollback();
+
+  /*
+   * @brief Asks for a text and finds it in the document or cold scrollback
+   */
+  void findInScrollback();
+
+  /*
+   * @brief Extends the block of the running command after output was added
+   */
+  void indexOutput(const QString &output);
+
+  /*
+   * @brief Session offset of the first visible character
+   */
+  qint64 viewTopOffset();
+
+  /*
+   * @brief Working directory of the output at a document position, the
+   * current one outside command blocks
+   */
+  QString directoryAt(int position) const;
+
+  /*
+   * @brief Cursor at the end of the regular output
+   *
+   * That is the end of the document, or the line above a pinned region.
+   */
+  QTextCursor outputCursor();
+
+  /*
+   * @brief Scrolls a command block to the top and shows its record
    *
-   * @param The output received after child process handles user command
+   * @param index Block index, beeps if negative
+   */
+  void showBlock(int index);
+
+  /*
+   * @brief Text between two session offsets, including the cold scrollback
+   */
+  QString sessionText(qint64 from, qint64 to);
+
+  /*
+   * @brief Copies the output of the last command to the clipboard
+   */
+  void copyLastOutput();
+
+  /*
+   * @brief Folds or unfolds the output of the command block in view
+   */
+  void toggleFold();
+
+  /*
+   * @brief Hides or shows the output lines of a block
    *
-   * @return The parsed and styled output
+   * @return false if none of its output is in the document
+   */
+  bool foldBlock(int index, bool folded);
+
+  /*
+   * @brief Scrollback, block index and working directory for a snapshot
+   */
+  SessionState sessionState();
+
+  /*
+   * @brief Restores the snapshot named by QSHELL_SESSION
+   */
+  void restoreSession();
+
+  /*
+   * @brief Opens the highlighted link or file at a viewport position
+   *
+   * @return false if there is nothing to open at position
+   */
+  bool openSpanAt(const QPoint &position);
+
+  /*
+   * @brief Shows or hides the frame time HUD (Ctrl + Shift + T)
    */
-  QString styleOutput(QString output);
+  void toggleHud();
 
-  QTextEdit *terminalArea; // Terminal display area (both input & output).
+  QTextEdit *terminalArea; // Terminal output area.
+  InputLine *inputLine;    // Prompt and command line below the output.
+  LineEditor editor;       // Command line being typed.
   QVBoxLayout *mainLayout; // Layout manager for UI elements.
-  ProcessManager *processManager; // ShellUI create a ProcessManager
-  QString lastCommand;            // Needed for displayOutput override which takes 2 args to handle ls command output formatting.
+  ProcessManager *processManager = nullptr; // ShellUI create a ProcessManager
   QString username;               // Stores the current system username.
   QString hostname;               // Stores the system hostname.
   QString homeDIR;                // Stores the home directory.
-  QString cwd;                    // Stores the current working directory.
   QString prompt;                 // Stores the generated prompt.
-  int promptPosition;        // Tracks where user input starts to prevent prompt
-                             // deletion.
-  bool isFirstPrompt = true; // Frist prompt flag to track displayShellPrompt
-                             // very first time been called.
+  PromptEngine *promptEngine;     // Builds prompts from (async) segments
+  OutputHighlighter *outputHighlighter; // Marks up output in view
+  ScrollbackStore *scrollback;    // Compressed output above the hot window
+  int hotLines = 10000;           // Lines kept uncompressed in the document
+  QString lastSearch;             // Last scrollback search text
+  bool trimQueued = false;        // trimScrollback waits on the event loop
+  bool commandRunning = false; // No prompt until the command finished
+  int regionLines = 0;         // Lines pinned by watch or view
+  QTextCursor regionStart;     // First pinned line, output goes above it
+  QString pendingPaste;        // Large paste being inserted
+  int pasteOffset = 0;         // Part of pendingPaste already inserted
+  QStringList pasteQueue;      // Pasted commands waiting for the prompt
+  OutputBlockIndex outputIndex; // One block per command
+  qint64 coldChars = 0;        // Characters in the compressed scrollback
+  SessionSnapshot *session = nullptr; // Snapshot file, null if disabled
+  int savedRevision = -1;      // Document revision of the last snapshot
+  QString savedDirectory;      // Working directory of the last snapshot
+  QLabel *hud = nullptr;       // Frame time overlay, null until shown
+  QTimer *hudTimer = nullptr;  // Refreshes the HUD while it is visible
+  quint64 hudPosition = 0;     // Trace events already counted by the HUD
+  qint64 hudTime = 0;          // Trace clock at the last HUD refresh
+  int hudQueue = 0;            // Output chunks shown since the last paint
+  qint64 hudBacklog = 0;       // Bytes left in the pipe at the last read
 };
 
 #endif // QSHELLUI_H
@@ -0,0 +1,77 @@
+#ifndef SCRIPT_AST_H
+#define SCRIPT_AST_H
+
+#include <QList>
+#include <QString>
+#include <memory>
+#include <vector>
+
+/*
+ * @brief Piece of a shell word, either literal text or a variable reference
+ *
+ * Quoting is kept per part so expansion knows which parts are subject to
+ * field splitting.
+ */
+struct WordPart {
+  enum Kind { Literal, Variable };
+
+  Kind kind = Literal;
+  QString text;        // literal text or variable name
+  bool quoted = false; // part came from inside quotes
+};
+
+/*
+ * @brief A shell word as written in the script, expanded at run time
+ */
+struct Word {
+  QList<WordPart> parts;
+};
+
+/*
+ * @brief NAME=value prefix of a simple command
+ */
+struct Assignment {
+  QString name;
+  Word value;
+};
+
+struct ScriptNode;
+using ScriptNodePtr = std::shared_ptr<const ScriptNode>;
+
+/*
+ * @brief Node of a parsed QShell script
+ *
+ * - Command: assignments and words of a simple command.
+ * - Sequence/Group: children run one after another.
+ * - AndList/OrList: children[1] runs depending on children[0] status.
+ * - Not: negates the status of children[0].
+ * - If: pairs of (condition, body) followed by an optional else body.
+ * - For: runs children[0] for each of words with `name` set.
+ * - While/Until: children[0] is the condition, children[1] the body.
+ * - Function: defines function `name` with body children[0].
+ */
+struct ScriptNode {
+  enum Type {
+    Command,
+    Sequence,
+    Group,
+    AndList,
+    OrList,
+    Not,
+    If,
+    For,
+    While,
+    Until,
+    Function
+  };
+
+  Type type = Command;
+  int line = 0;                       // source line for error messages
+  QString name;                       // loop variable or function name
+  QList<Assignment> assignments;      // Command prefix assignments
+  QList<Word> words;                  // Command words or For items
+  bool implicitArgs = false;          // For without 'in' iterates "$@"
+  std::vector<ScriptNodePtr> children; // nested nodes, see type
+};
+
+#endif // SCRIPT_AST_H
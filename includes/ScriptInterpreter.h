@@ -0,0 +1,154 @@
+#ifndef SCRIPT_INTERPRETER_H
+#define SCRIPT_INTERPRETER_H
+
+#include "ScriptAst.h"
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <optional>
+
+class ProcessManager;
+
+/*
+ * @brief ScriptInterpreter executes parsed QShell scripts (.qsh)
+ *
+ * - Walks the ScriptNode tree produced once by ScriptParser.
+ * - Keeps shell variables, functions and positional parameters.
+ * - Runs ProcessManager builtins in-process, without spawning.
+ * - Falls back to a child process for everything else.
+ * - Tracks exit status ($?), 'set -e', break/continue/return/exit.
+ * - A script run as a command (foo.qsh) keeps its variables, functions,
+ *   exports and directory to itself, 'source' runs in the session's.
+ *
+ */
+class ScriptInterpreter : public QObject {
+  Q_OBJECT
+
+public:
+  explicit ScriptInterpreter(ProcessManager *processManager,
+                             QObject *parent = nullptr);
+  ~ScriptInterpreter();
+
+  /*
+   * @brief Executes a parsed script tree
+   *
+   * @param script Root node from ScriptParser.
+   *
+   * @return Exit status of the last command run.
+   */
+  int run(const ScriptNodePtr &script);
+
+  /*
+   * @brief Parses and executes script source
+   *
+   * @param source Script text.
+   * @param name Value of $0 while running.
+   * @param args Positional parameters ($1, $2, ...).
+   *
+   * @return Exit status, 2 on syntax errors.
+   */
+  int runSource(const QString &source, const QString &name = "qshell",
+                const QStringList &args = {});
+
+  /*
+   * @brief Reads, parses and executes a script file
+   *
+   * Runs with a state of its own, restored afterwards (see above).
+   *
+   * @param path Script file path.
+   * @param args Positional parameters ($1, $2, ...).
+   *
+   * @return Exit status, 127 if the file can not be read.
+   */
+  int runFile(const QString &path, const QStringList &args = {});
+
+  /*
+   * @brief Expands the words of a simple command into its arguments
+   */
+  QStringList expandArguments(const ScriptNode &command);
+
+  /*
+   * @brief Checks if a command name is handled by the interpreter itself
+   *
+   * True for script builtins (test, exit, export, ...), defined functions
+   * and .qsh script files.
+   */
+  bool isInternalCommand(const QString &name) const;
+
+  /*
+   * @brief True once 'exit' ran at top level in the last run
+   */
+  bool exitRequested() const;
+
+  /*
+   * @brief Exit status of the last command run ($?)
+   */
+  int exitStatus() const;
+
+  /*
+   * @brief Reads a shell variable, falling back to the environment
+   */
+  QString variable(const QString &name) const;
+
+  /*
+   * @brief Sets a shell variable (updates the environment if exported)
+   */
+  void setVariable(const QString &name, const QString &value);
+
+signals:
+  /*
+   * @brief Emitted for interpreter errors (syntax, bad builtin usage)
+   */
+  void errorReady(QString error);
+
+private:
+  enum class Flow { Normal, Break, Continue, Return, Exit };
+
+  int execute(const ScriptNode &node);
+  int executeCommand(const ScriptNode &node);
+  int executeIf(const ScriptNode &node);
+  int executeFor(const ScriptNode &node);
+  int executeLoop(const ScriptNode &node);
+  int executeCondition(const ScriptNode &node);
+  int dispatch(QStringList argv);
+  int callFunction(const QString &name, const QStringList &args);
+  int runScriptFile(const QString &path, const QStringList &args,
+                    bool sourced);
+  bool loopShouldStop();
+
+  // Script builtins
+  int runScriptBuiltin(const QString &name, const QStringList &args,
+                       bool *handled);
+  int runTest(QStringList args, bool bracket);
+  int runFlowBuiltin(const QString &name, const QStringList &args);
+  int runExport(const QStringList &args);
+  int runLocal(const QStringList &args);
+  int runSet(const QStringList &args);
+
+  // Expansion
+  QStringList expandWord(const Word &word) const;
+  QStringList expandGlob(const QString &pattern) const;
+  QString expandWordToString(const Word &word) const;
+
+  void reportError(const QString &message);
+
+  ProcessManager *processManager; // Runs builtins and child processes
+  QHash<QString, QString> variables;            // Shell variables
+  QSet<QString> exported;                       // Variables passed to children
+  QHash<QString, ScriptNodePtr> functions;      // Defined functions
+  QList<QHash<QString, std::optional<QString>>> localFrames; // Saved values
+  QStringList positional;                       // $1, $2, ...
+  QString scriptName = "qshell";                // $0
+  Flow flow = Flow::Normal; // Pending control flow change
+  int flowLevels = 0;       // Loops left to unwind for break/continue N
+  int loopDepth = 0;        // Nesting of running loops
+  int functionDepth = 0;    // Nesting of running functions
+  int sourceDepth = 0;      // Nesting of sourced files
+  int conditionDepth = 0;   // >0 while evaluating a condition ('set -e')
+  bool errexit = false;     // 'set -e' active
+  int lastStatus = 0;       // $?
+};
+
+#endif // SCRIPT_INTERPRETER_H
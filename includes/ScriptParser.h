@@ -0,0 +1,95 @@
+#ifndef SCRIPT_PARSER_H
+#define SCRIPT_PARSER_H
+
+#include "ScriptAst.h"
+#include <QList>
+#include <QSet>
+#include <QString>
+
+/*
+ * @brief ScriptParser turns QShell script source into a ScriptNode tree
+ *
+ * - Words with single/double quotes, backslash escapes and $VAR / ${VAR}.
+ * - Command lists with ';', newlines, '&&', '||' and '!'.
+ * - if/elif/else/fi, for/in/do/done, while and until loops.
+ * - Functions as `name() { ... }` or `function name { ... }`.
+ *
+ * Scripts are parsed once and the tree is executed by ScriptInterpreter.
+ */
+class ScriptParser {
+public:
+  /*
+   * @brief Parses script source into a tree
+   *
+   * @param source Script text.
+   * @param errorMessage Receives the syntax error, if any.
+   *
+   * @return Root node, or nullptr on syntax error.
+   */
+  static ScriptNodePtr parse(const QString &source,
+                             QString *errorMessage = nullptr);
+
+  /*
+   * @brief Checks if source only fails because it ended too early
+   *
+   * An open quote, if/for/while without its closing word or a trailing
+   * '&&' need more lines, like the continuation prompt of a shell.
+   */
+  static bool isIncomplete(const QString &source);
+
+  /*
+   * @brief Checks if text is a valid variable name
+   */
+  static bool isValidName(const QString &name);
+
+private:
+  struct Token {
+    enum Type { WordToken, Operator, Newline, End };
+
+    Type type = End;
+    QString text;       // operator text or plain word text
+    Word word;          // parsed word parts
+    bool plain = false; // word has no quoting or expansions
+    int line = 0;
+  };
+
+  explicit ScriptParser(const QString &source);
+
+  // Lexer
+  bool tokenize();
+  bool readWord(Token &token);
+  bool readVariable(Word &word, bool quoted);
+  static void appendLiteral(Word &word, QChar character, bool quoted);
+
+  // Parser
+  ScriptNodePtr parseList(const QSet<QString> &terminators);
+  ScriptNodePtr parseAndOr();
+  ScriptNodePtr parsePipeline();
+  ScriptNodePtr parseCommand();
+  ScriptNodePtr parseSimpleCommand();
+  ScriptNodePtr parseIf();
+  ScriptNodePtr parseFor();
+  ScriptNodePtr parseLoop(ScriptNode::Type type);
+  ScriptNodePtr parseGroup();
+  ScriptNodePtr parseFunction();
+
+  // Token helpers
+  const Token &peek(int offset = 0) const;
+  Token take();
+  bool peekOperator(const QString &op, int offset = 0) const;
+  bool peekReserved(const QString &word) const;
+  bool peekAnyReserved(const QSet<QString> &words) const;
+  bool expectReserved(const QString &word);
+  void skipNewlines();
+  ScriptNodePtr fail(const QString &message);
+
+  QString source;      // script text
+  int position = 0;    // lexer position in source
+  int line = 1;        // lexer line
+  QList<Token> tokens; // lexed tokens ending with End
+  int current = 0;     // parser position in tokens
+  QString error;       // first syntax error
+  bool incomplete = false; // error is the end of the source
+};
+
+#endif // SCRIPT_PARSER_H
@@ -0,0 +1,132 @@
+#ifndef SCROLLBACK_STORE_H
+#define SCROLLBACK_STORE_H
+
+#include <QByteArray>
+#include <QCache>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QThreadPool>
+
+/*
+ * @brief Formatted range of scrollback text
+ */
+struct ScrollbackRun {
+  int start = 0;
+  int length = 0;
+  quint32 color = 0; // ARGB foreground, 0 for the default color
+  bool bold = false;
+};
+
+/*
+ * @brief Lines moved out of the terminal document, with their formatting
+ */
+struct ScrollbackChunk {
+  QString text;              // Lines, each ending with '\n'
+  QList<ScrollbackRun> runs; // Formatted ranges in increasing order
+  int lines = 0;
+};
+
+/*
+ * @brief ScrollbackStore keeps old terminal output compressed in memory
+ *
+ * - The terminal hands over its oldest lines as chunks.
+ * - Each chunk is serialized and compressed (zlib, qCompress) on a pool
+ *   thread, the uncompressed copy is dropped once that finished.
+ * - Chunks are decompressed on demand, a small LRU keeps the last ones.
+ * - Chunks come back newest first, when scrolled to or found by search.
+ *
+ */
+class ScrollbackStore : public QObject {
+  Q_OBJECT
+
+public:
+  /*
+   * @param cachedChunks Decompressed chunks kept in the LRU.
+   */
+  explicit ScrollbackStore(int cachedChunks = 4, QObject *parent = nullptr);
+  ~ScrollbackStore();
+
+  /*
+   * @brief Stores a chunk as the newest one, compressing it in the background
+   */
+  void append(const ScrollbackChunk &chunk);
+
+  /*
+   * @brief Stores a chunk compressed by compressedChunk() as the newest one
+   *
+   * Used by session restore, the data is kept as it is.
+   */
+  void appendCompressed(const QByteArray &data, int lines, qint64 rawBytes);
+
+  /*
+   * @brief Chunk at index as stored (session snapshot)
+   *
+   * A chunk the worker hasn't compressed yet is compressed on the calling
+   * thread.
+   *
+   * @param lines Set to the lines of the chunk.
+   * @param rawBytes Set to the uncompressed text size in bytes.
+   */
+  QByteArray compressedChunk(int index, int *lines, qint64 *rawBytes) const;
+
+  /*
+   * @brief Removes and returns the newest chunk (to show it again)
+   */
+  ScrollbackChunk takeLast();
+
+  /*
+   * @brief Chunk at index (0 is the oldest), decompressed through the LRU
+   */
+  ScrollbackChunk chunk(int index);
+
+  /*
+   * @brief Searches chunks from the newest to the oldest
+   *
+   * @param text Text to find.
+   * @param caseSensitivity Case handling.
+   *
+   * @return Index of the newest chunk containing text, -1 if none.
+   */
+  int find(const QString &text, Qt::CaseSensitivity caseSensitivity);
+
+  /*
+   * @brief Drops all chunks (clear screen)
+   */
+  void clear();
+
+  int chunkCount() const;
+  qint64 lineCount() const;
+
+  /*
+   * @brief Bytes held in memory (compressed and not yet compressed chunks)
+   */
+  qint64 memoryUsage() const;
+
+  /*
+   * @brief Bytes the stored text takes uncompressed
+   */
+  qint64 rawSize() const;
+
+private:
+  struct StoredChunk {
+    quint64 id = 0;
+    QByteArray compressed;   // Empty until compression finished
+    ScrollbackChunk pending; // Kept until compressed
+    int lines = 0;
+    qint64 rawBytes = 0;
+  };
+
+  static QByteArray serialize(const ScrollbackChunk &chunk);
+  static ScrollbackChunk deserialize(const QByteArray &data);
+  void compressed(quint64 id, const QByteArray &data);
+  int indexOf(quint64 id) const;
+
+  QList<StoredChunk> chunks;               // Oldest first
+  QCache<quint64, ScrollbackChunk> recent; // Decompressed chunks (LRU)
+  QThreadPool pool;                        // Compression worker
+  quint64 nextId = 1;
+  qint64 lines = 0;
+};
+
+#endif // SCROLLBACK_STORE_H
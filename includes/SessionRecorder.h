@@ -0,0 +1,78 @@
+#ifndef SESSION_RECORDER_H
+#define SESSION_RECORDER_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QWaitCondition>
+#include <cstdio>
+
+class QThread;
+
+/*
+ * @brief SessionRecorder writes the output stream to an asciicast v2 file
+ *
+ * - Events are timestamped and queued by the caller, a writer thread
+ *   formats and writes them, so recording never blocks the display.
+ * - Errors are wrapped in red ANSI color, lines end with "\r\n" like a
+ *   terminal in raw mode: recordings play in asciinema players.
+ *
+ */
+class SessionRecorder {
+public:
+  SessionRecorder() = default;
+
+  /*
+   * @brief Flushes queued events and closes the file
+   */
+  ~SessionRecorder();
+
+  /*
+   * @brief Creates the recording and writes the header
+   *
+   * @param path File to write (replaced if it exists).
+   * @param width Terminal columns stored in the header.
+   * @param height Terminal rows stored in the header.
+   * @param error Set to the failure reason.
+   *
+   * @return false if the file could not be created.
+   */
+  bool start(const QString &path, int width, int height, QString *error);
+
+  /*
+   * @brief Writes the remaining events and closes the file
+   */
+  void stop();
+
+  bool isRecording() const;
+  QString path() const;
+
+  void recordOutput(const QString &text);
+  void recordError(const QString &text);
+
+  /*
+   * @brief Records a command line, shown like the prompt echoed it
+   */
+  void recordCommand(const QString &command);
+
+private:
+  struct Event {
+    double time = 0; // Seconds since start
+    QString data;    // Terminal output, already converted
+  };
+
+  void queue(const QString &data);
+  void writeEvents();
+
+  QString recordingPath;        // Current recording
+  std::FILE *file = nullptr;    // Written by the writer thread only
+  QThread *writer = nullptr;    // Formats and writes events
+  QElapsedTimer clock;          // Event timestamps
+  QMutex mutex;                 // Guards events and stopping
+  QWaitCondition wake;          // Wakes the writer
+  QList<Event> events;          // Queued events
+  bool stopping = false;        // Writer drains and exits
+};
+
+#endif // SESSION_RECORDER_H
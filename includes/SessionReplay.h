@@ -0,0 +1,82 @@
+#ifndef SESSION_REPLAY_H
+#define SESSION_REPLAY_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+
+/*
+ * @brief SessionReplay plays an asciicast v2 recording back as output
+ *
+ * - Output events are emitted like command output, so a replay goes
+ *   through the same display path as a live session.
+ * - Plays at the recorded pace (optionally scaled) or as fast as possible,
+ *   a fast replay reports its throughput (display benchmark).
+ * - Red wrapped events (recorded errors) come back as errors, other ANSI
+ *   control sequences are stripped.
+ *
+ */
+class SessionReplay : public QObject {
+  Q_OBJECT
+
+public:
+  explicit SessionReplay(QObject *parent = nullptr);
+
+  /*
+   * @brief Reads a recording
+   *
+   * @param path asciicast v2 file.
+   * @param error Set to the failure reason.
+   *
+   * @return false if the file is missing or not asciicast v2.
+   */
+  bool load(const QString &path, QString *error);
+
+  /*
+   * @brief Starts playing
+   *
+   * @param speed Pace multiplier, 0 plays as fast as possible.
+   */
+  void start(double speed);
+
+  /*
+   * @brief Summary of a finished fast replay (events, bytes, rate)
+   */
+  QString statistics() const;
+
+signals:
+  void outputReady(QString output);
+  void errorReady(QString error);
+
+  /*
+   * @brief Emitted after the last event
+   */
+  void finished();
+
+private slots:
+  /*
+   * @brief Emits the events that are due
+   */
+  void playDue();
+
+private:
+  struct Event {
+    double time = 0;
+    QString data;
+    bool error = false;
+  };
+
+  void emitEvent(const Event &event);
+
+  QList<Event> events;   // Recorded output in order
+  int next = 0;          // Next event to emit
+  double speed = 1;      // 0 for as fast as possible
+  qint64 bytes = 0;      // Emitted text size
+  qint64 elapsedMs = 0;  // Duration of the finished replay
+  QElapsedTimer clock;   // Replay time
+  QTimer timer;          // Wakes up for the next event
+};
+
+#endif // SESSION_REPLAY_H
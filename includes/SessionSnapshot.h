@@ -0,0 +1,86 @@
+#ifndef SESSION_SNAPSHOT_H
+#define SESSION_SNAPSHOT_H
+
+#include "OutputBlockIndex.h"
+#include "ScrollbackStore.h"
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QThreadPool>
+
+/*
+ * @brief Compressed scrollback chunk as ScrollbackStore keeps it
+ */
+struct SessionChunk {
+  QByteArray compressed;
+  int lines = 0;
+  qint64 rawBytes = 0; // Uncompressed text size
+};
+
+/*
+ * @brief What a terminal window brings back after a restart
+ */
+struct SessionState {
+  QString directory;         // Working directory
+  QList<SessionChunk> cold;  // Compressed scrollback, oldest first
+  qint64 coldChars = 0;      // Characters in the compressed scrollback
+  ScrollbackChunk hot;       // Document text with its formatting
+  QList<OutputBlock> blocks; // Command blocks
+};
+
+/*
+ * @brief SessionSnapshot saves a window's session to a file and reads it back
+ *
+ * - The file is a fixed header with a table of 8-byte aligned sections
+ *   of plain records (native byte order) and UTF-16 text, read in place
+ *   from an mmap: restoring copies, it never parses.
+ * - Cold scrollback is written as the zlib chunks ScrollbackStore already
+ *   holds, so the bulk of a million line session is neither compressed
+ *   on save nor decompressed on restore.
+ * - Periodic saves run on a worker thread, the file is replaced
+ *   atomically so a crash never leaves half a snapshot.
+ *
+ */
+class SessionSnapshot {
+public:
+  /*
+   * @param path Snapshot file.
+   */
+  explicit SessionSnapshot(const QString &path);
+
+  /*
+   * @brief Waits for a save in progress
+   */
+  ~SessionSnapshot();
+
+  /*
+   * @brief Writes the state in the background, a queued older save is
+   * dropped
+   */
+  void save(const SessionState &state);
+
+  /*
+   * @brief Writes the state and waits for it (on exit)
+   *
+   * @return false if the file could not be written.
+   */
+  bool saveNow(const SessionState &state, QString *error);
+
+  /*
+   * @brief Reads the snapshot
+   *
+   * @return false if there is none or it is damaged.
+   */
+  bool restore(SessionState *state, QString *error) const;
+
+  QString path() const;
+
+private:
+  static bool write(const QString &path, const SessionState &state,
+                    QString *error);
+
+  QString snapshotPath; // Snapshot file
+  QThreadPool pool;     // Background saves, one at a time
+};
+
+#endif // SESSION_SNAPSHOT_H
@@ -0,0 +1,55 @@
+#ifndef TEXT_SCAN_H
+#define TEXT_SCAN_H
+
+#include <cstddef>
+
+/*
+ * @brief Byte-level text scanning used by the wc, head and tail builtins
+ *
+ * - Newline counting uses AVX2 or SSE2 when the CPU supports it.
+ * - Large buffers are split across hardware threads.
+ * - Tail offsets are found scanning backward from the end.
+ * - Literal search filters candidates on first/last byte pairs with SIMD.
+ *
+ */
+namespace TextScan {
+
+/*
+ * @brief Counts '\n' bytes in a buffer on the calling thread
+ */
+std::size_t countNewlines(const char *data, std::size_t size);
+
+/*
+ * @brief Counts '\n' bytes, splitting buffers larger than a few MB across
+ * threads
+ */
+std::size_t countNewlinesParallel(const char *data, std::size_t size);
+
+/*
+ * @brief Counts whitespace separated words (same rules as wc -w)
+ */
+std::size_t countWords(const char *data, std::size_t size);
+
+/*
+ * @brief Length of the prefix holding the first `lines` lines
+ */
+std::size_t headLength(const char *data, std::size_t size, std::size_t lines);
+
+/*
+ * @brief Offset where the last `lines` lines start
+ *
+ * A trailing newline at the end of the buffer does not start a new line.
+ */
+std::size_t tailOffset(const char *data, std::size_t size, std::size_t lines);
+
+/*
+ * @brief Finds the first occurrence of needle in data
+ *
+ * @return Pointer to the match, or nullptr if not found.
+ */
+const char *findLiteral(const char *data, std::size_t size, const char *needle,
+                        std::size_t needleSize);
+
+} // namespace TextScan
+
+#endif // TEXT_SCAN_H
@@ -0,0 +1,98 @@
+#ifndef TEXT_WIDTH_H
+#define TEXT_WIDTH_H
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * @brief Display width and grapheme clusters for terminal column layout
+ *
+ * - Properties come from two-level tables built at compile time
+ *   (constexpr) from the Unicode ranges: no allocation, one indexed load
+ *   per lookup.
+ * - ASCII text never touches the tables.
+ * - Clusters follow the UAX #29 extended grapheme rules, a cluster takes
+ *   the width of its widest code point (emoji ZWJ sequences, Hangul jamo),
+ *   VS16 and flag pairs are 2 columns.
+ *
+ * Text is UTF-16 (QString::utf16()), so QShell and the Qt-free code share it.
+ */
+namespace TextWidth {
+
+/*
+ * @brief UAX #29 grapheme cluster break property
+ */
+enum GraphemeBreak : std::uint8_t {
+  Other,
+  CR,
+  LF,
+  Control,
+  Extend,
+  ZWJ,
+  RegionalIndicator,
+  Prepend,
+  SpacingMark,
+  L,
+  V,
+  T,
+  LV,
+  LVT,
+  ExtendedPictographic
+};
+
+/*
+ * @brief Packed table entry: width in bits 0-1, break property in bits 2-5
+ */
+std::uint8_t properties(char32_t codePoint);
+
+/*
+ * @brief Columns a code point takes (0, 1 or 2), controls take 0
+ */
+inline int codePointWidth(char32_t codePoint) {
+  if (codePoint < 0x7F) {
+    return codePoint >= 0x20 ? 1 : 0;
+  }
+  return properties(codePoint) & 0x3;
+}
+
+/*
+ * @brief Grapheme cluster break property of a code point
+ */
+inline GraphemeBreak graphemeBreak(char32_t codePoint) {
+  return GraphemeBreak(properties(codePoint) >> 2);
+}
+
+/*
+ * @brief End of the grapheme cluster starting at position
+ *
+ * @param text UTF-16 text.
+ * @param length Text length in code units.
+ * @param position Cluster start.
+ * @param width Set to the columns the cluster takes, if not null.
+ *
+ * @return Position after the cluster.
+ */
+std::size_t nextGrapheme(const char16_t *text, std::size_t length,
+                         std::size_t position, int *width = nullptr);
+
+/*
+ * @brief Columns text takes on a terminal grid
+ */
+int displayWidth(const char16_t *text, std::size_t length);
+
+/*
+ * @brief Longest prefix, ending on a cluster boundary, fitting in columns
+ *
+ * @param text UTF-16 text.
+ * @param length Text length in code units.
+ * @param columns Available columns.
+ * @param width Set to the columns the prefix takes, if not null.
+ *
+ * @return Prefix length in code units.
+ */
+std::size_t fitColumns(const char16_t *text, std::size_t length, int columns,
+                       int *width = nullptr);
+
+} // namespace TextWidth
+
+#endif // TEXT_WIDTH_H
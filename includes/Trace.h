@@ -0,0 +1,107 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * @brief Trace points of the output pipeline, kept in memory
+ *
+ * - Events go to a fixed ring of the last 65536, recording one is an
+ *   atomic increment and a few relaxed stores: no lock, no allocation,
+ *   cheap enough to stay compiled into release builds.
+ * - Readers (the HUD, the trace builtin) copy events out of the ring
+ *   while writers keep going, slots overwritten during the copy are
+ *   skipped.
+ * - The ring is written as Chrome trace JSON, chrome://tracing and
+ *   ui.perfetto.dev open it.
+ * - The QSHELL_TRACE_* macros compile to nothing unless the build sets
+ *   QSHELL_TRACING (CMake option, on by default). SCOPE traces a block,
+ *   NOW / SINCE a span crossing the event loop (a timer wait).
+ *
+ */
+namespace Trace {
+
+struct Event {
+  const char *name = nullptr; // String literal
+  std::int64_t start = 0;     // Nanoseconds since the first event
+  std::int64_t duration = -1; // Nanoseconds, -1 for a counter
+  std::int64_t value = 0;     // Size handled, or the counter value
+  std::uint32_t thread = 0;   // Small per-thread number, 1 comes first
+};
+
+/*
+ * @brief Monotonic clock, nanoseconds since the first call
+ */
+std::int64_t now();
+
+/*
+ * @brief Records a span that started at start and ends now
+ *
+ * @param name String literal, kept by pointer.
+ * @param value Size handled (bytes read, characters shown), an argument.
+ */
+void complete(const char *name, std::int64_t start, std::int64_t value = 0);
+
+/*
+ * @brief Records the value of a counter (queue depth)
+ */
+void counter(const char *name, std::int64_t value);
+
+/*
+ * @brief Copies the events recorded since position
+ *
+ * @param position 0 for everything still in the ring.
+ * @return Position to pass next time.
+ */
+std::uint64_t read(std::uint64_t position, std::vector<Event> *events);
+
+/*
+ * @brief Drops the events recorded so far from later dumps
+ */
+void clear();
+
+/*
+ * @brief Writes the events in the ring as Chrome trace JSON
+ *
+ * @return Events written, -1 if the file could not be written.
+ */
+long writeChromeTrace(const std::string &path, std::string *error);
+
+/*
+ * @brief Records the lifetime of a scope
+ */
+class Scope {
+public:
+  explicit Scope(const char *name) : name(name), start(now()) {}
+  ~Scope() { complete(name, start, value); }
+
+  Scope(const Scope &) = delete;
+  Scope &operator=(const Scope &) = delete;
+
+  void setValue(std::int64_t size) { value = size; }
+
+private:
+  const char *name;
+  std::int64_t start;
+  std::int64_t value = 0;
+};
+
+} // namespace Trace
+
+#ifdef QSHELL_TRACING
+#define QSHELL_TRACE_SCOPE(variable, name) Trace::Scope variable(name)
+#define QSHELL_TRACE_VALUE(variable, size) variable.setValue(size)
+#define QSHELL_TRACE_COUNTER(name, value) Trace::counter(name, value)
+#define QSHELL_TRACE_NOW() Trace::now()
+#define QSHELL_TRACE_SINCE(name, start) Trace::complete(name, start)
+#else
+#define QSHELL_TRACE_SCOPE(variable, name)
+#define QSHELL_TRACE_VALUE(variable, size) static_cast<void>(0)
+#define QSHELL_TRACE_COUNTER(name, value) static_cast<void>(0)
+#define QSHELL_TRACE_NOW() std::int64_t(0)
+#define QSHELL_TRACE_SINCE(name, start) static_cast<void>(start)
+#endif
+
+#endif // TRACE_H
@@ -0,0 +1,90 @@
+#ifndef TREE_WALK_H
+#define TREE_WALK_H
+
+#include "DirectoryWalker.h"
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+#include <functional>
+
+class QThread;
+
+/*
+ * @brief TreeWalk runs a DirectoryWalker in the background (du, find)
+ *
+ * - The walk runs on its own thread, the event loop stays responsive and
+ *   Ctrl+C can stop it.
+ * - Output appended by the visitors is emitted in batches.
+ * - Unreadable paths are reported as '<name>: '<path>': <reason>'.
+ *
+ */
+class TreeWalk : public QObject {
+  Q_OBJECT
+
+public:
+  /*
+   * @param name Builtin name used in error messages.
+   * @param options Walker options.
+   */
+  TreeWalk(const QString &name, const WalkOptions &options,
+           QObject *parent = nullptr);
+
+  /*
+   * @brief Cancels a running walk and waits for its workers
+   */
+  ~TreeWalk();
+
+  /*
+   * @brief Number of walker threads, visitors may keep per worker state
+   */
+  int threadCount() const;
+
+  /*
+   * @brief Starts walking roots
+   *
+   * @param roots Paths to walk.
+   * @param visitor Called on the walker threads for every entry.
+   * @param finish Called on the walk thread once a walk completed,
+   *               for summaries.
+   */
+  void start(const QStringList &roots, const DirectoryWalker::Visitor &visitor,
+             const std::function<void()> &finish = {});
+
+  /*
+   * @brief Queues output, safe to call from the walker threads
+   */
+  void appendOutput(const QString &output);
+
+signals:
+  void outputReady(QString output);
+  void errorReady(QString error);
+
+  /*
+   * @brief Emitted once the walk completed
+   *
+   * @param exitCode 0, or 1 if some path could not be read
+   */
+  void finished(int exitCode);
+
+private slots:
+  /*
+   * @brief Emits the output and errors queued so far
+   */
+  void flush();
+
+private:
+  void reportError(const std::string &path, int error);
+
+  QString name;                    // Builtin name for messages
+  DirectoryWalker walker;          // Parallel walk engine
+  QThread *thread = nullptr;       // Runs the walk
+  QTimer flushTimer;               // Batches output while walking
+  QMutex mutex;                    // Guards the queued text
+  QString pendingOutput;           // Output not emitted yet
+  QString pendingErrors;           // Errors not emitted yet
+  bool hadError = false;           // Some path could not be read
+};
+
+#endif // TREE_WALK_H
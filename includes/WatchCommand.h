@@ -0,0 +1,91 @@
+#ifndef WATCH_COMMAND_H
+#define WATCH_COMMAND_H
+
+#include "OutputSpan.h"
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+class ChildProcess;
+class QTimer;
+
+/*
+ * @brief Line of a pinned output region (watch)
+ */
+struct WatchLine {
+  int row = 0;                  // Line number inside the region
+  QString text;                 // Line text, without the newline
+  QList<OutputSpan> highlights; // Changed characters (watch -d)
+};
+
+/*
+ * @brief WatchCommand re-runs a command line on a timer (watch)
+ *
+ * - Runs the command through /bin/sh -c, stdout and stderr are collected
+ *   into one screen.
+ * - Each run is compared to the previous one line by line, only lines that
+ *   changed are reported, with the changed characters highlighted when
+ *   asked for.
+ * - The next run starts the interval after the previous one finished, so
+ *   a slow command never overlaps itself.
+ *
+ */
+class WatchCommand : public QObject {
+  Q_OBJECT
+
+public:
+  /*
+   * @brief Prepares the watch, start() runs the command the first time
+   *
+   * @param command Command line given to the shell.
+   * @param interval Seconds between runs.
+   * @param columns Lines are cut to this width, 0 keeps them whole.
+   * @param highlight Highlight changed characters.
+   * @param title Show the 'Every Ns: command' header line.
+   */
+  WatchCommand(const QString &command, double interval, int columns,
+               bool highlight, bool title, QObject *parent = nullptr);
+  ~WatchCommand();
+
+  void start();
+
+signals:
+  /*
+   * @brief Emitted after each run with the lines that changed
+   *
+   * @param lineCount Lines the region has now, rows past it are removed.
+   * @param lines Changed lines in increasing row order.
+   */
+  void regionUpdated(int lineCount, QList<WatchLine> lines);
+
+  void errorReady(QString error);
+
+private slots:
+  void run();
+  void runFinished(int exitCode);
+
+private:
+  /*
+   * @brief Header and output lines of the finished run
+   */
+  QStringList screen(int exitCode) const;
+
+  /*
+   * @brief Character ranges of line that differ from previous
+   */
+  static QList<OutputSpan> changedSpans(const QString &line,
+                                        const QString &previous);
+
+  QString command;         // Watched command line
+  int interval;            // Milliseconds between runs
+  int columns;             // Line width, 0 if unlimited
+  bool highlight;          // Highlight changed characters
+  bool title;              // Show the header line
+  ChildProcess *child = nullptr; // Running command
+  QTimer *timer;           // Starts the next run
+  QString output;          // Output of the running command
+  QStringList shown;       // Lines of the region as last reported
+};
+
+#endif // WATCH_COMMAND_H
@@ -0,0 +1,255 @@
+#include "ChildProcess.h"
+#include "ProcessSpawn.h"
+#include "Trace.h"
+#include <QFile>
+#include <QSocketNotifier>
+#include <QTimer>
+#include <cerrno>
+#include <climits>
+#include <csignal>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Exit polling interval on kernels without pidfd_open (before 5.3)
+static constexpr int exitPollInterval = 5;
+
+// Reads per notification, the event loop gets control back in between
+static constexpr int readsPerWakeup = 16;
+
+ChildProcess::ChildProcess(QObject *parent) : QObject(parent) {}
+
+ChildProcess::~ChildProcess() {
+  if (pid > 0) {
+    ::kill(pid, SIGKILL);
+    ::waitpid(pid, nullptr, 0);
+  }
+
+  closeAll();
+}
+
+bool ChildProcess::start(const QString &program, const QStringList &args) {
+  if (pid > 0) {
+    lastError = EBUSY;
+    return false;
+  }
+
+  std::string name = QFile::encodeName(program).toStdString();
+  std::vector<std::string> argv = {name};
+  for (const QString &arg : args) {
+    argv.push_back(arg.toLocal8Bit().toStdString());
+  }
+
+  int outputPipe[2];
+  int errorPipe[2];
+  if (::pipe2(outputPipe, O_CLOEXEC) != 0) {
+    lastError = errno;
+    return false;
+  }
+  if (::pipe2(errorPipe, O_CLOEXEC) != 0) {
+    lastError = errno;
+    ::close(outputPipe[0]);
+    ::close(outputPipe[1]);
+    return false;
+  }
+
+  // a cached lookup goes stale when the program is removed, retry once
+  pid_t child = -1;
+  int spawnError = ENOENT;
+  for (int attempt = 0; attempt < 2; attempt++) {
+    std::string path = ProcessSpawn::resolveExecutable(name);
+    if (path.empty()) {
+      spawnError = ENOENT;
+      break;
+    }
+
+    child = ProcessSpawn::spawn(path, argv, outputPipe[1], errorPipe[1],
+                                &spawnError);
+    if (child > 0 || spawnError != ENOENT) {
+      break;
+    }
+
+    ProcessSpawn::forgetExecutable(name);
+  }
+
+  // only the child writes to the pipes
+  ::close(outputPipe[1]);
+  ::close(errorPipe[1]);
+
+  if (child <= 0) {
+    ::close(outputPipe[0]);
+    ::close(errorPipe[0]);
+    lastError = spawnError;
+    return false;
+  }
+
+  pid = child;
+  lastError = 0;
+  outputFd = outputPipe[0];
+  errorFd = errorPipe[0];
+  ::fcntl(outputFd, F_SETFL, O_NONBLOCK);
+  ::fcntl(errorFd, F_SETFL, O_NONBLOCK);
+  outputDecoder.resetState();
+  errorDecoder.resetState();
+
+  outputNotifier = new QSocketNotifier(outputFd, QSocketNotifier::Read, this);
+  connect(outputNotifier, &QSocketNotifier::activated, this,
+          &ChildProcess::readOutput);
+
+  errorNotifier = new QSocketNotifier(errorFd, QSocketNotifier::Read, this);
+  connect(errorNotifier, &QSocketNotifier::activated, this,
+          &ChildProcess::readError);
+
+#ifdef SYS_pidfd_open
+  exitFd = int(::syscall(SYS_pidfd_open, pid, 0));
+#endif
+
+  if (exitFd >= 0) {
+    exitNotifier = new QSocketNotifier(exitFd, QSocketNotifier::Read, this);
+    connect(exitNotifier, &QSocketNotifier::activated, this,
+            &ChildProcess::checkExit);
+  } else {
+    exitPoll = new QTimer(this);
+    exitPoll->setInterval(exitPollInterval);
+    connect(exitPoll, &QTimer::timeout, this, &ChildProcess::checkExit);
+    exitPoll->start();
+  }
+
+  return true;
+}
+
+int ChildProcess::error() const { return lastError; }
+
+bool ChildProcess::isRunning() const { return pid > 0; }
+
+qint64 ChildProcess::processId() const { return pid > 0 ? pid : 0; }
+
+void ChildProcess::sendSignal(int signal) {
+  if (pid > 0) {
+    ::kill(pid, signal);
+  }
+}
+
+void ChildProcess::readOutput() {
+  QString output = readPipe(outputFd, outputNotifier, outputDecoder);
+  if (!output.isEmpty()) {
+    // connections are direct, this covers every slot down to the display
+    QSHELL_TRACE_SCOPE(scope, "ChildProcess::outputReady");
+    QSHELL_TRACE_VALUE(scope, output.size());
+    emit outputReady(output);
+  }
+}
+
+void ChildProcess::readError() {
+  QString error = readPipe(errorFd, errorNotifier, errorDecoder);
+  if (!error.isEmpty()) {
+    QSHELL_TRACE_SCOPE(scope, "ChildProcess::errorReady");
+    QSHELL_TRACE_VALUE(scope, error.size());
+    emit errorReady(error);
+  }
+}
+
+void ChildProcess::checkExit() {
+  if (pid <= 0) {
+    return;
+  }
+
+  int status = 0;
+  pid_t result = ::waitpid(pid, &status, WNOHANG);
+  if (result == 0 || (result < 0 && errno == EINTR)) {
+    return;
+  }
+
+  pid = -1;
+
+  // whatever the child wrote right before exiting is still in the pipes
+  readOutput();
+  readError();
+  closeAll();
+
+  int exitCode = 128;
+  if (result > 0 && WIFEXITED(status)) {
+    exitCode = WEXITSTATUS(status);
+  } else if (result > 0 && WIFSIGNALED(status)) {
+    exitCode = 128 + WTERMSIG(status);
+  }
+
+  emit finished(exitCode);
+}
+
+QString ChildProcess::readPipe(int &fd, QSocketNotifier *&notifier,
+                               QStringDecoder &decoder) {
+  QString text;
+  char buffer[65536];
+  QSHELL_TRACE_SCOPE(scope, "ChildProcess::read");
+  [[maybe_unused]] qint64 total = 0;
+
+  // after exit the pipe is drained completely
+  int reads = pid > 0 ? readsPerWakeup : INT_MAX;
+
+  while (fd >= 0 && reads-- > 0) {
+    ssize_t bytes = ::read(fd, buffer, sizeof(buffer));
+    if (bytes > 0) {
+      QSHELL_TRACE_SCOPE(decode, "ChildProcess::decode");
+      text += QString(decoder.decode(QByteArrayView(buffer, bytes)));
+      total += bytes;
+      continue;
+    }
+
+    if (bytes < 0 && errno == EINTR) {
+      continue;
+    }
+
+    if (bytes < 0 && errno == EAGAIN) {
+      break;
+    }
+
+    // end of file (or a broken pipe): nothing more will arrive
+    if (notifier) {
+      notifier->setEnabled(false);
+      notifier->deleteLater();
+      notifier = nullptr;
+    }
+    ::close(fd);
+    fd = -1;
+  }
+
+#ifdef QSHELL_TRACING
+  // bytes left for the next wakeup, if the read budget ran out
+  if (fd >= 0) {
+    int pending = 0;
+    if (reads < 0) {
+      ::ioctl(fd, FIONREAD, &pending);
+    }
+    Trace::counter("pipe backlog", pending);
+  }
+#endif
+  QSHELL_TRACE_VALUE(scope, total);
+  return text;
+}
+
+void ChildProcess::closeAll() {
+  for (QSocketNotifier **notifier :
+       {&outputNotifier, &errorNotifier, &exitNotifier}) {
+    if (*notifier) {
+      (*notifier)->setEnabled(false);
+      (*notifier)->deleteLater();
+      *notifier = nullptr;
+    }
+  }
+
+  for (int *fd : {&outputFd, &errorFd, &exitFd}) {
+    if (*fd >= 0) {
+      ::close(*fd);
+      *fd = -1;
+    }
+  }
+
+  if (exitPoll) {
+    exitPoll->stop();
+    exitPoll->deleteLater();
+    exitPoll = nullptr;
+  }
+}
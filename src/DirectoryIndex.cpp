@@ -0,0 +1,373 @@
+#include "DirectoryIndex.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <filesystem>
+#include <sys/file.h>
+#include <unistd.h>
+
+// File header, followed by count records
+struct DatabaseHeader {
+  char magic[4];
+  std::uint32_t count;
+};
+
+// Record header, followed by the path padded to 8 bytes
+struct DatabaseRecord {
+  std::int64_t time;
+  double rank;
+  std::uint32_t length;
+  std::uint32_t reserved;
+};
+
+static constexpr char databaseMagic[4] = {'Q', 'S', 'Z', '1'};
+
+// Ranks are aged once their sum passes this, like z
+static constexpr double maxRankSum = 9000;
+
+// Weight of a directory whose path has the query words in order but not
+// the last one in its last component, and of a fuzzy (subsequence) match
+static constexpr double substringWeight = 0.5;
+static constexpr double fuzzyWeight = 0.1;
+
+static std::size_t padded(std::size_t length) {
+  return (length + 7) & ~std::size_t(7);
+}
+
+static std::string folded(const std::string &text) {
+  std::string result = text;
+  for (char &c : result) {
+    c = char(std::tolower(static_cast<unsigned char>(c)));
+  }
+  return result;
+}
+
+// Rank weighted by the time since the last visit
+static double frecency(double rank, std::int64_t time, std::int64_t now) {
+  std::int64_t age = now - time;
+  if (age < 3600) {
+    return rank * 4;
+  }
+  if (age < 86400) {
+    return rank * 2;
+  }
+  if (age < 604800) {
+    return rank / 2;
+  }
+  return rank / 4;
+}
+
+// How well path matches the words, 0 if it does not
+static double matchWeight(const std::string &path,
+                          const std::vector<std::string> &words) {
+  if (words.empty()) {
+    return 1;
+  }
+
+  std::size_t lastComponent = path.rfind('/');
+  lastComponent = lastComponent == std::string::npos ? 0 : lastComponent + 1;
+
+  // words as substrings in order
+  std::size_t position = 0;
+  std::size_t lastFound = 0;
+  bool substrings = true;
+  for (const std::string &word : words) {
+    std::size_t found = path.find(word, position);
+    if (found == std::string::npos) {
+      substrings = false;
+      break;
+    }
+    lastFound = found;
+    position = found + word.size();
+  }
+
+  if (substrings) {
+    // the last word may also occur later, in the last component
+    const std::string &last = words.back();
+    std::size_t tail = path.rfind(last);
+    if (tail != std::string::npos && tail >= lastFound) {
+      lastFound = tail;
+    }
+    if (lastFound < lastComponent) {
+      return substringWeight;
+    }
+    return path.size() - lastComponent == last.size() ? 2 : 1;
+  }
+
+  // characters of every word in order, tighter spans weigh more
+  std::size_t characters = 0;
+  std::size_t start = std::string::npos;
+  position = 0;
+  for (const std::string &word : words) {
+    for (char c : word) {
+      std::size_t found = path.find(c, position);
+      if (found == std::string::npos) {
+        return 0;
+      }
+      if (start == std::string::npos) {
+        start = found;
+      }
+      position = found + 1;
+    }
+    characters += word.size();
+  }
+
+  return fuzzyWeight * double(characters) / double(position - start);
+}
+
+DirectoryIndex::DirectoryIndex(const std::string &path)
+    : databasePath(path), entries(load(path)) {}
+
+DirectoryIndex::~DirectoryIndex() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+    wake.notify_one();
+  }
+
+  if (writer.joinable()) {
+    writer.join();
+  }
+}
+
+std::string DirectoryIndex::defaultPath() {
+  std::string directory;
+  const char *data = std::getenv("XDG_DATA_HOME");
+  if (data && data[0] == '/') {
+    directory = data;
+  } else {
+    const char *home = std::getenv("HOME");
+    directory = std::string(home ? home : "") + "/.local/share";
+  }
+  return directory + "/qshell/dirs.db";
+}
+
+void DirectoryIndex::recordVisit(const std::string &directory) {
+  queue({directory, std::int64_t(std::time(nullptr))});
+}
+
+void DirectoryIndex::remove(const std::string &directory) {
+  queue({directory, 0});
+}
+
+std::vector<DirectoryIndex::Match>
+DirectoryIndex::query(const std::vector<std::string> &words,
+                      std::size_t limit) const {
+  // smart case: an upper case letter makes the whole query exact
+  bool exactCase = false;
+  for (const std::string &word : words) {
+    exactCase |= std::any_of(word.begin(), word.end(), [](char c) {
+      return std::isupper(static_cast<unsigned char>(c));
+    });
+  }
+
+  std::vector<std::string> needles;
+  for (const std::string &word : words) {
+    if (!word.empty()) {
+      needles.push_back(exactCase ? word : folded(word));
+    }
+  }
+
+  std::int64_t now = std::int64_t(std::time(nullptr));
+  std::vector<Match> matches;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  for (const Entry &entry : entries) {
+    double weight =
+        matchWeight(exactCase ? entry.path : entry.folded, needles);
+    if (weight > 0) {
+      matches.push_back(
+          {entry.path, weight * frecency(entry.rank, entry.time, now)});
+    }
+  }
+
+  std::sort(matches.begin(), matches.end(), [](const Match &a, const Match &b) {
+    return a.score != b.score ? a.score > b.score : a.path < b.path;
+  });
+  if (limit && matches.size() > limit) {
+    matches.resize(limit);
+  }
+  return matches;
+}
+
+void DirectoryIndex::flush() {
+  std::unique_lock<std::mutex> lock(mutex);
+  written.wait(lock, [this]() { return changes.empty() && !writing; });
+}
+
+std::vector<DirectoryIndex::Entry>
+DirectoryIndex::load(const std::string &path) {
+  std::vector<Entry> loaded;
+
+  MappedFile file(path.c_str());
+  if (!file.isValid() || file.size() < sizeof(DatabaseHeader)) {
+    return loaded;
+  }
+
+  DatabaseHeader header;
+  std::memcpy(&header, file.data(), sizeof(header));
+  if (std::memcmp(header.magic, databaseMagic, sizeof(databaseMagic)) != 0) {
+    return loaded;
+  }
+
+  // records are read in place, a truncated file keeps its complete ones;
+  // the count is not trusted further than the file can hold
+  std::size_t offset = sizeof(DatabaseHeader);
+  loaded.reserve(std::min<std::size_t>(
+      header.count, (file.size() - offset) / sizeof(DatabaseRecord)));
+  for (std::uint32_t i = 0; i < header.count; i++) {
+    if (file.size() - offset < sizeof(DatabaseRecord)) {
+      break;
+    }
+
+    DatabaseRecord record;
+    std::memcpy(&record, file.data() + offset, sizeof(record));
+    offset += sizeof(record);
+    if (file.size() - offset < record.length) {
+      break;
+    }
+
+    Entry entry;
+    entry.path.assign(file.data() + offset, record.length);
+    entry.folded = folded(entry.path);
+    entry.rank = record.rank;
+    entry.time = record.time;
+    loaded.push_back(std::move(entry));
+
+    offset += std::min(padded(record.length), file.size() - offset);
+  }
+
+  return loaded;
+}
+
+bool DirectoryIndex::save(const std::string &path,
+                          const std::vector<Entry> &entries) {
+  std::string data;
+  DatabaseHeader header;
+  std::memcpy(header.magic, databaseMagic, sizeof(databaseMagic));
+  header.count = std::uint32_t(entries.size());
+  data.append(reinterpret_cast<const char *>(&header), sizeof(header));
+
+  for (const Entry &entry : entries) {
+    DatabaseRecord record{entry.time, entry.rank,
+                          std::uint32_t(entry.path.size()), 0};
+    data.append(reinterpret_cast<const char *>(&record), sizeof(record));
+    data.append(entry.path);
+    data.append(padded(entry.path.size()) - entry.path.size(), '\0');
+  }
+
+  // readers see the old or the new file, never a partial one
+  std::string temporary = path + ".tmp" + std::to_string(getpid());
+  std::FILE *file = std::fopen(temporary.c_str(), "wb");
+  if (!file) {
+    return false;
+  }
+
+  bool complete = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+  complete &= std::fclose(file) == 0;
+  if (!complete || std::rename(temporary.c_str(), path.c_str()) != 0) {
+    std::remove(temporary.c_str());
+    return false;
+  }
+  return true;
+}
+
+void DirectoryIndex::apply(std::vector<Entry> &entries, const Change &change) {
+  auto found = std::find_if(
+      entries.begin(), entries.end(),
+      [&](const Entry &entry) { return entry.path == change.path; });
+
+  if (change.time == 0) {
+    if (found != entries.end()) {
+      entries.erase(found);
+    }
+    return;
+  }
+
+  if (found == entries.end()) {
+    Entry entry;
+    entry.path = change.path;
+    entry.folded = folded(change.path);
+    entries.push_back(std::move(entry));
+    found = entries.end() - 1;
+  }
+  found->rank += 1;
+  found->time = std::max(found->time, change.time);
+
+  // age all ranks, directories not visited for long drop out
+  double sum = 0;
+  for (const Entry &entry : entries) {
+    sum += entry.rank;
+  }
+  if (sum > maxRankSum) {
+    for (Entry &entry : entries) {
+      entry.rank *= 0.99;
+    }
+    std::erase_if(entries, [](const Entry &entry) { return entry.rank < 1; });
+  }
+}
+
+void DirectoryIndex::queue(const Change &change) {
+  std::lock_guard<std::mutex> lock(mutex);
+
+  // queries see the change at once, the file follows
+  apply(entries, change);
+  changes.push_back(change);
+
+  if (!writer.joinable()) {
+    writer = std::thread([this]() { writeChanges(); });
+  }
+  wake.notify_one();
+}
+
+void DirectoryIndex::writeChanges() {
+  std::unique_lock<std::mutex> lock(mutex);
+
+  for (;;) {
+    wake.wait(lock, [this]() { return stopping || !changes.empty(); });
+    if (changes.empty()) {
+      return;
+    }
+
+    std::vector<Change> taken;
+    taken.swap(changes);
+    writing = true;
+    lock.unlock();
+
+    // merge into the file as it is now, other shells write it too
+    std::filesystem::path database(databasePath);
+    std::error_code error;
+    std::filesystem::create_directories(database.parent_path(), error);
+
+    std::string lockPath = databasePath + ".lock";
+    int lockFile = ::open(lockPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (lockFile >= 0) {
+      ::flock(lockFile, LOCK_EX);
+    }
+
+    std::vector<Entry> merged = load(databasePath);
+    for (const Change &change : taken) {
+      apply(merged, change);
+    }
+    save(databasePath, merged);
+
+    if (lockFile >= 0) {
+      ::close(lockFile);
+    }
+
+    lock.lock();
+
+    // visits of other shells become visible, queued ones stay on top
+    entries = std::move(merged);
+    for (const Change &change : changes) {
+      apply(entries, change);
+    }
+    writing = false;
+    written.notify_all();
+  }
+}
@@ -0,0 +1,321 @@
+#include "DirectoryWalker.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_set>
+#include <utility>
+
+// Set of (device, inode) pairs, sharded so workers rarely share a lock
+class DirectoryWalker::InodeSet {
+public:
+  // returns false if the pair was already present
+  bool insert(std::uint64_t device, std::uint64_t inode) {
+    std::uint64_t mixed = (inode ^ (device << 32)) * 0x9E3779B97F4A7C15ull;
+    Shard &shard = shards[mixed >> 58];
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.keys.insert({device, inode}).second;
+  }
+
+private:
+  struct KeyHash {
+    std::size_t operator()(const std::pair<std::uint64_t, std::uint64_t> &key)
+        const {
+      return std::hash<std::uint64_t>()(key.second ^ (key.first << 40));
+    }
+  };
+
+  struct Shard {
+    std::mutex mutex;
+    std::unordered_set<std::pair<std::uint64_t, std::uint64_t>, KeyHash> keys;
+  };
+
+  Shard shards[64]; // indexed by the top 6 bits of the mixed key
+};
+
+static DirectoryWalker::EntryType typeFromMode(mode_t mode) {
+  if (S_ISREG(mode))
+    return DirectoryWalker::Regular;
+  if (S_ISDIR(mode))
+    return DirectoryWalker::Directory;
+  if (S_ISLNK(mode))
+    return DirectoryWalker::Symlink;
+  return DirectoryWalker::Other;
+}
+
+static DirectoryWalker::EntryType typeFromDirent(unsigned char type) {
+  switch (type) {
+  case DT_REG:
+    return DirectoryWalker::Regular;
+  case DT_DIR:
+    return DirectoryWalker::Directory;
+  case DT_LNK:
+    return DirectoryWalker::Symlink;
+  case DT_UNKNOWN:
+    return DirectoryWalker::Unknown;
+  default:
+    return DirectoryWalker::Other;
+  }
+}
+
+// Offset of the last path component, trailing slashes ignored
+static std::size_t nameOffsetOf(const std::string &path) {
+  std::size_t end = path.find_last_not_of('/');
+  if (end == std::string::npos) {
+    return 0;
+  }
+
+  std::size_t slash = path.rfind('/', end);
+  return slash == std::string::npos ? 0 : slash + 1;
+}
+
+DirectoryWalker::DirectoryWalker(const WalkOptions &options)
+    : options(options) {
+  threads = options.threads > 0
+                ? options.threads
+                : std::max(2, int(std::thread::hardware_concurrency()));
+
+  for (int i = 0; i < threads; i++) {
+    workers.push_back(std::make_unique<Worker>());
+  }
+}
+
+DirectoryWalker::~DirectoryWalker() = default;
+
+int DirectoryWalker::threadCount() const { return threads; }
+
+void DirectoryWalker::cancel() {
+  stopped = true;
+
+  std::lock_guard<std::mutex> lock(idleMutex);
+  idle.notify_all();
+}
+
+bool DirectoryWalker::walk(const std::vector<std::string> &roots,
+                           const Visitor &visit, const ErrorHandler &onError) {
+  visitor = &visit;
+  errorHandler = &onError;
+  pending = 0;
+  hardlinks = std::make_unique<InodeSet>();
+  directories = std::make_unique<InodeSet>();
+
+  // roots are visited here, their contents on the workers
+  for (int i = 0; i < int(roots.size()) && !stopped; i++) {
+    Entry entry;
+    entry.path = roots[i];
+    entry.nameOffset = nameOffsetOf(entry.path);
+    entry.root = i;
+
+    if (!fillMetadata(AT_FDCWD, entry.path.c_str(), options.followLinks,
+                      entry)) {
+      onError(entry.path, errno, 0);
+      continue;
+    }
+
+    if (visit(entry, 0) && shouldDescend(entry)) {
+      pushJob(i % threads, {entry.path, 0, i});
+    }
+  }
+
+  if (pending > 0) {
+    std::vector<std::thread> helpers;
+    for (int i = 1; i < threads; i++) {
+      helpers.emplace_back(&DirectoryWalker::runWorker, this, i);
+    }
+
+    runWorker(0);
+
+    for (std::thread &helper : helpers) {
+      helper.join();
+    }
+  }
+
+  // a cancelled walk leaves jobs behind
+  for (auto &worker : workers) {
+    worker->jobs.clear();
+  }
+
+  visitor = nullptr;
+  errorHandler = nullptr;
+  return !stopped;
+}
+
+void DirectoryWalker::runWorker(int index) {
+  Job job;
+
+  while (!stopped) {
+    if (takeJob(index, job)) {
+      readDirectory(job, index);
+
+      // the last directory wakes everyone up to exit
+      if (pending.fetch_sub(1) == 1) {
+        std::lock_guard<std::mutex> lock(idleMutex);
+        idle.notify_all();
+      }
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(idleMutex);
+    if (pending == 0) {
+      break;
+    }
+
+    // pushes notify, the timeout only covers a missed wake up
+    idle.wait_for(lock, std::chrono::milliseconds(1));
+  }
+}
+
+bool DirectoryWalker::takeJob(int index, Job &job) {
+  {
+    Worker &own = *workers[index];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (!own.jobs.empty()) {
+      // newest first keeps the walk depth first and the queues short
+      job = std::move(own.jobs.back());
+      own.jobs.pop_back();
+      return true;
+    }
+  }
+
+  for (int offset = 1; offset < threads; offset++) {
+    Worker &victim = *workers[(index + offset) % threads];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.jobs.empty()) {
+      // oldest jobs sit closest to the root and carry the most work
+      job = std::move(victim.jobs.front());
+      victim.jobs.pop_front();
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void DirectoryWalker::pushJob(int index, Job job) {
+  pending++;
+
+  {
+    Worker &worker = *workers[index];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    worker.jobs.push_back(std::move(job));
+  }
+
+  idle.notify_one();
+}
+
+void DirectoryWalker::readDirectory(const Job &job, int index) {
+  int fd = ::open(job.path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (fd < 0) {
+    (*errorHandler)(job.path, errno, index);
+    return;
+  }
+
+  DIR *dir = ::fdopendir(fd);
+  if (!dir) {
+    int error = errno;
+    ::close(fd);
+    (*errorHandler)(job.path, error, index);
+    return;
+  }
+
+  std::string prefix = job.path;
+  if (prefix.empty() || prefix.back() != '/') {
+    prefix += '/';
+  }
+
+  while (!stopped) {
+    errno = 0;
+    struct dirent *record = ::readdir(dir);
+    if (!record) {
+      if (errno != 0) {
+        (*errorHandler)(job.path, errno, index);
+      }
+      break;
+    }
+
+    const char *name = record->d_name;
+    if (name[0] == '.' &&
+        (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+      continue;
+    }
+
+    Entry entry;
+    entry.path = prefix + name;
+    entry.nameOffset = prefix.size();
+    entry.depth = job.depth + 1;
+    entry.root = job.root;
+    entry.type = typeFromDirent(record->d_type);
+
+    // d_type answers name and type only walks without a statx call
+    bool needStat = options.needMetadata || entry.type == Unknown ||
+                    (options.followLinks &&
+                     (entry.type == Symlink || entry.type == Directory));
+
+    if (needStat && !fillMetadata(::dirfd(dir), name, options.followLinks,
+                                  entry)) {
+      (*errorHandler)(entry.path, errno, index);
+      continue;
+    }
+
+    if (!(*visitor)(entry, index) || !shouldDescend(entry)) {
+      continue;
+    }
+
+    pushJob(index, {std::move(entry.path), entry.depth, entry.root});
+  }
+
+  ::closedir(dir);
+}
+
+bool DirectoryWalker::fillMetadata(int dirFd, const char *name, bool follow,
+                                   Entry &entry) {
+  const unsigned int mask = STATX_TYPE | STATX_MODE | STATX_SIZE |
+                            STATX_BLOCKS | STATX_INO | STATX_NLINK;
+  const int flags = AT_STATX_DONT_SYNC | (follow ? 0 : AT_SYMLINK_NOFOLLOW);
+
+  struct statx info;
+  if (::statx(dirFd, name, flags, mask, &info) != 0) {
+    // dangling links are still reported, as links
+    if (!follow || errno != ENOENT ||
+        ::statx(dirFd, name, flags | AT_SYMLINK_NOFOLLOW, mask, &info) != 0) {
+      return false;
+    }
+  }
+
+  entry.type = typeFromMode(info.stx_mode);
+  entry.hasMetadata = true;
+  entry.size = info.stx_size;
+  entry.blocks = info.stx_blocks;
+  entry.device = makedev(info.stx_dev_major, info.stx_dev_minor);
+  entry.inode = info.stx_ino;
+  entry.links = info.stx_nlink;
+
+  if (options.trackHardlinks && entry.type != Directory && entry.links > 1) {
+    entry.seenLink = !hardlinks->insert(entry.device, entry.inode);
+  }
+
+  return true;
+}
+
+bool DirectoryWalker::shouldDescend(const Entry &entry) {
+  if (entry.type != Directory || stopped) {
+    return false;
+  }
+
+  if (options.maxDepth >= 0 && entry.depth >= options.maxDepth) {
+    return false;
+  }
+
+  // symlinked directories can point back up the tree
+  if (options.followLinks && entry.hasMetadata) {
+    return directories->insert(entry.device, entry.inode);
+  }
+
+  return true;
+}
@@ -0,0 +1,75 @@
+#include "FileFollower.h"
+#include <QFile>
+#include <QSocketNotifier>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+FileFollower::FileFollower(const QString &path, qint64 offset, QObject *parent)
+    : QObject(parent), path(path), offset(offset) {
+  inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (inotifyFd < 0) {
+    return;
+  }
+
+  int watch = inotify_add_watch(inotifyFd, QFile::encodeName(path).constData(),
+                                IN_MODIFY | IN_ATTRIB | IN_DELETE_SELF |
+                                    IN_MOVE_SELF);
+  if (watch < 0) {
+    ::close(inotifyFd);
+    inotifyFd = -1;
+    return;
+  }
+
+  notifier = new QSocketNotifier(inotifyFd, QSocketNotifier::Read, this);
+  connect(notifier, &QSocketNotifier::activated, this,
+          &FileFollower::readEvents);
+}
+
+FileFollower::~FileFollower() {
+  if (inotifyFd >= 0) {
+    ::close(inotifyFd);
+  }
+}
+
+bool FileFollower::isValid() const { return inotifyFd >= 0; }
+
+void FileFollower::readEvents() {
+  // drain pending events, only the fact that something happened matters
+  alignas(struct inotify_event) char events[4096];
+  bool fileGone = false;
+  ssize_t bytes;
+
+  while ((bytes = ::read(inotifyFd, events, sizeof(events))) > 0) {
+    for (char *cursor = events; cursor < events + bytes;) {
+      auto *event = reinterpret_cast<struct inotify_event *>(cursor);
+      if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) {
+        fileGone = true;
+      }
+      cursor += sizeof(struct inotify_event) + event->len;
+    }
+  }
+
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly)) {
+    emit followError(QString("tail: %1: file became inaccessible").arg(path));
+    notifier->setEnabled(false);
+    return;
+  }
+
+  // truncated (log rotation by copytruncate): start over
+  if (file.size() < offset) {
+    emit followError(QString("tail: %1: file truncated").arg(path));
+    offset = 0;
+  }
+
+  if (file.size() > offset && file.seek(offset)) {
+    QByteArray appended = file.readAll();
+    offset += appended.size();
+    emit dataAppended(QString::fromUtf8(appended));
+  }
+
+  if (fileGone) {
+    emit followError(QString("tail: %1: file was removed or renamed").arg(path));
+    notifier->setEnabled(false);
+  }
+}
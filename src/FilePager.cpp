@@ -0,0 +1,450 @@
+#include "FilePager.h"
+#include "LineIndex.h"
+#include "MappedFile.h"
+#include "TextScan.h"
+#include "TextWidth.h"
+#include <QFile>
+#include <QTimer>
+#include <algorithm>
+#include <cstring>
+
+// Bytes a search scans between checks for a newer search
+static constexpr std::size_t searchChunk = 16 << 20;
+
+// Longest line looked at, longer lines are shown in pieces of this size
+static constexpr std::size_t maxLineBytes = 1 << 20;
+
+// Status line refresh while the index is built
+static constexpr int refreshInterval = 250;
+
+// Tabs are expanded so cut lines line up
+static QString expandTabs(const QString &line) {
+  if (!line.contains('\t')) {
+    return line;
+  }
+
+  QString expanded;
+  for (QChar character : line) {
+    if (character == '\t') {
+      expanded += QString(8 - expanded.size() % 8, QChar(' '));
+    } else {
+      expanded += character;
+    }
+  }
+  return expanded;
+}
+
+static bool sameLine(const WatchLine &a, const WatchLine &b) {
+  if (a.text != b.text || a.highlights.size() != b.highlights.size()) {
+    return false;
+  }
+  for (int i = 0; i < a.highlights.size(); i++) {
+    if (a.highlights[i].start != b.highlights[i].start ||
+        a.highlights[i].length != b.highlights[i].length) {
+      return false;
+    }
+  }
+  return true;
+}
+
+FilePager::FilePager(const QString &path, std::unique_ptr<MappedFile> file,
+                     int rows, int columns, QObject *parent)
+    : QObject(parent), path(path), file(std::move(file)),
+      rows(std::max(2, rows)), columns(std::max(1, columns)),
+      cancel(std::make_shared<std::atomic<bool>>(false)) {
+  index = std::make_unique<LineIndex>(QFile::encodeName(path).toStdString(),
+                                      this->file->data(), this->file->size());
+
+  // one search at a time, a new one cancels the old
+  pool.setMaxThreadCount(1);
+
+  timer = new QTimer(this);
+  timer->setInterval(refreshInterval);
+  connect(timer, &QTimer::timeout, this, [this]() {
+    if (index->isComplete()) {
+      timer->stop();
+    }
+    render();
+  });
+}
+
+FilePager::~FilePager() {
+  cancel->store(true);
+  pool.clear();
+  pool.waitForDone();
+}
+
+void FilePager::start(qint64 line) {
+  if (line > 0) {
+    goToLine(line);
+  }
+  if (!index->isComplete()) {
+    timer->start();
+  }
+  render();
+}
+
+void FilePager::resize(int newRows, int newColumns) {
+  rows = std::max(2, newRows);
+  columns = std::max(1, newColumns);
+  render();
+}
+
+void FilePager::keyPressed(int key, const QString &text) {
+  // typing a search or a ':' command
+  if (!prompt.isNull()) {
+    if (key == Qt::Key_Return || key == Qt::Key_Enter) {
+      if (!runCommand()) {
+        return;
+      }
+    } else if (key == Qt::Key_Escape) {
+      prompt = QChar();
+      input.clear();
+    } else if (key == Qt::Key_Backspace) {
+      if (input.isEmpty()) {
+        prompt = QChar();
+      }
+      input.chop(1);
+    } else if (!text.isEmpty() && text.at(0).isPrint()) {
+      input += text;
+    }
+    render();
+    return;
+  }
+
+  message.clear();
+
+  // a number in front of a command: 25g, 50%, 3j
+  if (text.size() == 1 && text.at(0).isDigit()) {
+    count += text;
+    render();
+    return;
+  }
+
+  bool counted = !count.isEmpty();
+  qint64 number = count.toLongLong();
+  qint64 times = counted ? std::max<qint64>(1, number) : 1;
+  qint64 half = std::max(1, pageLines() / 2);
+  count.clear();
+
+  if (key == Qt::Key_PageDown || text == " " || text == "f") {
+    scrollLines(times * pageLines());
+  } else if (key == Qt::Key_PageUp || text == "b") {
+    scrollLines(-times * pageLines());
+  } else if (key == Qt::Key_Down || key == Qt::Key_Return ||
+             key == Qt::Key_Enter || text == "j" || text == "e") {
+    scrollLines(times);
+  } else if (key == Qt::Key_Up || text == "k" || text == "y") {
+    scrollLines(-times);
+  } else if (text == "d") {
+    scrollLines(times * half);
+  } else if (text == "u") {
+    scrollLines(-times * half);
+  } else if (key == Qt::Key_Home || text == "g" || text == "<") {
+    goToLine(counted ? number - 1 : 0);
+  } else if (key == Qt::Key_End || text == "G" || text == ">") {
+    counted ? goToLine(number - 1) : goToEnd();
+  } else if (text == "%" || text == "p") {
+    goToPercent(counted ? double(number) : 0);
+  } else if (text == "/" || text == "?" || text == ":") {
+    prompt = text.at(0);
+    input.clear();
+  } else if (text == "n" || text == "N") {
+    if (pattern.isEmpty()) {
+      message = "No previous search";
+    } else {
+      search(text == "n" ? forwardSearch : !forwardSearch);
+    }
+  } else if (text == "q" || text == "Q") {
+    emit finished();
+    return;
+  }
+
+  render();
+}
+
+void FilePager::render() {
+  QList<WatchLine> page;
+  std::size_t offset = top;
+  std::size_t size = file->size();
+  int textLines = 0;
+
+  for (int row = 0; row < pageLines(); row++) {
+    WatchLine line;
+    line.row = row;
+
+    if (offset < size) {
+      line.text = lineAt(offset, &offset);
+      textLines++;
+
+      for (int position = pattern.isEmpty() ? -1 : line.text.indexOf(pattern);
+           position >= 0;
+           position = line.text.indexOf(pattern, position + pattern.size())) {
+        line.highlights.append({position, int(pattern.size())});
+      }
+    } else {
+      line.text = "~"; // past the end, like less
+    }
+    page.append(line);
+  }
+
+  // status in reverse video below the text
+  WatchLine status;
+  status.row = pageLines();
+  status.text = statusLine(offset, textLines);
+  status.text.truncate(int(TextWidth::fitColumns(
+      reinterpret_cast<const char16_t *>(status.text.utf16()),
+      status.text.size(), columns)));
+  status.highlights.append({0, int(status.text.size()), OutputSpan::Label});
+  page.append(status);
+
+  // rows equal to the last page are not sent
+  QList<WatchLine> changed;
+  for (const WatchLine &line : page) {
+    if (line.row >= shown.size() || !sameLine(line, shown[line.row])) {
+      changed.append(line);
+    }
+  }
+
+  bool shrunk = page.size() < shown.size();
+  shown = page;
+  if (!changed.isEmpty() || shrunk) {
+    emit pageChanged(shown.size(), changed);
+  }
+}
+
+QString FilePager::lineAt(std::size_t offset, std::size_t *next) const {
+  const char *data = file->data();
+  std::size_t available = std::min(file->size() - offset, maxLineBytes);
+
+  const void *newline = std::memchr(data + offset, '\n', available);
+  std::size_t end = newline ? static_cast<const char *>(newline) - data
+                            : offset + available;
+  *next = newline ? end + 1 : end;
+
+  // only what can fit on screen is decoded
+  std::size_t length = std::min(end - offset, std::size_t(columns) * 4 + 4);
+  QString line = QString::fromUtf8(data + offset, qsizetype(length));
+  if (line.endsWith('\r')) {
+    line.chop(1);
+  }
+
+  line = expandTabs(line);
+  line.truncate(int(TextWidth::fitColumns(
+      reinterpret_cast<const char16_t *>(line.utf16()), line.size(),
+      columns)));
+  return line;
+}
+
+QString FilePager::statusLine(std::size_t end, int textLines) const {
+  if (!prompt.isNull()) {
+    return prompt + input;
+  }
+  if (!message.isEmpty()) {
+    return message;
+  }
+
+  bool exact = true;
+  std::size_t first = index->lineNumber(top, &exact) + 1;
+  QString approximate = exact ? QString() : QString("~");
+  QString total = index->isComplete()
+                      ? QString::number(index->lineCount())
+                      : "~" + QString::number(index->lineCount());
+
+  std::size_t size = file->size();
+  int percent = size ? int(end * 100 / size) : 100;
+
+  QString status =
+      QString("%1  lines %2%3-%4 of %5  %6%")
+          .arg(path, approximate, QString::number(first),
+               QString::number(first + std::max(1, textLines) - 1), total,
+               QString::number(percent));
+
+  if (!index->isComplete()) {
+    status += QString("  indexing %1%")
+                  .arg(size ? index->indexedBytes() * 100 / size : 100);
+  }
+  if (searching) {
+    status += "  searching " + pattern;
+  }
+  if (!count.isEmpty()) {
+    status += "  " + count;
+  }
+  return status;
+}
+
+int FilePager::pageLines() const { return rows - 1; }
+
+std::size_t FilePager::lineStart(std::size_t offset) const {
+  const void *newline =
+      offset ? ::memrchr(file->data(), '\n', offset) : nullptr;
+  return newline ? static_cast<const char *>(newline) - file->data() + 1 : 0;
+}
+
+std::size_t FilePager::nextLine(std::size_t offset) const {
+  std::size_t size = file->size();
+  if (offset >= size) {
+    return size;
+  }
+
+  const void *newline =
+      std::memchr(file->data() + offset, '\n', size - offset);
+  return newline ? static_cast<const char *>(newline) - file->data() + 1
+                 : size;
+}
+
+std::size_t FilePager::lastPage() const {
+  return TextScan::tailOffset(file->data(), file->size(), pageLines());
+}
+
+void FilePager::scrollLines(qint64 delta) {
+  if (delta < 0) {
+    top = top ? TextScan::tailOffset(file->data(), top, std::size_t(-delta))
+              : 0;
+    return;
+  }
+
+  // the last page is as far as scrolling goes
+  std::size_t limit = lastPage();
+  while (delta-- > 0 && top < limit) {
+    top = nextLine(top);
+  }
+}
+
+void FilePager::goToLine(qint64 line) {
+  std::size_t offset =
+      index->lineOffset(std::size_t(std::max<qint64>(0, line)));
+  top = std::min(offset, lastPage());
+}
+
+void FilePager::goToPercent(double percent) {
+  percent = std::clamp(percent, 0.0, 100.0);
+  std::size_t offset = std::size_t(double(file->size()) * percent / 100);
+  top = std::min(lineStart(offset), lastPage());
+}
+
+void FilePager::goToEnd() { top = lastPage(); }
+
+bool FilePager::runCommand() {
+  QChar kind = prompt;
+  QString text = input;
+  prompt = QChar();
+  input.clear();
+
+  if (kind == ':') {
+    text = text.trimmed();
+    if (text == "q") {
+      emit finished();
+      return false;
+    }
+
+    bool valid = false;
+    if (text.endsWith('%')) {
+      double percent = text.chopped(1).toDouble(&valid);
+      if (valid) {
+        goToPercent(percent);
+      }
+    } else {
+      qint64 line = text.toLongLong(&valid);
+      if (valid) {
+        goToLine(line - 1);
+      }
+    }
+    if (!valid) {
+      message = "Unknown command: " + text;
+    }
+    return true;
+  }
+
+  // an empty search repeats the last one in the new direction
+  if (!text.isEmpty()) {
+    pattern = text;
+    needle = text.toUtf8();
+  }
+  if (pattern.isEmpty()) {
+    message = "No previous search";
+    return true;
+  }
+
+  forwardSearch = kind == '/';
+  search(forwardSearch);
+  return true;
+}
+
+void FilePager::search(bool forward) {
+  // a running search is abandoned
+  cancel->store(true);
+  cancel = std::make_shared<std::atomic<bool>>(false);
+  std::shared_ptr<std::atomic<bool>> stop = cancel;
+  quint64 generation = ++searchGeneration;
+  searching = true;
+
+  const char *data = file->data();
+  std::size_t size = file->size();
+  QByteArray text = needle;
+
+  // forward from the line below the top, backward from above it
+  std::size_t from = forward ? nextLine(top) : top;
+
+  pool.start([this, data, size, text, from, forward, stop, generation]() {
+    std::size_t length = std::size_t(text.size());
+    qint64 found = -1;
+
+    if (forward) {
+      for (std::size_t position = from; position < size && !*stop;
+           position += searchChunk) {
+        std::size_t span = std::min(size - position, searchChunk + length - 1);
+        const char *hit = TextScan::findLiteral(data + position, span,
+                                                text.constData(), length);
+        if (hit) {
+          found = hit - data;
+          break;
+        }
+      }
+    } else {
+      // chunks from the end, the last match starting before end wins
+      std::size_t end = from;
+      while (end > 0 && found < 0 && !*stop) {
+        std::size_t start = end > searchChunk ? end - searchChunk : 0;
+        const char *limit = data + std::min(size, end + length - 1);
+        const char *position = data + start;
+
+        while (position < limit) {
+          const char *hit = TextScan::findLiteral(
+              position, std::size_t(limit - position), text.constData(),
+              length);
+          if (!hit || std::size_t(hit - data) >= end) {
+            break;
+          }
+          found = hit - data;
+          position = hit + 1;
+        }
+        end = start;
+      }
+    }
+
+    if (*stop) {
+      return;
+    }
+
+    // back to the owner thread, dropped if the pager is gone
+    QMetaObject::invokeMethod(
+        this,
+        [this, generation, found]() { searchFinished(generation, found); },
+        Qt::QueuedConnection);
+  });
+}
+
+void FilePager::searchFinished(quint64 generation, qint64 offset) {
+  if (generation != searchGeneration) {
+    return;
+  }
+
+  searching = false;
+  if (offset < 0) {
+    message = "Pattern not found: " + pattern;
+  } else {
+    top = std::min(lineStart(std::size_t(offset)), lastPage());
+  }
+  render();
+}
@@ -0,0 +1,88 @@
+#include "GapBuffer.h"
+#include <algorithm>
+#include <cstring>
+
+GapBuffer::GapBuffer(std::size_t capacity)
+    : data(std::max<std::size_t>(capacity, 1)), gapEnd(data.size()) {}
+
+std::size_t GapBuffer::size() const {
+  return data.size() - (gapEnd - gapStart);
+}
+
+std::size_t GapBuffer::cursor() const { return gapStart; }
+
+char16_t GapBuffer::at(std::size_t index) const {
+  return index < gapStart ? data[index] : data[index + (gapEnd - gapStart)];
+}
+
+void GapBuffer::moveTo(std::size_t position) {
+  position = std::min(position, size());
+
+  if (position < gapStart) {
+    // text between position and the gap moves behind the gap
+    std::size_t count = gapStart - position;
+    std::memmove(data.data() + gapEnd - count, data.data() + position,
+                 count * sizeof(char16_t));
+    gapStart -= count;
+    gapEnd -= count;
+  } else if (position > gapStart) {
+    std::size_t count = position - gapStart;
+    std::memmove(data.data() + gapStart, data.data() + gapEnd,
+                 count * sizeof(char16_t));
+    gapStart += count;
+    gapEnd += count;
+  }
+}
+
+void GapBuffer::insert(const char16_t *text, std::size_t length) {
+  reserveGap(length);
+  std::memcpy(data.data() + gapStart, text, length * sizeof(char16_t));
+  gapStart += length;
+}
+
+void GapBuffer::erase(std::size_t position, std::size_t length) {
+  moveTo(position);
+  gapEnd += std::min(length, data.size() - gapEnd);
+}
+
+std::u16string GapBuffer::slice(std::size_t position,
+                                std::size_t length) const {
+  position = std::min(position, size());
+  length = std::min(length, size() - position);
+
+  std::u16string result;
+  result.reserve(length);
+  for (std::size_t index = position; index < position + length; index++) {
+    result.push_back(at(index));
+  }
+  return result;
+}
+
+std::u16string GapBuffer::text() const {
+  std::u16string result(data.begin(), data.begin() + gapStart);
+  result.append(data.begin() + gapEnd, data.end());
+  return result;
+}
+
+void GapBuffer::clear() {
+  gapStart = 0;
+  gapEnd = data.size();
+}
+
+void GapBuffer::reserveGap(std::size_t length) {
+  if (gapEnd - gapStart >= length) {
+    return;
+  }
+
+  // double the buffer, the text after the gap moves to the new end
+  std::size_t after = data.size() - gapEnd;
+  std::size_t capacity = std::max(data.size() * 2, size() + length);
+  std::vector<char16_t> grown(capacity);
+
+  std::memcpy(grown.data(), data.data(), gapStart * sizeof(char16_t));
+  std::memcpy(grown.data() + capacity - after, data.data() + gapEnd,
+              after * sizeof(char16_t));
+
+  data.swap(grown);
+  gapEnd = capacity - after;
+}
@@ -0,0 +1,676 @@
+#include "Glob.h"
+#include "DirectoryWalker.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <dirent.h>
+#include <sys/stat.h>
+
+namespace Glob {
+
+// Next code point of UTF-8 text, invalid bytes stand for themselves
+static char32_t decode(const char *text, std::size_t length,
+                       std::size_t &position) {
+  unsigned char lead = static_cast<unsigned char>(text[position]);
+  int extra = lead >= 0xF0 ? 3 : lead >= 0xE0 ? 2 : lead >= 0xC0 ? 1 : 0;
+  if (position + extra >= length) {
+    extra = 0; // truncated sequence
+  }
+
+  char32_t codePoint = extra == 0 ? lead : lead & (0x3F >> extra);
+  for (int i = 1; i <= extra; i++) {
+    unsigned char next = static_cast<unsigned char>(text[position + i]);
+    if ((next & 0xC0) != 0x80) {
+      position++;
+      return lead;
+    }
+    codePoint = (codePoint << 6) | (next & 0x3F);
+  }
+
+  position += extra + 1;
+  return codePoint;
+}
+
+// [:name:] inside a bracket expression, ASCII only
+static bool namedClass(const std::string &name,
+                       std::vector<std::pair<char32_t, char32_t>> &ranges) {
+  if (name == "digit") {
+    ranges.push_back({'0', '9'});
+  } else if (name == "upper") {
+    ranges.push_back({'A', 'Z'});
+  } else if (name == "lower") {
+    ranges.push_back({'a', 'z'});
+  } else if (name == "alpha") {
+    ranges.insert(ranges.end(), {{'A', 'Z'}, {'a', 'z'}});
+  } else if (name == "alnum") {
+    ranges.insert(ranges.end(), {{'0', '9'}, {'A', 'Z'}, {'a', 'z'}});
+  } else if (name == "space") {
+    ranges.insert(ranges.end(), {{' ', ' '}, {'\t', '\r'}});
+  } else if (name == "xdigit") {
+    ranges.insert(ranges.end(), {{'0', '9'}, {'A', 'F'}, {'a', 'f'}});
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// Bracket element at position: a character, escaped or not, a collating
+// symbol [.c.] or an equivalence class [=c=] (one character each, as in
+// the C locale)
+static bool bracketElement(const std::string &segment, std::size_t &position,
+                           char32_t &codePoint, bool &valid) {
+  const char *text = segment.data();
+  std::size_t length = segment.size();
+
+  if (text[position] == '[' && position + 2 < length &&
+      (text[position + 1] == '.' || text[position + 1] == '=')) {
+    char delimiter = text[position + 1];
+    std::size_t inner = position + 2;
+    char32_t symbol = decode(text, length, inner);
+    if (inner + 1 < length && text[inner] == delimiter &&
+        text[inner + 1] == ']') {
+      codePoint = symbol;
+      position = inner + 2;
+      return true;
+    }
+
+    // like fnmatch, a bad collating symbol spoils the pattern while a bad
+    // equivalence class is a plain '['
+    if (delimiter == '.') {
+      valid = false;
+      return false;
+    }
+  } else if (text[position] == '[' && position + 1 < length &&
+             text[position + 1] == '.') {
+    valid = false;
+    return false;
+  }
+
+  if (text[position] == '\\' && position + 1 < length) {
+    position++;
+  }
+  codePoint = decode(text, length, position);
+  return true;
+}
+
+Matcher::Matcher(const std::string &segment) {
+  std::string literal;
+  auto flush = [&]() {
+    if (!literal.empty()) {
+      Token token;
+      token.text = std::move(literal);
+      tokens.push_back(std::move(token));
+      literal.clear();
+    }
+  };
+
+  const char *text = segment.data();
+  std::size_t length = segment.size();
+  std::size_t position = 0;
+
+  while (position < length) {
+    char character = text[position];
+
+    if (character == '\\') {
+      if (position + 1 == length) {
+        valid = false; // a trailing backslash escapes nothing, as in fnmatch
+        break;
+      }
+      literal += text[position + 1];
+      position += 2;
+      continue;
+    }
+
+    if (character == '*') {
+      flush();
+      if (tokens.empty() || tokens.back().type != Token::Star) {
+        Token token;
+        token.type = Token::Star;
+        tokens.push_back(token);
+      }
+      position++;
+      continue;
+    }
+
+    if (character == '?') {
+      flush();
+      Token token;
+      token.type = Token::Any;
+      tokens.push_back(token);
+      position++;
+      continue;
+    }
+
+    if (character == '[') {
+      // parse the bracket expression, an unclosed one is a plain '['
+      Token token;
+      token.type = Token::Class;
+      std::size_t scan = position + 1;
+      if (scan < length && (text[scan] == '!' || text[scan] == '^')) {
+        token.negated = true;
+        scan++;
+      }
+
+      bool closed = false;
+      bool first = true;
+      while (scan < length) {
+        if (text[scan] == ']' && !first) {
+          closed = true;
+          scan++;
+          break;
+        }
+        first = false;
+
+        // [:name:] with a lower case name, otherwise '[' is a character
+        if (text[scan] == '[' && scan + 1 < length && text[scan + 1] == ':') {
+          std::size_t end = scan + 2;
+          while (end < length && text[end] >= 'a' && text[end] <= 'z') {
+            end++;
+          }
+          if (end + 1 < length && text[end] == ':' && text[end + 1] == ']') {
+            if (!namedClass(segment.substr(scan + 2, end - scan - 2),
+                            token.ranges) &&
+                token.unknownClass == std::string::npos) {
+              token.unknownClass = token.ranges.size();
+            }
+            scan = end + 2;
+            continue;
+          }
+        }
+
+        char32_t low = 0;
+        if (!bracketElement(segment, scan, low, valid)) {
+          break;
+        }
+        char32_t high = low;
+        if (scan + 1 == length && text[scan] == '-') {
+          valid = false; // a range cut off by the end of the pattern
+          break;
+        }
+        if (scan + 1 < length && text[scan] == '-' && text[scan + 1] != ']') {
+          scan++;
+          if (!bracketElement(segment, scan, high, valid)) {
+            break;
+          }
+        }
+        token.ranges.push_back({low, high});
+      }
+
+      if (!valid) {
+        break;
+      }
+
+      if (closed) {
+        flush();
+        tokens.push_back(std::move(token));
+        position = scan;
+      } else {
+        literal += '[';
+        position++;
+      }
+      continue;
+    }
+
+    literal += character;
+    position++;
+  }
+  flush();
+
+  hidden = !tokens.empty() && tokens.front().type == Token::Literal &&
+           tokens.front().text[0] == '.';
+
+  // pick the cheapest way to compare names
+  if (tokens.empty()) {
+    kind = Exact;
+  } else if (tokens.size() == 1 && tokens[0].type == Token::Literal) {
+    kind = Exact;
+    prefix = tokens[0].text;
+  } else {
+    std::size_t stars = 0;
+    bool plain = true;
+    for (const Token &token : tokens) {
+      stars += token.type == Token::Star;
+      plain = plain && (token.type == Token::Literal || token.type == Token::Star);
+    }
+
+    if (plain && stars == 1) {
+      kind = PrefixSuffix;
+      for (std::size_t i = 0; i < tokens.size(); i++) {
+        if (tokens[i].type == Token::Star) {
+          prefix = i > 0 ? tokens[i - 1].text : std::string();
+          suffix = i + 1 < tokens.size() ? tokens[i + 1].text : std::string();
+        }
+      }
+    } else {
+      kind = General;
+    }
+  }
+}
+
+bool Matcher::isLiteral() const { return kind == Exact; }
+
+const std::string &Matcher::literal() const { return prefix; }
+
+bool Matcher::matchesHidden() const { return hidden; }
+
+bool Matcher::classMatches(const Token &token, char32_t codePoint) const {
+  // elements are tried in order like fnmatch, reaching an unknown class
+  // name fails the bracket whether it is negated or not
+  std::size_t count = std::min(token.ranges.size(), token.unknownClass);
+  for (std::size_t i = 0; i < count; i++) {
+    if (codePoint >= token.ranges[i].first &&
+        codePoint <= token.ranges[i].second) {
+      return !token.negated;
+    }
+  }
+  return token.unknownClass == std::string::npos && token.negated;
+}
+
+bool Matcher::matches(const char *name, std::size_t length) const {
+  if (!valid) {
+    return false;
+  }
+
+  if (kind == Exact) {
+    return length == prefix.size() &&
+           std::memcmp(name, prefix.data(), length) == 0;
+  }
+
+  if (kind == PrefixSuffix) {
+    return length >= prefix.size() + suffix.size() &&
+           std::memcmp(name, prefix.data(), prefix.size()) == 0 &&
+           std::memcmp(name + length - suffix.size(), suffix.data(),
+                       suffix.size()) == 0;
+  }
+
+  // backtracking to the last star is enough, earlier stars never need to
+  // take more characters
+  std::size_t token = 0;
+  std::size_t position = 0;
+  std::size_t starToken = std::string::npos;
+  std::size_t starPosition = 0;
+
+  while (position < length) {
+    if (token < tokens.size()) {
+      const Token &current = tokens[token];
+
+      if (current.type == Token::Star) {
+        starToken = ++token;
+        starPosition = position;
+        continue;
+      }
+
+      if (current.type == Token::Literal) {
+        if (length - position >= current.text.size() &&
+            std::memcmp(name + position, current.text.data(),
+                        current.text.size()) == 0) {
+          position += current.text.size();
+          token++;
+          continue;
+        }
+      } else {
+        std::size_t next = position;
+        char32_t codePoint = decode(name, length, next);
+        if (current.type == Token::Any || classMatches(current, codePoint)) {
+          position = next;
+          token++;
+          continue;
+        }
+      }
+    }
+
+    if (starToken == std::string::npos) {
+      return false;
+    }
+
+    // the last star takes one more character
+    decode(name, length, starPosition);
+    position = starPosition;
+    token = starToken;
+  }
+
+  while (token < tokens.size() && tokens[token].type == Token::Star) {
+    token++;
+  }
+  return token == tokens.size();
+}
+
+bool hasWildcards(const std::string &pattern) {
+  for (std::size_t i = 0; i < pattern.size(); i++) {
+    if (pattern[i] == '\\') {
+      i++;
+    } else if (pattern[i] == '*' || pattern[i] == '?' || pattern[i] == '[') {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Closing brace of the one at open, npos if unbalanced
+static std::size_t closingBrace(const std::string &pattern, std::size_t open) {
+  int depth = 0;
+  for (std::size_t i = open; i < pattern.size(); i++) {
+    if (pattern[i] == '\\') {
+      i++;
+    } else if (pattern[i] == '{') {
+      depth++;
+    } else if (pattern[i] == '}' && --depth == 0) {
+      return i;
+    }
+  }
+  return std::string::npos;
+}
+
+// Top level comma separated alternatives of a brace body
+static std::vector<std::string> alternatives(const std::string &body) {
+  std::vector<std::string> parts;
+  std::size_t start = 0;
+  int depth = 0;
+
+  for (std::size_t i = 0; i < body.size(); i++) {
+    if (body[i] == '\\') {
+      i++;
+    } else if (body[i] == '{') {
+      depth++;
+    } else if (body[i] == '}') {
+      depth--;
+    } else if (body[i] == ',' && depth == 0) {
+      parts.push_back(body.substr(start, i - start));
+      start = i + 1;
+    }
+  }
+
+  if (parts.empty()) {
+    return parts; // no comma, not a list
+  }
+  parts.push_back(body.substr(start));
+  return parts;
+}
+
+// {1..10}, {01..10} and {a..e}
+static std::vector<std::string> sequence(const std::string &body) {
+  std::size_t dots = body.find("..");
+  if (dots == std::string::npos || dots == 0 || dots + 2 >= body.size()) {
+    return {};
+  }
+
+  std::string first = body.substr(0, dots);
+  std::string last = body.substr(dots + 2);
+  std::vector<std::string> items;
+
+  if (first.size() == 1 && last.size() == 1 && std::isalpha(first[0]) &&
+      std::isalpha(last[0])) {
+    int step = first[0] <= last[0] ? 1 : -1;
+    for (char c = first[0];; c += step) {
+      items.push_back(std::string(1, c));
+      if (c == last[0]) {
+        break;
+      }
+    }
+    return items;
+  }
+
+  auto isNumber = [](const std::string &text) {
+    std::size_t start = text[0] == '-' ? 1 : 0;
+    return start < text.size() &&
+           std::all_of(text.begin() + start, text.end(),
+                       [](char c) { return c >= '0' && c <= '9'; });
+  };
+  if (!isNumber(first) || !isNumber(last) || first.size() > 9 ||
+      last.size() > 9) {
+    return {};
+  }
+
+  // a leading zero pads every number to the same width
+  bool padded = (first.size() > 1 && first[0] == '0') ||
+                (last.size() > 1 && last[0] == '0');
+  std::size_t width = std::max(first.size(), last.size());
+
+  long from = std::stol(first);
+  long to = std::stol(last);
+  long step = from <= to ? 1 : -1;
+  for (long value = from;; value += step) {
+    std::string item = std::to_string(value);
+    if (padded && item.size() < width) {
+      item.insert(0, width - item.size(), '0');
+    }
+    items.push_back(item);
+    if (value == to) {
+      break;
+    }
+  }
+  return items;
+}
+
+std::vector<std::string> expandBraces(const std::string &pattern) {
+  for (std::size_t i = 0; i < pattern.size(); i++) {
+    if (pattern[i] == '\\') {
+      i++;
+      continue;
+    }
+    if (pattern[i] != '{') {
+      continue;
+    }
+
+    std::size_t close = closingBrace(pattern, i);
+    if (close == std::string::npos) {
+      break;
+    }
+
+    std::string body = pattern.substr(i + 1, close - i - 1);
+    std::vector<std::string> items = alternatives(body);
+    if (items.empty()) {
+      items = sequence(body);
+    }
+    if (items.empty()) {
+      continue; // {} or {word} stay literal
+    }
+
+    // the prefix has no braces left, items and suffix may
+    std::string prefix = pattern.substr(0, i);
+    std::string suffix = pattern.substr(close + 1);
+    std::vector<std::string> words;
+    for (const std::string &item : items) {
+      for (std::string &word : expandBraces(item + suffix)) {
+        words.push_back(prefix + word);
+      }
+    }
+    return words;
+  }
+
+  return {pattern};
+}
+
+std::string unescape(const std::string &pattern) {
+  std::string text;
+  text.reserve(pattern.size());
+  for (std::size_t i = 0; i < pattern.size(); i++) {
+    if (pattern[i] == '\\' && i + 1 < pattern.size()) {
+      i++;
+    }
+    text += pattern[i];
+  }
+  return text;
+}
+
+static std::string join(const std::string &base, const std::string &name) {
+  if (base.empty()) {
+    return name;
+  }
+  return base.back() == '/' ? base + name : base + "/" + name;
+}
+
+static bool isDirectory(const std::string &path) {
+  struct stat info;
+  return ::stat(path.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+}
+
+// One read of base for a wildcard segment
+static void readMatches(const std::string &base, const Matcher &matcher,
+                        bool directoriesOnly, std::vector<std::string> &out) {
+  DIR *dir = ::opendir(base.empty() ? "." : base.c_str());
+  if (!dir) {
+    return;
+  }
+
+  while (struct dirent *record = ::readdir(dir)) {
+    const char *name = record->d_name;
+    if (name[0] == '.' && (!matcher.matchesHidden() || name[1] == '\0' ||
+                           (name[1] == '.' && name[2] == '\0'))) {
+      continue;
+    }
+    if (!matcher.matches(name, std::strlen(name))) {
+      continue;
+    }
+
+    std::string path = join(base, name);
+    if (directoriesOnly && record->d_type != DT_DIR &&
+        ((record->d_type != DT_LNK && record->d_type != DT_UNKNOWN) ||
+         !isDirectory(path))) {
+      continue;
+    }
+    out.push_back(std::move(path));
+  }
+
+  ::closedir(dir);
+}
+
+// What a '**' walk collects
+enum class WalkMode { Everything, Matching, Directories };
+
+static void walkTree(const std::string &base, WalkMode mode,
+                     const Matcher *matcher, bool directoriesOnly,
+                     std::vector<std::string> &out) {
+  WalkOptions options;
+  options.needMetadata = false;
+  DirectoryWalker walker(options);
+
+  std::vector<std::vector<std::string>> found(walker.threadCount());
+  std::string root = base.empty() ? "." : base;
+
+  walker.walk(
+      {root},
+      [&](const DirectoryWalker::Entry &entry, int worker) {
+        if (entry.depth == 0) {
+          return true;
+        }
+
+        const char *name = entry.name();
+        bool directory = entry.type == DirectoryWalker::Directory;
+        std::string path = base.empty() ? entry.path.substr(2) : entry.path;
+
+        // hidden entries only match a segment asking for them
+        if (name[0] == '.') {
+          if (mode == WalkMode::Matching && matcher->matchesHidden() &&
+              matcher->matches(name, std::strlen(name)) &&
+              (!directoriesOnly || directory)) {
+            found[worker].push_back(std::move(path));
+          }
+          return false;
+        }
+
+        bool wanted = mode == WalkMode::Everything
+                          ? !directoriesOnly || directory
+                      : mode == WalkMode::Directories
+                          ? directory
+                          : matcher->matches(name, std::strlen(name)) &&
+                                (!directoriesOnly || directory);
+        if (wanted) {
+          found[worker].push_back(std::move(path));
+        }
+        return true;
+      },
+      [](const std::string &, int, int) {});
+
+  for (auto &paths : found) {
+    out.insert(out.end(), std::make_move_iterator(paths.begin()),
+               std::make_move_iterator(paths.end()));
+  }
+}
+
+std::size_t expand(const std::string &pattern,
+                   const std::function<void(const std::string &)> &visitor) {
+  if (pattern.empty()) {
+    return 0;
+  }
+
+  bool trailingSlash = pattern.back() == '/';
+  std::vector<std::string> segments;
+  for (std::size_t start = 0; start <= pattern.size();) {
+    std::size_t slash = pattern.find('/', start);
+    if (slash == std::string::npos) {
+      slash = pattern.size();
+    }
+    if (slash > start) {
+      segments.push_back(pattern.substr(start, slash - start));
+    }
+    start = slash + 1;
+  }
+
+  std::vector<std::string> candidates = {pattern[0] == '/' ? "/" : ""};
+
+  for (std::size_t i = 0; i < segments.size() && !candidates.empty(); i++) {
+    bool last = i + 1 == segments.size();
+    bool directoriesOnly = !last || trailingSlash;
+    std::vector<std::string> next;
+
+    if (segments[i] == "**") {
+      if (last) {
+        for (const std::string &base : candidates) {
+          walkTree(base, WalkMode::Everything, nullptr, trailingSlash, next);
+        }
+      } else if (i + 2 == segments.size()) {
+        // '**/name': the last segment is matched during the walk
+        Matcher matcher(segments[i + 1]);
+        for (const std::string &base : candidates) {
+          walkTree(base, WalkMode::Matching, &matcher, trailingSlash, next);
+        }
+        i++;
+      } else {
+        // zero or more directories
+        for (const std::string &base : candidates) {
+          next.push_back(base);
+          walkTree(base, WalkMode::Directories, nullptr, true, next);
+        }
+      }
+
+      candidates.swap(next);
+      continue;
+    }
+
+    Matcher matcher(segments[i]);
+    if (matcher.isLiteral()) {
+      // no directory read, the name only needs to exist
+      for (const std::string &base : candidates) {
+        std::string path = join(base, matcher.literal());
+        struct stat info;
+        if (!last || (directoriesOnly ? isDirectory(path)
+                                      : ::lstat(path.c_str(), &info) == 0)) {
+          next.push_back(std::move(path));
+        }
+      }
+    } else {
+      for (const std::string &base : candidates) {
+        readMatches(base, matcher, directoriesOnly, next);
+      }
+    }
+
+    candidates.swap(next);
+  }
+
+  // the root alone is not a match
+  if (candidates.size() == 1 && (candidates[0].empty() || candidates[0] == "/")) {
+    return 0;
+  }
+
+  std::sort(candidates.begin(), candidates.end());
+  candidates.erase(std::unique(candidates.begin(), candidates.end()),
+                   candidates.end());
+
+  for (const std::string &path : candidates) {
+    visitor(trailingSlash ? path + "/" : path);
+  }
+  return candidates.size();
+}
+
+} // namespace Glob
@@ -0,0 +1,498 @@
+#include "GrepSearch.h"
+#include "DirectoryWalker.h"
+#include "MappedFile.h"
+#include "PosixRegex.h"
+#include "TextScan.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <QWaitCondition>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+// Files larger than this are split across pool threads
+static constexpr qint64 chunkSize = 4 * 1024 * 1024;
+
+// Bytes checked for NUL to classify a file as binary
+static constexpr qint64 binaryProbeSize = 8192;
+
+// Symlinks inside the tree are skipped unless -R
+static WalkOptions walkOptions(const GrepOptions &options) {
+  WalkOptions walk;
+  walk.followLinks = options.followLinks;
+  return walk;
+}
+
+GrepSearch::GrepSearch(const QString &pattern, const GrepOptions &options,
+                       QObject *parent)
+    : QObject(parent), pattern(pattern), options(options),
+      walker(walkOptions(options)) {
+  // plain text patterns skip the regex engine entirely
+  static const QString basicCharacters = "\\.[*^$";
+  static const QString extendedCharacters = "\\.[]()*+?{}|^$";
+  const QString &regexCharacters =
+      options.extendedRegexp ? extendedCharacters : basicCharacters;
+  bool plainText = options.fixedStrings;
+  if (!plainText) {
+    plainText =
+        std::none_of(pattern.begin(), pattern.end(), [&regexCharacters](QChar c) {
+          return regexCharacters.contains(c);
+        });
+  }
+
+  literal = plainText && !options.ignoreCase && !options.wordRegexp &&
+            !pattern.isEmpty();
+  needle = pattern.toUtf8();
+
+  regexPattern = plainText ? QRegularExpression::escape(pattern)
+                           : PosixRegex::toPcre(pattern, options.extendedRegexp);
+  if (options.wordRegexp) {
+    regexPattern = "\\b(?:" + regexPattern + ")\\b";
+  }
+
+  regexOptions = QRegularExpression::UseUnicodePropertiesOption;
+  if (options.ignoreCase) {
+    regexOptions |= QRegularExpression::CaseInsensitiveOption;
+  }
+
+  pool.setMaxThreadCount(QThread::idealThreadCount());
+}
+
+GrepSearch::~GrepSearch() {
+  if (thread) {
+    cancelled = true;
+    walker.cancel();
+    thread->wait();
+    delete thread;
+  }
+  pool.waitForDone();
+}
+
+void GrepSearch::start(const QStringList &paths) {
+  thread = QThread::create([this, paths]() { exitCode = run(paths); });
+
+  // queued behind the posted output
+  connect(thread, &QThread::finished, this,
+          [this]() { emit finished(exitCode); });
+
+  thread->start();
+}
+
+void GrepSearch::report(const QString &output,
+                        const QList<OutputSpan> &highlights) {
+  QMetaObject::invokeMethod(
+      this,
+      [this, output, highlights]() { emit matchesReady(output, highlights); },
+      Qt::QueuedConnection);
+}
+
+void GrepSearch::reportError(const QString &error) {
+  QMetaObject::invokeMethod(
+      this, [this, error]() { emit searchError(error); },
+      Qt::QueuedConnection);
+}
+
+int GrepSearch::run(const QStringList &paths) {
+  QRegularExpression check(regexPattern, regexOptions);
+  if (!literal && !check.isValid()) {
+    reportError(QString("grep: invalid pattern '%1': %2")
+                    .arg(pattern, check.errorString()));
+    return 2;
+  }
+
+  QList<Task> tasks = collectTasks(paths);
+
+  std::vector<ChunkResult> results(tasks.size());
+  QMutex mutex;
+  QWaitCondition chunkDone;
+
+  // keep a bounded number of chunks in flight ahead of the output cursor
+  const int window = qMax(4, pool.maxThreadCount() * 4);
+  int submitted = 0;
+
+  bool anySelected = false;
+  qint64 lineBase = 0;     // lines before the current chunk in its file
+  qint64 fileSelected = 0; // selected lines in the current file
+  bool fileBinary = false;
+
+  for (int index = 0; index < tasks.size() && !cancelled; index++) {
+    while (submitted < tasks.size() && submitted - index < window) {
+      int taskIndex = submitted++;
+      pool.start([this, &tasks, &results, &mutex, &chunkDone, taskIndex]() {
+        ChunkResult result;
+        if (!cancelled) {
+          searchChunk(tasks[taskIndex], result);
+        }
+
+        QMutexLocker locker(&mutex);
+        results[taskIndex] = std::move(result);
+        results[taskIndex].done = true;
+        chunkDone.wakeAll();
+      });
+    }
+
+    ChunkResult result;
+    {
+      QMutexLocker locker(&mutex);
+      while (!results[index].done) {
+        chunkDone.wait(&mutex);
+      }
+      result = std::move(results[index]);
+      results[index] = ChunkResult();
+    }
+
+    const Task &task = tasks[index];
+
+    if (task.begin == 0) {
+      lineBase = 0;
+      fileSelected = 0;
+      fileBinary = result.binary;
+    }
+
+    if (!result.error.isEmpty()) {
+      hadError = true;
+      reportError(result.error);
+    }
+
+    fileSelected += result.selected;
+    anySelected = anySelected || result.selected > 0;
+
+    // regular output: one emission per chunk
+    if (!options.countOnly && !options.filesWithMatches && !fileBinary &&
+        !result.matches.isEmpty()) {
+      QString output;
+      QList<OutputSpan> highlights;
+
+      for (const LineMatch &match : result.matches) {
+        QString label;
+        if (showFileNames) {
+          label += task.fileName + ":";
+        }
+        if (options.lineNumbers) {
+          label += QString::number(lineBase + match.line + 1) + ":";
+        }
+
+        if (!label.isEmpty()) {
+          highlights.append({int(output.size()), int(label.size()),
+                             OutputSpan::Label});
+          output += label;
+        }
+
+        for (OutputSpan span : match.spans) {
+          span.start += output.size();
+          highlights.append(span);
+        }
+
+        output += match.text + "\n";
+      }
+
+      report(output, highlights);
+    }
+
+    lineBase += result.newlines;
+
+    if (!task.lastOfFile) {
+      continue;
+    }
+
+    // per file summaries
+    if (options.countOnly) {
+      QString label = showFileNames ? task.fileName + ":" : QString();
+      QList<OutputSpan> highlights;
+      if (!label.isEmpty()) {
+        highlights.append({0, int(label.size()), OutputSpan::Label});
+      }
+      report(label + QString::number(fileSelected) + "\n", highlights);
+    } else if (options.filesWithMatches) {
+      if (fileSelected > 0) {
+        report(task.fileName + "\n",
+               {{0, int(task.fileName.size()), OutputSpan::Label}});
+      }
+    } else if (fileBinary && fileSelected > 0) {
+      report(QString("Binary file %1 matches\n").arg(task.fileName), {});
+    }
+  }
+
+  // chunks still in flight use the locals above
+  pool.waitForDone();
+
+  if (cancelled) {
+    return 130;
+  }
+
+  if (hadError) {
+    return 2;
+  }
+
+  return anySelected ? 0 : 1;
+}
+
+// Expands directories (with -r) and splits large files into chunks
+QList<GrepSearch::Task> GrepSearch::collectTasks(const QStringList &paths) {
+  QList<QPair<QString, qint64>> files;
+
+  for (const QString &path : paths) {
+    QFileInfo info(path);
+
+    if (!info.exists()) {
+      hadError = true;
+      reportError(QString("grep: %1: No such file or directory").arg(path));
+      continue;
+    }
+
+    if (!info.isDir()) {
+      files.append({path, info.size()});
+      continue;
+    }
+
+    if (!options.recursive) {
+      hadError = true;
+      reportError(QString("grep: %1: Is a directory").arg(path));
+      continue;
+    }
+
+    std::vector<std::vector<std::pair<std::string, qint64>>> found(
+        walker.threadCount());
+    std::vector<std::vector<std::pair<std::string, int>>> failed(
+        walker.threadCount());
+
+    walker.walk(
+        {QFile::encodeName(path).toStdString()},
+        [&found](const DirectoryWalker::Entry &entry, int worker) {
+          if (entry.type == DirectoryWalker::Regular) {
+            found[worker].push_back({entry.path, qint64(entry.size)});
+          }
+          return true;
+        },
+        [&failed](const std::string &failedPath, int error, int worker) {
+          failed[worker].push_back({failedPath, error});
+        });
+
+    for (const auto &worker : failed) {
+      for (const auto &[failedPath, error] : worker) {
+        hadError = true;
+        reportError(QString("grep: %1: %2")
+                        .arg(QFile::decodeName(failedPath.c_str()),
+                             QString::fromLocal8Bit(std::strerror(error))));
+      }
+    }
+
+    // workers finish in any order, sorting keeps the output stable
+    std::vector<std::pair<std::string, qint64>> merged;
+    for (auto &worker : found) {
+      merged.insert(merged.end(), worker.begin(), worker.end());
+    }
+    std::sort(merged.begin(), merged.end());
+
+    for (const auto &[filePath, size] : merged) {
+      files.append({QFile::decodeName(filePath.c_str()), size});
+    }
+  }
+
+  showFileNames = options.fileNames < 0
+                      ? (files.size() > 1 || options.recursive)
+                      : options.fileNames == 1;
+
+  QList<Task> tasks;
+  for (const auto &[name, size] : files) {
+    // files that report no size (/proc, pipes) are read as a single chunk
+    if (size <= chunkSize) {
+      tasks.append({name, 0, -1, true});
+      continue;
+    }
+
+    for (qint64 begin = 0; begin < size; begin += chunkSize) {
+      qint64 end = begin + chunkSize;
+      bool last = end >= size;
+      tasks.append({name, begin, last ? qint64(-1) : end, last});
+    }
+  }
+
+  return tasks;
+}
+
+// Runs on a pool thread
+void GrepSearch::searchChunk(const Task &task, ChunkResult &result) const {
+  MappedFile file(QFile::encodeName(task.fileName).constData());
+  if (!file.isValid()) {
+    result.error = QString("grep: %1: %2")
+                       .arg(task.fileName,
+                            QString::fromLocal8Bit(std::strerror(file.error())));
+    return;
+  }
+
+  const char *data = file.data();
+  qint64 size = file.size();
+  qint64 begin = qMin(task.begin, size);
+  qint64 end = task.end < 0 ? size : qMin(task.end, size);
+
+  // a chunk owns the lines that start inside it
+  if (begin > 0) {
+    const void *newline = std::memchr(data + begin - 1, '\n', size - begin + 1);
+    begin = newline ? static_cast<const char *>(newline) - data + 1 : size;
+  }
+  if (end > 0 && end < size) {
+    const void *newline = std::memchr(data + end - 1, '\n', size - end + 1);
+    end = newline ? static_cast<const char *>(newline) - data + 1 : size;
+  }
+
+  if (task.begin == 0) {
+    result.binary =
+        std::memchr(data, '\0', qMin(size, binaryProbeSize)) != nullptr;
+  }
+
+  if (begin >= end) {
+    return;
+  }
+
+  if (literal) {
+    searchLiteral(data + begin, data + end, result);
+  } else {
+    searchRegex(data + begin, data + end, result);
+  }
+
+  if (options.lineNumbers) {
+    result.newlines = TextScan::countNewlines(data + begin, end - begin);
+  }
+}
+
+// Converts a selected line and its byte ranges into display text and spans
+void GrepSearch::addLine(ChunkResult &result, qint64 line, const char *start,
+                         qint64 length,
+                         const QList<QPair<qint64, qint64>> &hits) const {
+  result.selected++;
+  if (options.countOnly || options.filesWithMatches) {
+    return;
+  }
+
+  // drop the carriage return of CRLF files
+  if (length > 0 && start[length - 1] == '\r') {
+    length--;
+  }
+
+  LineMatch match;
+  match.line = line;
+  match.text = QString::fromUtf8(start, length);
+
+  // byte offsets equal UTF-16 offsets on ASCII lines
+  bool ascii = match.text.size() == length;
+  for (const auto &[offset, hitLength] : hits) {
+    if (offset >= length) {
+      continue;
+    }
+
+    qint64 hitEnd = qMin(offset + hitLength, length);
+    int from = ascii ? offset : QString::fromUtf8(start, offset).size();
+    int to = ascii ? hitEnd : QString::fromUtf8(start, hitEnd).size();
+    match.spans.append({from, to - from, OutputSpan::Match});
+  }
+
+  result.matches.append(match);
+}
+
+void GrepSearch::searchLiteral(const char *begin, const char *end,
+                               ChunkResult &result) const {
+  const char *cursor = begin;
+  const char *counted = begin; // line numbers are counted up to here
+  qint64 line = 0;
+
+  while (cursor < end) {
+    const char *lineEnd = nullptr;
+    const char *lineStart = cursor;
+
+    if (options.invert) {
+      // every line is visited, only lines without a hit are selected
+      lineEnd = static_cast<const char *>(std::memchr(cursor, '\n', end - cursor));
+      const char *stop = lineEnd ? lineEnd : end;
+
+      if (!TextScan::findLiteral(cursor, stop - cursor, needle.constData(),
+                                 needle.size())) {
+        addLine(result, line, cursor, stop - cursor, {});
+      }
+
+      line++;
+      cursor = lineEnd ? lineEnd + 1 : end;
+      continue;
+    }
+
+    // jump straight to the next hit, lines in between are never looked at
+    const char *hit = TextScan::findLiteral(cursor, end - cursor,
+                                            needle.constData(), needle.size());
+    if (!hit) {
+      break;
+    }
+
+    const void *previous = ::memrchr(cursor, '\n', hit - cursor);
+    lineStart = previous ? static_cast<const char *>(previous) + 1 : cursor;
+    lineEnd = static_cast<const char *>(std::memchr(hit, '\n', end - hit));
+    const char *stop = lineEnd ? lineEnd : end;
+
+    if (options.lineNumbers) {
+      line += TextScan::countNewlines(counted, lineStart - counted);
+      counted = lineStart;
+    }
+
+    // every occurrence on the line is highlighted
+    QList<QPair<qint64, qint64>> hits;
+    const char *next = hit;
+    while (next) {
+      hits.append({next - lineStart, qint64(needle.size())});
+      next = TextScan::findLiteral(next + needle.size(),
+                                   stop - next - needle.size(),
+                                   needle.constData(), needle.size());
+    }
+
+    addLine(result, line, lineStart, stop - lineStart, hits);
+    cursor = lineEnd ? lineEnd + 1 : end;
+  }
+}
+
+void GrepSearch::searchRegex(const char *begin, const char *end,
+                             ChunkResult &result) const {
+  // a private instance per task, matching state is not shared
+  QRegularExpression regex(regexPattern, regexOptions);
+
+  const char *cursor = begin;
+  qint64 line = 0;
+
+  while (cursor < end) {
+    const char *lineEnd =
+        static_cast<const char *>(std::memchr(cursor, '\n', end - cursor));
+    const char *stop = lineEnd ? lineEnd : end;
+    qint64 length = stop - cursor;
+    if (length > 0 && cursor[length - 1] == '\r') {
+      length--;
+    }
+
+    QString text = QString::fromUtf8(cursor, length);
+    QRegularExpressionMatchIterator iterator = regex.globalMatch(text);
+    bool matched = iterator.hasNext();
+
+    if (matched != options.invert) {
+      result.selected++;
+
+      if (!options.countOnly && !options.filesWithMatches) {
+        LineMatch match;
+        match.line = line;
+        match.text = text;
+
+        while (iterator.hasNext()) {
+          QRegularExpressionMatch found = iterator.next();
+          if (found.capturedLength() > 0) {
+            match.spans.append({int(found.capturedStart()),
+                                int(found.capturedLength()),
+                                OutputSpan::Match});
+          }
+        }
+
+        result.matches.append(match);
+      }
+    }
+
+    line++;
+    cursor = lineEnd ? lineEnd + 1 : end;
+  }
+}
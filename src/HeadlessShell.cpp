@@ -0,0 +1,243 @@
+#include "HeadlessShell.h"
+#include "ScriptInterpreter.h"
+#include <QEventLoop>
+#include <QStringList>
+#include <algorithm>
+#include <cstdio>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+// Create the engine and route its output to the standard streams
+HeadlessShell::HeadlessShell(QObject *parent)
+    : QObject(parent), out(stdout), err(stderr) {
+  processManager = new ProcessManager(this);
+
+  connect(processManager, &ProcessManager::processOutputReady, this,
+          &HeadlessShell::writeOutput);
+  connect(processManager, &ProcessManager::processHighlightedOutputReady, this,
+          &HeadlessShell::writeHighlightedOutput);
+  connect(processManager, &ProcessManager::processErrorReady, this,
+          &HeadlessShell::writeError);
+  connect(processManager, &ProcessManager::pinnedRegionUpdated, this,
+          &HeadlessShell::updateRegion);
+  connect(processManager, &ProcessManager::pinnedRegionClosed, this,
+          [this]() { region.clear(); });
+
+  colorOutput = isatty(STDOUT_FILENO);
+  progressOutput = isatty(STDERR_FILENO);
+  connect(processManager, &ProcessManager::progressChanged, this,
+          &HeadlessShell::showProgress);
+
+  // ls lays out columns only on a terminal
+  winsize size{};
+  if (colorOutput && ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0) {
+    processManager->setTerminalColumns(size.ws_col > 0 ? size.ws_col : 80);
+  }
+  connect(processManager, &ProcessManager::processFinished, this,
+          &HeadlessShell::finishLine);
+}
+
+HeadlessShell::~HeadlessShell() { finishLine(); }
+
+int HeadlessShell::runCommand(const QString &commandLine) {
+  // builtins finish synchronously, child processes need the event loop
+  bool finished = false;
+  QEventLoop loop;
+  QMetaObject::Connection done =
+      connect(processManager, &ProcessManager::processFinished, &loop,
+              [&](int status) {
+                finished = true;
+                exitCode = status;
+                loop.quit();
+              });
+
+  processManager->startProcess(commandLine);
+
+  if (!finished) {
+    loop.exec();
+  }
+
+  disconnect(done);
+
+  return exitCode;
+}
+
+int HeadlessShell::runScript(QTextStream &input) {
+  exitCode = processManager->scriptInterpreter()->runSource(input.readAll());
+  finishLine();
+
+  return exitCode;
+}
+
+int HeadlessShell::runFile(const QString &path, const QStringList &args) {
+  exitCode = processManager->scriptInterpreter()->runFile(path, args);
+  finishLine();
+
+  return exitCode;
+}
+
+// Output is written as produced, errors are complete messages
+void HeadlessShell::writeOutput(QString output) {
+  if (output.isEmpty()) {
+    return;
+  }
+
+  clearProgress();
+  out << output;
+  atLineStart = output.endsWith('\n');
+}
+
+void HeadlessShell::writeHighlightedOutput(QString output,
+                                           QList<OutputSpan> highlights) {
+  if (!colorOutput || highlights.isEmpty()) {
+    writeOutput(output);
+    return;
+  }
+
+  // same colors as grep --color and ls --color: red bold matches, magenta
+  // labels, bold blue directories
+  QString colored;
+  int position = 0;
+  for (const OutputSpan &span : highlights) {
+    colored += output.mid(position, span.start - position);
+    colored += span.role == OutputSpan::Match   ? "\x1b[01;31m"
+               : span.role == OutputSpan::Label ? "\x1b[35m"
+                                                : "\x1b[01;34m";
+    colored += output.mid(span.start, span.length);
+    colored += "\x1b[0m";
+    position = span.start + span.length;
+  }
+  colored += output.mid(position);
+
+  writeOutput(colored);
+}
+
+void HeadlessShell::writeError(QString error) {
+  if (error.isEmpty()) {
+    return;
+  }
+
+  clearProgress();
+
+  // keep error messages off a partially written output line
+  if (!atLineStart) {
+    out << '\n';
+    atLineStart = true;
+  }
+  out.flush();
+
+  err << error;
+  if (!error.endsWith('\n')) {
+    err << '\n';
+  }
+  err.flush();
+}
+
+// Changed characters in reverse video, like watch -d
+static QString regionLine(const WatchLine &line) {
+  QString text;
+  int position = 0;
+  for (const OutputSpan &span : line.highlights) {
+    text += line.text.mid(position, span.start - position);
+    text += "\x1b[7m";
+    text += line.text.mid(span.start, span.length);
+    text += "\x1b[0m";
+    position = span.start + span.length;
+  }
+  text += line.text.mid(position);
+  return text;
+}
+
+void HeadlessShell::updateRegion(int lineCount, QList<WatchLine> lines) {
+  if (!atLineStart) {
+    out << '\n';
+    atLineStart = true;
+  }
+
+  // a pipe or file gets every screen in full
+  if (!colorOutput) {
+    region.resize(lineCount);
+    for (const WatchLine &line : lines) {
+      region[line.row] = line.text;
+    }
+    out << region.join('\n') << '\n';
+    out.flush();
+    return;
+  }
+
+  // the cursor sits below the region, go back to its first line
+  QString update;
+  if (!region.isEmpty()) {
+    update += QString("\x1b[%1A").arg(region.size());
+  }
+
+  auto next = lines.cbegin();
+  int rows = std::max<int>(lineCount, region.size());
+  for (int row = 0; row < rows; row++) {
+    bool changed = next != lines.cend() && next->row == row;
+
+    if (row >= lineCount) {
+      update += "\x1b[2K\x1b[1B"; // removed line
+    } else if (row >= region.size()) {
+      update += regionLine(*next) + "\n"; // new line at the bottom
+    } else if (changed) {
+      update += "\x1b[2K" + regionLine(*next) + "\r\x1b[1B";
+    } else {
+      update += "\x1b[1B"; // unchanged, skip over it
+    }
+
+    if (changed) {
+      ++next;
+    }
+  }
+
+  if (region.size() > lineCount) {
+    update += QString("\x1b[%1A").arg(region.size() - lineCount);
+  }
+
+  region.resize(lineCount);
+  for (const WatchLine &line : lines) {
+    region[line.row] = line.text;
+  }
+
+  out << update;
+  out.flush();
+}
+
+void HeadlessShell::showProgress(QString progress) {
+  if (!progressOutput) {
+    return;
+  }
+
+  // the status line sits below the output and is rewritten in place
+  out.flush();
+  if (!atLineStart) {
+    out << '\n';
+    atLineStart = true;
+    out.flush();
+  }
+  err << "\r\x1b[2K" << progress;
+  err.flush();
+  progressShown = !progress.isEmpty();
+}
+
+void HeadlessShell::clearProgress() {
+  if (!progressShown) {
+    return;
+  }
+
+  err << "\r\x1b[2K";
+  err.flush();
+  progressShown = false;
+}
+
+// Commands always leave the terminal at the start of a line
+void HeadlessShell::finishLine() {
+  if (!atLineStart) {
+    out << '\n';
+    atLineStart = true;
+  }
+
+  out.flush();
+  err.flush();
+}
@@ -0,0 +1,142 @@
+#include "InputLine.h"
+#include "TextWidth.h"
+#include "Trace.h"
+#include <QPainter>
+#include <QStyle>
+#include <QStyleOption>
+#include <algorithm>
+
+// Width of the block cursor, like the terminal cursor used to be
+static constexpr int cursorWidth = 8;
+
+// Horizontal padding, matches the document margin of the output area
+static constexpr int padding = 4;
+
+static int columns(const QString &text, int start = 0, int length = -1) {
+  return TextWidth::displayWidth(
+      reinterpret_cast<const char16_t *>(text.utf16()) + start,
+      length < 0 ? text.size() - start : length);
+}
+
+InputLine::InputLine(QWidget *parent) : QWidget(parent) {
+  setFocusPolicy(Qt::StrongFocus);
+  setAttribute(Qt::WA_OpaquePaintEvent);
+  setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
+}
+
+void InputLine::setPrompt(const QList<PromptPart> &parts) {
+  prompt = parts;
+  update();
+}
+
+void InputLine::setText(const QString &lineText, int lineCursor) {
+  text = lineText;
+  cursor = lineCursor;
+
+  // newlines of pasted text are shown as one column
+  text.replace('\n', QChar(0x21B5));
+
+  // measured once per edit, painting only looks at the visible part
+  cursorColumns = columns(text, 0, cursor);
+  textColumns = cursorColumns + columns(text, cursor);
+  update();
+}
+
+QSize InputLine::sizeHint() const {
+  return QSize(QWidget::sizeHint().width(),
+               fontMetrics().height() + 2 * padding);
+}
+
+QSize InputLine::minimumSizeHint() const { return sizeHint(); }
+
+void InputLine::paintEvent(QPaintEvent * /*event*/) {
+  QSHELL_TRACE_SCOPE(scope, "InputLine::paint");
+  QPainter painter(this);
+
+  // background from the style sheet (#inputLine)
+  QStyleOption option;
+  option.initFrom(this);
+  painter.fillRect(rect(), palette().color(QPalette::Window));
+  style()->drawPrimitive(QStyle::PE_Widget, &option, &painter, this);
+
+  int cell = std::max(1, fontMetrics().horizontalAdvance(QChar('M')));
+  int visibleColumns = std::max(1, (width() - 2 * padding - cursorWidth) / cell);
+
+  int promptColumns = 0;
+  for (const PromptPart &part : prompt) {
+    promptColumns += columns(part.text);
+  }
+  int cursorColumn = promptColumns + cursorColumns;
+
+  // keep the cursor in view, scroll back as far as possible
+  if (cursorColumn < scrollColumn) {
+    scrollColumn = cursorColumn;
+  } else if (cursorColumn >= scrollColumn + visibleColumns) {
+    scrollColumn = cursorColumn - visibleColumns + 1;
+  }
+  if (promptColumns + textColumns < visibleColumns) {
+    scrollColumn = 0;
+  }
+
+  int baseline = padding + fontMetrics().ascent();
+  int column = -scrollColumn;
+  QColor textColor = palette().color(QPalette::WindowText);
+
+  QFont bold = font();
+  bold.setBold(true);
+
+  painter.setFont(bold);
+  for (const PromptPart &part : prompt) {
+    painter.setPen(part.color.isEmpty() ? textColor : QColor(part.color));
+    painter.drawText(padding + column * cell, baseline, part.text);
+    column += columns(part.text);
+  }
+
+  // only the visible slice of the text is drawn, a pasted megabyte line
+  // costs the same as a short one
+  int start = 0;
+  int startColumn = 0;
+  visibleText(visibleColumns, std::max(0, scrollColumn - promptColumns),
+              &start, &startColumn);
+  const char16_t *characters =
+      reinterpret_cast<const char16_t *>(text.utf16()) + start;
+  int length = int(TextWidth::fitColumns(characters, text.size() - start,
+                                         visibleColumns + 1));
+
+  painter.setFont(font());
+  painter.setPen(textColor);
+  painter.drawText(padding + (column + startColumn) * cell, baseline,
+                   text.mid(start, length));
+
+  // translucent block, the character under it stays readable
+  QColor cursorColor = textColor;
+  cursorColor.setAlpha(160);
+  painter.fillRect(padding + (cursorColumn - scrollColumn) * cell, padding,
+                   cursorWidth, fontMetrics().height(), cursorColor);
+}
+
+void InputLine::visibleText(int visibleColumns, int firstColumn, int *start,
+                            int *startColumn) const {
+  const char16_t *characters =
+      reinterpret_cast<const char16_t *>(text.utf16());
+
+  // the cursor is in view, so the visible text begins shortly before it
+  int from = std::max(0, cursor - 4 * visibleColumns);
+  if (from > 0 && text.at(from).isLowSurrogate()) {
+    from--;
+  }
+  int fromColumn = cursorColumns - columns(text, from, cursor - from);
+
+  // zero width characters pushed the window start too far right
+  if (fromColumn > firstColumn) {
+    from = 0;
+    fromColumn = 0;
+  }
+
+  int skipped = 0;
+  *start = from + int(TextWidth::fitColumns(characters + from,
+                                            text.size() - from,
+                                            firstColumn - fromColumn,
+                                            &skipped));
+  *startColumn = fromColumn + skipped;
+}
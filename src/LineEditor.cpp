@@ -0,0 +1,228 @@
+#include "LineEditor.h"
+#include "TextWidth.h"
+#include <algorithm>
+
+// Kills kept for yank-pop
+static constexpr int killRingSize = 16;
+
+// Text examined around the cursor to find a cluster boundary
+static constexpr int clusterWindow = 32;
+
+static QString toQString(const std::u16string &text) {
+  return QString::fromUtf16(text.data(), qsizetype(text.size()));
+}
+
+QString LineEditor::text() const { return toQString(buffer.text()); }
+
+int LineEditor::cursor() const { return int(buffer.cursor()); }
+
+bool LineEditor::isEmpty() const { return buffer.size() == 0; }
+
+void LineEditor::setText(const QString &text) {
+  startCommand(Other);
+  buffer.clear();
+  insert(text);
+}
+
+void LineEditor::clear() {
+  startCommand(Other);
+  buffer.clear();
+}
+
+void LineEditor::insert(const QString &text) {
+  startCommand(Other);
+  buffer.insert(reinterpret_cast<const char16_t *>(text.utf16()),
+                std::size_t(text.size()));
+}
+
+void LineEditor::forwardChar() {
+  startCommand(Other);
+  buffer.moveTo(nextCluster(cursor()));
+}
+
+void LineEditor::backwardChar() {
+  startCommand(Other);
+  buffer.moveTo(previousCluster(cursor()));
+}
+
+void LineEditor::forwardWord() {
+  startCommand(Other);
+  int position = cursor();
+  int size = int(buffer.size());
+
+  while (position < size && !isWordChar(position)) {
+    position++;
+  }
+  while (position < size && isWordChar(position)) {
+    position++;
+  }
+  buffer.moveTo(position);
+}
+
+void LineEditor::backwardWord() {
+  startCommand(Other);
+  int position = cursor();
+
+  while (position > 0 && !isWordChar(position - 1)) {
+    position--;
+  }
+  while (position > 0 && isWordChar(position - 1)) {
+    position--;
+  }
+  buffer.moveTo(position);
+}
+
+void LineEditor::beginningOfLine() {
+  startCommand(Other);
+  buffer.moveTo(0);
+}
+
+void LineEditor::endOfLine() {
+  startCommand(Other);
+  buffer.moveTo(buffer.size());
+}
+
+void LineEditor::deleteChar() {
+  startCommand(Other);
+  int position = cursor();
+  buffer.erase(position, nextCluster(position) - position);
+}
+
+void LineEditor::backwardDeleteChar() {
+  startCommand(Other);
+  int position = cursor();
+  int start = previousCluster(position);
+  buffer.erase(start, position - start);
+}
+
+void LineEditor::killLine() { kill(cursor(), int(buffer.size()), false); }
+
+void LineEditor::unixLineDiscard() { kill(0, cursor(), true); }
+
+void LineEditor::unixWordRubout() {
+  int position = cursor();
+
+  while (position > 0 && buffer.at(position - 1) == u' ') {
+    position--;
+  }
+  while (position > 0 && buffer.at(position - 1) != u' ') {
+    position--;
+  }
+  kill(position, cursor(), true);
+}
+
+void LineEditor::backwardKillWord() {
+  int position = cursor();
+
+  while (position > 0 && !isWordChar(position - 1)) {
+    position--;
+  }
+  while (position > 0 && isWordChar(position - 1)) {
+    position--;
+  }
+  kill(position, cursor(), true);
+}
+
+void LineEditor::killWord() {
+  int position = cursor();
+  int size = int(buffer.size());
+
+  while (position < size && !isWordChar(position)) {
+    position++;
+  }
+  while (position < size && isWordChar(position)) {
+    position++;
+  }
+  kill(cursor(), position, false);
+}
+
+void LineEditor::yank() {
+  if (killRing.isEmpty()) {
+    startCommand(Other);
+    return;
+  }
+
+  startCommand(Yank);
+  yankIndex = 0;
+  yankStart = cursor();
+  yankLength = int(killRing.first().size());
+  buffer.insert(reinterpret_cast<const char16_t *>(killRing.first().utf16()),
+                std::size_t(yankLength));
+}
+
+void LineEditor::yankPop() {
+  if (lastCommand != Yank || killRing.size() < 2) {
+    startCommand(Other);
+    return;
+  }
+
+  // replace the yanked text with the next older kill
+  yankIndex = (yankIndex + 1) % int(killRing.size());
+  const QString &older = killRing[yankIndex];
+
+  buffer.erase(yankStart, yankLength);
+  buffer.insert(reinterpret_cast<const char16_t *>(older.utf16()),
+                std::size_t(older.size()));
+  yankLength = int(older.size());
+}
+
+void LineEditor::startCommand(Command command) { lastCommand = command; }
+
+void LineEditor::kill(int start, int end, bool backward) {
+  if (start >= end) {
+    startCommand(Kill);
+    return;
+  }
+
+  QString killed = toQString(buffer.slice(start, end - start));
+  buffer.erase(start, end - start);
+
+  // consecutive kills build one entry, like readline
+  if (lastCommand == Kill && !killRing.isEmpty()) {
+    killRing.first() =
+        backward ? killed + killRing.first() : killRing.first() + killed;
+  } else {
+    killRing.prepend(killed);
+    if (killRing.size() > killRingSize) {
+      killRing.removeLast();
+    }
+  }
+
+  startCommand(Kill);
+}
+
+int LineEditor::nextCluster(int position) const {
+  int size = int(buffer.size());
+  if (position >= size) {
+    return size;
+  }
+
+  std::u16string window = buffer.slice(position, clusterWindow);
+  return position +
+         int(TextWidth::nextGrapheme(window.data(), window.size(), 0));
+}
+
+int LineEditor::previousCluster(int position) const {
+  if (position <= 0) {
+    return 0;
+  }
+
+  // walk the clusters of a window ending at position
+  int start = std::max(0, position - clusterWindow);
+  if (start > 0 && buffer.at(start) >= 0xDC00 && buffer.at(start) <= 0xDFFF) {
+    start--; // don't begin inside a surrogate pair
+  }
+
+  std::u16string window = buffer.slice(start, position - start);
+  std::size_t offset = 0;
+  std::size_t previous = 0;
+  while (offset < window.size()) {
+    previous = offset;
+    offset = TextWidth::nextGrapheme(window.data(), window.size(), offset);
+  }
+  return start + int(previous);
+}
+
+bool LineEditor::isWordChar(int position) const {
+  return QChar(buffer.at(position)).isLetterOrNumber();
+}
@@ -0,0 +1,167 @@
+#include "LineIndex.h"
+#include "TextScan.h"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Bytes the builder reads at a time, all the memory it holds
+static constexpr std::size_t blockSize = 1 << 20;
+
+// Line length assumed before anything is indexed
+static constexpr double defaultLineLength = 80;
+
+LineIndex::LineIndex(const std::string &path, const char *data,
+                     std::size_t size)
+    : data(data), size(size), checkpoints{0} {
+  builder = std::thread([this, path]() { build(path); });
+}
+
+LineIndex::~LineIndex() {
+  stopping = true;
+  builder.join();
+}
+
+bool LineIndex::isComplete() const { return complete; }
+
+std::size_t LineIndex::indexedBytes() const { return scannedBytes; }
+
+std::size_t LineIndex::lineCount() const {
+  if (size == 0) {
+    return 0;
+  }
+  if (complete) {
+    return scannedLines + (data[size - 1] != '\n');
+  }
+  return std::max(scannedLines.load(), std::size_t(size / bytesPerLine()));
+}
+
+std::size_t LineIndex::lineOffset(std::size_t line, bool *exact) const {
+  bool indexed = complete || line <= scannedLines;
+  if (exact) {
+    *exact = indexed;
+  }
+
+  Checkpoint checkpoint;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::size_t k = std::min(line / stride, checkpoints.size() - 1);
+    checkpoint = {k * stride, std::size_t(checkpoints[k])};
+  }
+
+  if (indexed) {
+    // at most stride lines from the checkpoint
+    std::size_t offset = checkpoint.offset;
+    for (std::size_t i = checkpoint.line; i < line; i++) {
+      const void *found = std::memchr(data + offset, '\n', size - offset);
+      if (!found) {
+        return size;
+      }
+      offset = static_cast<const char *>(found) - data + 1;
+    }
+    return offset;
+  }
+
+  // estimated, then moved back to the start of the line it falls in
+  double estimate = double(checkpoint.offset) +
+                    double(line - checkpoint.line) * bytesPerLine();
+  std::size_t offset = std::size_t(std::min(estimate, double(size)));
+  const void *newline = offset ? ::memrchr(data, '\n', offset) : nullptr;
+  return newline ? static_cast<const char *>(newline) - data + 1 : 0;
+}
+
+std::size_t LineIndex::lineNumber(std::size_t offset, bool *exact) const {
+  offset = std::min(offset, size);
+  bool indexed = complete || offset < scannedBytes;
+  if (exact) {
+    *exact = indexed;
+  }
+
+  if (!indexed) {
+    Checkpoint checkpoint = lastCheckpoint();
+    return checkpoint.line +
+           std::size_t(double(offset - checkpoint.offset) / bytesPerLine());
+  }
+
+  Checkpoint checkpoint;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto after = std::upper_bound(checkpoints.begin(), checkpoints.end(),
+                                  std::uint64_t(offset));
+    std::size_t k = std::size_t(after - checkpoints.begin()) - 1;
+    checkpoint = {k * stride, std::size_t(checkpoints[k])};
+  }
+
+  return checkpoint.line +
+         TextScan::countNewlines(data + checkpoint.offset,
+                                 offset - checkpoint.offset);
+}
+
+LineIndex::Checkpoint LineIndex::lastCheckpoint() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return {(checkpoints.size() - 1) * stride,
+          std::size_t(checkpoints.back())};
+}
+
+double LineIndex::bytesPerLine() const {
+  std::size_t lines = scannedLines;
+  if (lines == 0) {
+    return defaultLineLength;
+  }
+  return std::max(1.0, double(scannedBytes) / double(lines));
+}
+
+void LineIndex::build(const std::string &path) {
+  // reading with a buffer of our own keeps the mapping (and the resident
+  // size) down to what is on screen
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd >= 0) {
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+  }
+  std::vector<char> buffer(fd >= 0 ? blockSize : 0);
+
+  std::size_t lines = 0;
+  std::size_t nextLine = stride;
+  std::size_t base = 0;
+
+  while (base < size && !stopping) {
+    std::size_t length = std::min(blockSize, size - base);
+    const char *block = data + base;
+
+    if (fd >= 0) {
+      ssize_t got = ::pread(fd, buffer.data(), length, off_t(base));
+      if (got <= 0) {
+        break; // the file shrank, what was read stays indexed
+      }
+      length = std::size_t(got);
+      block = buffer.data();
+    }
+
+    // most blocks hold no checkpoint, counting them is enough
+    std::size_t count = TextScan::countNewlines(block, length);
+    if (lines + count < nextLine) {
+      lines += count;
+    } else {
+      const char *position = block;
+      const char *end = block + length;
+      while (const void *found = std::memchr(position, '\n', end - position)) {
+        position = static_cast<const char *>(found) + 1;
+        if (++lines == nextLine) {
+          std::lock_guard<std::mutex> lock(mutex);
+          checkpoints.push_back(base + (position - block));
+          nextLine += stride;
+        }
+      }
+    }
+
+    // checkpoints are published before the counters that make them used
+    base += length;
+    scannedLines = lines;
+    scannedBytes = base;
+  }
+
+  if (fd >= 0) {
+    ::close(fd);
+  }
+  complete = base >= size;
+}
@@ -0,0 +1,79 @@
+#include "MappedFile.h"
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const char *path, Access access) {
+  int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    errorCode = errno;
+    return;
+  }
+
+  struct stat info;
+  if (::fstat(fd, &info) != 0) {
+    errorCode = errno;
+    ::close(fd);
+    return;
+  }
+
+  if (S_ISDIR(info.st_mode)) {
+    directory = true;
+    errorCode = EISDIR;
+    ::close(fd);
+    return;
+  }
+
+  // regular files are mapped directly
+  if (S_ISREG(info.st_mode) && info.st_size > 0) {
+    void *region = ::mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (region != MAP_FAILED) {
+      ::madvise(region, info.st_size,
+                access == Sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+      mapping = static_cast<const char *>(region);
+      length = info.st_size;
+      mapped = true;
+      ::close(fd);
+      return;
+    }
+  }
+
+  // pipes, /proc files and friends: read until end of file
+  char chunk[65536];
+  while (true) {
+    ssize_t bytes = ::read(fd, chunk, sizeof(chunk));
+    if (bytes < 0 && errno == EINTR) {
+      continue;
+    }
+    if (bytes < 0) {
+      errorCode = errno;
+      break;
+    }
+    if (bytes == 0) {
+      break;
+    }
+    buffer.insert(buffer.end(), chunk, chunk + bytes);
+  }
+
+  mapping = buffer.data();
+  length = buffer.size();
+  ::close(fd);
+}
+
+MappedFile::~MappedFile() {
+  if (mapped) {
+    ::munmap(const_cast<char *>(mapping), length);
+  }
+}
+
+bool MappedFile::isValid() const { return errorCode == 0; }
+
+int MappedFile::error() const { return errorCode; }
+
+bool MappedFile::isDirectory() const { return directory; }
+
+const char *MappedFile::data() const { return mapping; }
+
+std::size_t MappedFile::size() const { return length; }
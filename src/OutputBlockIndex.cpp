@@ -0,0 +1,101 @@
+#include "OutputBlockIndex.h"
+#include <QDateTime>
+#include <algorithm>
+
+int OutputBlockIndex::begin(const QString &command, qint64 start,
+                            qint64 outputStart, const QString &directory) {
+  OutputBlock block;
+  block.command = command;
+  block.directory = directory;
+  block.start = start;
+  block.outputStart = outputStart;
+  block.end = outputStart;
+  block.startTime = QDateTime::currentMSecsSinceEpoch();
+  blocks.append(block);
+  return int(blocks.size()) - 1;
+}
+
+void OutputBlockIndex::extend(qint64 end, qint64 bytes) {
+  if (blocks.isEmpty()) {
+    return;
+  }
+
+  OutputBlock &block = blocks.last();
+  block.end = std::max(block.end, end);
+  block.bytes += bytes;
+}
+
+void OutputBlockIndex::setDirectory(const QString &directory) {
+  if (blocks.isEmpty() || blocks.last().exitCode >= 0) {
+    return;
+  }
+
+  blocks.last().directory = directory;
+}
+
+void OutputBlockIndex::finish(int exitCode) {
+  if (blocks.isEmpty() || blocks.last().exitCode >= 0) {
+    return;
+  }
+
+  blocks.last().exitCode = exitCode;
+  blocks.last().endTime = QDateTime::currentMSecsSinceEpoch();
+}
+
+void OutputBlockIndex::append(const OutputBlock &block) {
+  blocks.append(block);
+}
+
+int OutputBlockIndex::count() const { return int(blocks.size()); }
+
+const OutputBlock &OutputBlockIndex::block(int index) const {
+  return blocks[index];
+}
+
+void OutputBlockIndex::setFolded(int index, bool folded) {
+  blocks[index].folded = folded;
+}
+
+void OutputBlockIndex::clear() { blocks.clear(); }
+
+int OutputBlockIndex::blockAt(qint64 offset) const {
+  int index = upperBound(offset) - 1;
+  if (index < 0 || offset > blocks[index].end) {
+    return -1;
+  }
+  return index;
+}
+
+int OutputBlockIndex::next(qint64 offset) const {
+  int index = upperBound(offset);
+  return index < blocks.size() ? index : -1;
+}
+
+int OutputBlockIndex::previous(qint64 offset) const {
+  // blocks starting at offset don't count, upperBound includes them
+  return upperBound(offset - 1) - 1;
+}
+
+qint64 OutputBlockIndex::utf8Length(const QString &text) {
+  qint64 length = 0;
+  for (QChar character : text) {
+    ushort unit = character.unicode();
+    if (unit < 0x80) {
+      length += 1;
+    } else if (unit < 0x800) {
+      length += 2;
+    } else if (character.isSurrogate()) {
+      length += 2; // half of a 4 byte sequence
+    } else {
+      length += 3;
+    }
+  }
+  return length;
+}
+
+int OutputBlockIndex::upperBound(qint64 offset) const {
+  auto position = std::upper_bound(
+      blocks.cbegin(), blocks.cend(), offset,
+      [](qint64 value, const OutputBlock &block) { return value < block.start; });
+  return int(position - blocks.cbegin());
+}
@@ -0,0 +1,155 @@
+#include "OutputClassifier.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <algorithm>
+
+namespace OutputClassifier {
+namespace {
+
+// Longer lines (minified data, base64) are only scanned this far
+constexpr int maxLineLength = 2000;
+
+// Punctuation that ends a sentence rather than a URL or path
+const QString trailingPunctuation = ".,;:!?)]}'\"";
+
+const QRegularExpression &urlPattern() {
+  static const QRegularExpression pattern(
+      "\\b(?:https?|ftp|file)://[^\\s<>\"'`]+");
+  return pattern;
+}
+
+// file.ext:line[:column], the extension keeps times (12:30:45) out
+const QRegularExpression &locationPattern() {
+  static const QRegularExpression pattern(
+      "(?<![\\w./~-])(?:[\\w.~-]*/)*[\\w.-]*\\w\\.[A-Za-z]\\w*:\\d+(?::\\d+)?");
+  return pattern;
+}
+
+// compiler diagnostic severity following a location: ': error: message'
+const QRegularExpression &diagnosticPattern() {
+  static const QRegularExpression pattern(
+      ":\\s*(?:(fatal error|error)|(warning)):",
+      QRegularExpression::CaseInsensitiveOption);
+  return pattern;
+}
+
+const QRegularExpression &pathPattern() {
+  static const QRegularExpression pattern(
+      "(?<![\\w./~:-])(?:~|\\.{1,2})?(?:/[\\w.@+-]+)+/?|"
+      "(?<![\\w./~:-])[\\w.@+-]+(?:/[\\w.@+-]+)+/?");
+  return pattern;
+}
+
+const QRegularExpression &severityPattern() {
+  static const QRegularExpression pattern(
+      "\\b(?:(error|errors|fatal|failed|failure)|(warning|warnings))\\b",
+      QRegularExpression::CaseInsensitiveOption);
+  return pattern;
+}
+
+bool overlaps(const QList<OutputSpan> &spans, int start, int length) {
+  for (const OutputSpan &span : spans) {
+    if (start < span.start + span.length && span.start < start + length) {
+      return true;
+    }
+  }
+  return false;
+}
+
+int trimmedLength(const QString &line, int start, int length) {
+  while (length > 0 && trailingPunctuation.contains(line[start + length - 1])) {
+    length--;
+  }
+  return length;
+}
+
+} // namespace
+
+QList<OutputSpan> classify(const QString &text, const QString &cwd) {
+  QList<OutputSpan> spans;
+  if (text.trimmed().isEmpty()) {
+    return spans;
+  }
+
+  const QString line = text.left(maxLineLength);
+
+  // URLs first, they contain everything else
+  QRegularExpressionMatchIterator urls = urlPattern().globalMatch(line);
+  while (urls.hasNext()) {
+    QRegularExpressionMatch match = urls.next();
+    int length = trimmedLength(line, match.capturedStart(), match.capturedLength());
+    spans.append({int(match.capturedStart()), length, OutputSpan::Url});
+  }
+
+  // source locations, a diagnostic colors its message by severity
+  QRegularExpressionMatchIterator locations =
+      locationPattern().globalMatch(line);
+  while (locations.hasNext()) {
+    QRegularExpressionMatch match = locations.next();
+    int start = match.capturedStart();
+    int length = match.capturedLength();
+    if (overlaps(spans, start, length)) {
+      continue;
+    }
+    spans.append({start, length, OutputSpan::Location});
+
+    QRegularExpressionMatch diagnostic = diagnosticPattern().match(
+        line, start + length, QRegularExpression::NormalMatch,
+        QRegularExpression::AnchorAtOffsetMatchOption);
+    if (diagnostic.hasMatch()) {
+      bool error = diagnostic.capturedStart(1) >= 0;
+      int messageStart = diagnostic.capturedStart(error ? 1 : 2);
+      spans.append({messageStart, int(line.size()) - messageStart,
+                    error ? OutputSpan::Error : OutputSpan::Warning});
+    }
+  }
+
+  // paths only if they exist, checked here on the worker thread
+  QRegularExpressionMatchIterator paths = pathPattern().globalMatch(line);
+  while (paths.hasNext()) {
+    QRegularExpressionMatch match = paths.next();
+    int start = match.capturedStart();
+    int length = trimmedLength(line, start, match.capturedLength());
+    if (length == 0 || overlaps(spans, start, length)) {
+      continue;
+    }
+
+    if (QFileInfo::exists(filePath(line.mid(start, length), cwd))) {
+      spans.append({start, length, OutputSpan::Path});
+    }
+  }
+
+  QRegularExpressionMatchIterator words = severityPattern().globalMatch(line);
+  while (words.hasNext()) {
+    QRegularExpressionMatch match = words.next();
+    if (overlaps(spans, match.capturedStart(), match.capturedLength())) {
+      continue;
+    }
+    spans.append({int(match.capturedStart()), int(match.capturedLength()),
+                  match.capturedLength(1) > 0 ? OutputSpan::Error
+                                              : OutputSpan::Warning});
+  }
+
+  std::sort(spans.begin(), spans.end(),
+            [](const OutputSpan &a, const OutputSpan &b) {
+              return a.start < b.start;
+            });
+  return spans;
+}
+
+QString filePath(const QString &text, const QString &cwd) {
+  QString path = text;
+
+  // drop ':line[:column]'
+  static const QRegularExpression position(":\\d+(?::\\d+)?$");
+  path.remove(position);
+
+  if (path == "~" || path.startsWith("~/")) {
+    path = QDir::homePath() + path.mid(1);
+  }
+
+  return QDir::cleanPath(QDir(cwd).absoluteFilePath(path));
+}
+
+} // namespace OutputClassifier
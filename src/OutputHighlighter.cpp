@@ -0,0 +1,201 @@
+#include "OutputHighlighter.h"
+#include "OutputClassifier.h"
+#include <QDir>
+#include <QScrollBar>
+#include <QTextBlock>
+#include <QTextEdit>
+#include <algorithm>
+
+// Lines classified above and below the viewport
+static constexpr int viewportMargin = 50;
+
+// Lines with cached results
+static constexpr int cachedLines = 4000;
+
+// Delay after scrolling or output before classifying
+static constexpr int settleInterval = 30;
+
+OutputHighlighter::OutputHighlighter(QTextEdit *editor)
+    : QSyntaxHighlighter(editor->document()), editor(editor),
+      cache(cachedLines) {
+  // one worker: a newer request waits instead of racing an older one
+  pool.setMaxThreadCount(1);
+
+  visibleTimer.setSingleShot(true);
+  visibleTimer.setInterval(settleInterval);
+  connect(&visibleTimer, &QTimer::timeout, this,
+          &OutputHighlighter::classifyVisible);
+
+  auto schedule = [this]() { visibleTimer.start(); };
+  connect(editor->verticalScrollBar(), &QScrollBar::valueChanged, this,
+          schedule);
+  connect(editor->document(), &QTextDocument::contentsChanged, this,
+          schedule);
+}
+
+OutputHighlighter::~OutputHighlighter() {
+  pool.clear();
+  pool.waitForDone();
+}
+
+void OutputHighlighter::setDirectoryResolver(
+    std::function<QString(int position)> resolver) {
+  directoryOf = std::move(resolver);
+  rehighlight();
+}
+
+QString OutputHighlighter::directory(const QTextBlock &block) const {
+  return directoryOf ? directoryOf(block.position()) : QDir::currentPath();
+}
+
+// lines never hold '\n', it separates the two parts
+QString OutputHighlighter::cacheKey(const QTextBlock &block) const {
+  return directory(block) + QChar('\n') + block.text();
+}
+
+bool OutputHighlighter::spanAt(const QPoint &position, OutputSpan *span,
+                               QString *text) const {
+  QTextCursor cursor = editor->cursorForPosition(position);
+  QTextBlock block = cursor.block();
+  const QList<OutputSpan> *spans = cache.object(cacheKey(block));
+  if (!spans) {
+    return false;
+  }
+
+  int offset = cursor.positionInBlock();
+  for (const OutputSpan &candidate : *spans) {
+    if (offset >= candidate.start &&
+        offset < candidate.start + candidate.length) {
+      *span = candidate;
+      *text = block.text().mid(candidate.start, candidate.length);
+      return true;
+    }
+  }
+  return false;
+}
+
+void OutputHighlighter::highlightBlock(const QString & /*text*/) {
+  const QList<OutputSpan> *spans = cache.object(cacheKey(currentBlock()));
+  if (!spans) {
+    return; // classified once it is near the viewport
+  }
+
+  for (const OutputSpan &span : *spans) {
+    QTextCharFormat format;
+
+    switch (span.role) {
+    case OutputSpan::Url:
+      format.setForeground(QColor("#61AFEF"));
+      format.setFontUnderline(true);
+      break;
+    case OutputSpan::Path:
+      format.setForeground(QColor("steelblue"));
+      format.setFontUnderline(true);
+      break;
+    case OutputSpan::Location:
+      format.setForeground(QColor("#C678DD"));
+      format.setFontUnderline(true);
+      break;
+    case OutputSpan::Error:
+      format.setForeground(QColor("#FF5555"));
+      format.setFontWeight(QFont::Bold);
+      break;
+    case OutputSpan::Warning:
+      format.setForeground(QColor("#E5C07B"));
+      format.setFontWeight(QFont::Bold);
+      break;
+    default:
+      continue;
+    }
+
+    setFormat(span.start, span.length, format);
+  }
+}
+
+void OutputHighlighter::classifyVisible() {
+  QTextBlock first = editor->cursorForPosition(QPoint(0, 0)).block();
+  QTextBlock last =
+      editor->cursorForPosition(QPoint(editor->viewport()->width(),
+                                       editor->viewport()->height()))
+          .block();
+
+  for (int i = 0; i < viewportMargin && first.previous().isValid(); i++) {
+    first = first.previous();
+  }
+  for (int i = 0; i < viewportMargin && last.next().isValid(); i++) {
+    last = last.next();
+  }
+
+  // uncached lines only, repeated lines are classified once per directory
+  QStringList keys;
+  QStringList lines;
+  QStringList directories;
+  QSet<QString> requested;
+  for (QTextBlock block = first; block.isValid(); block = block.next()) {
+    QString text = block.text();
+    if (!text.trimmed().isEmpty()) {
+      QString key = cacheKey(block);
+      if (!cache.contains(key) && !pending.contains(key) &&
+          !requested.contains(key)) {
+        keys.append(key);
+        lines.append(text);
+        directories.append(key.left(key.size() - text.size() - 1));
+        requested.insert(key);
+      }
+    }
+
+    if (block == last) {
+      break;
+    }
+  }
+
+  if (keys.isEmpty()) {
+    return;
+  }
+
+  pending.unite(requested);
+
+  pool.start([this, keys, lines, directories]() {
+    QList<QList<OutputSpan>> results;
+    for (int i = 0; i < lines.size(); i++) {
+      results.append(OutputClassifier::classify(lines[i], directories[i]));
+    }
+
+    // back to the UI thread, dropped if the highlighter is gone
+    QMetaObject::invokeMethod(
+        this, [this, keys, results]() { classified(keys, results); },
+        Qt::QueuedConnection);
+  });
+}
+
+void OutputHighlighter::classified(const QStringList &keys,
+                                   const QList<QList<OutputSpan>> &results) {
+  QSet<QString> highlighted;
+  for (int i = 0; i < keys.size(); i++) {
+    pending.remove(keys[i]);
+    cache.insert(keys[i], new QList<OutputSpan>(results[i]));
+    if (!results[i].isEmpty()) {
+      highlighted.insert(keys[i]);
+    }
+  }
+
+  if (highlighted.isEmpty()) {
+    return;
+  }
+
+  // repaint the lines that gained spans, wherever they are now
+  QTextBlock first = editor->cursorForPosition(QPoint(0, 0)).block();
+  for (int i = 0; i < viewportMargin && first.previous().isValid(); i++) {
+    first = first.previous();
+  }
+
+  int remaining = 2 * viewportMargin +
+                  editor->viewport()->height() /
+                      std::max(1, editor->fontMetrics().height());
+  for (QTextBlock block = first; block.isValid() && remaining > 0;
+       block = block.next(), remaining--) {
+    if (highlighted.contains(cacheKey(block))) {
+      rehighlightBlock(block);
+    }
+  }
+}
@@ -0,0 +1,197 @@
+#include "ParallelRunner.h"
+#include "ChildProcess.h"
+#include <QFileInfo>
+#include <QTimer>
+#include <algorithm>
+
+// Progress refresh while long jobs run
+static constexpr int progressInterval = 500;
+
+// Single quotes keep the input one word whatever it contains
+static QString shellQuote(const QString &text) {
+  QString quoted = text;
+  quoted.replace("'", "'\\''");
+  return "'" + quoted + "'";
+}
+
+static QString duration(qint64 milliseconds) {
+  qint64 seconds = milliseconds / 1000;
+  return QString("%1:%2")
+      .arg(seconds / 60)
+      .arg(seconds % 60, 2, 10, QChar('0'));
+}
+
+// Replaces {}, {.} and {/} in one pass, inserted text is never rescanned
+static QString substitute(const QString &text, const QString &input,
+                          bool quote, bool *found) {
+  QFileInfo info(input);
+  QString stem = input;
+  if (!info.suffix().isEmpty()) {
+    stem.chop(info.suffix().size() + 1);
+  }
+
+  QString result;
+  for (qsizetype i = 0; i < text.size(); i++) {
+    QString value;
+    qsizetype length = 0;
+    if (QStringView(text).mid(i).startsWith(u"{}")) {
+      value = input;
+      length = 2;
+    } else if (QStringView(text).mid(i).startsWith(u"{.}")) {
+      value = stem;
+      length = 3;
+    } else if (QStringView(text).mid(i).startsWith(u"{/}")) {
+      value = info.fileName();
+      length = 3;
+    }
+
+    if (length == 0) {
+      result += text[i];
+      continue;
+    }
+
+    result += quote ? shellQuote(value) : value;
+    i += length - 1;
+    *found = true;
+  }
+  return result;
+}
+
+ParallelRunner::ParallelRunner(const QStringList &command,
+                               const QStringList &inputs, int jobs,
+                               bool keepOrder, QObject *parent)
+    : QObject(parent), command(command),
+      jobs(std::max(1, jobs)), keepOrder(keepOrder) {
+  for (const QString &input : inputs) {
+    Job job;
+    job.input = input;
+    queue.append(job);
+  }
+
+  progressTimer = new QTimer(this);
+  progressTimer->setInterval(progressInterval);
+  connect(progressTimer, &QTimer::timeout, this,
+          &ParallelRunner::reportProgress);
+}
+
+ParallelRunner::~ParallelRunner() {
+  for (Job &job : queue) {
+    delete job.child;
+  }
+}
+
+QString ParallelRunner::commandLine(const QStringList &command,
+                                    const QString &input) {
+  bool found = false;
+
+  // parallel 'gzip -9 {} && rm {}': the word is a shell command line
+  if (command.size() == 1 &&
+      std::any_of(command.first().begin(), command.first().end(),
+                  [](QChar c) { return c.isSpace(); })) {
+    QString line = substitute(command.first(), input, true, &found);
+    return found ? line : line + " " + shellQuote(input);
+  }
+
+  // the parser already removed the quotes, each word is quoted again
+  QStringList words;
+  for (const QString &word : command) {
+    words.append(shellQuote(substitute(word, input, false, &found)));
+  }
+  if (!found) {
+    words.append(shellQuote(input));
+  }
+  return words.join(' ');
+}
+
+void ParallelRunner::start() {
+  clock.start();
+  progressTimer->start();
+  fillSlots();
+  reportProgress();
+}
+
+void ParallelRunner::fillSlots() {
+  while (running < jobs && nextJob < queue.size()) {
+    int index = nextJob++;
+    Job &job = queue[index];
+    running++;
+
+    job.child = new ChildProcess(this);
+    connect(job.child, &ChildProcess::outputReady, this,
+            [this, index](QString data) { queue[index].output += data; });
+    connect(job.child, &ChildProcess::errorReady, this,
+            [this, index](QString data) { queue[index].error += data; });
+    connect(job.child, &ChildProcess::finished, this,
+            [this, index](int exitCode) { jobExited(index, exitCode); });
+
+    if (!job.child->start("/bin/sh",
+                          {"-c", commandLine(command, job.input)})) {
+      job.error = QString("parallel: cannot run '%1'\n").arg(job.input);
+
+      // completes like a job that exited, after the caller returned
+      QMetaObject::invokeMethod(
+          this, [this, index]() { jobExited(index, 127); },
+          Qt::QueuedConnection);
+    }
+  }
+}
+
+void ParallelRunner::jobExited(int index, int exitCode) {
+  Job &job = queue[index];
+  job.child->deleteLater();
+  job.child = nullptr;
+  job.done = true;
+
+  running--;
+  done++;
+  if (exitCode != 0) {
+    failed++;
+  }
+
+  // as completed, or held back until the jobs before it are reported
+  if (keepOrder) {
+    while (nextReport < queue.size() && queue[nextReport].done) {
+      reportJob(queue[nextReport++]);
+    }
+  } else {
+    reportJob(job);
+  }
+
+  fillSlots();
+
+  if (done == queue.size()) {
+    progressTimer->stop();
+    emit progressChanged(QString());
+    emit finished(failed);
+    return;
+  }
+
+  reportProgress();
+}
+
+void ParallelRunner::reportJob(Job &job) {
+  emit jobFinished(job.output, job.error);
+
+  // reported output is not needed any more
+  job.output.clear();
+  job.error.clear();
+}
+
+void ParallelRunner::reportProgress() {
+  if (done == queue.size()) {
+    return;
+  }
+
+  QString progress = QString("parallel: %1/%2 done, %3 running")
+                         .arg(done)
+                         .arg(queue.size())
+                         .arg(running);
+
+  // wall time per finished job so far, the slots are already in it
+  if (done > 0) {
+    qint64 remaining = clock.elapsed() * (queue.size() - done) / done;
+    progress += ", ETA " + duration(remaining);
+  }
+
+  emit progressChanged(progress);
+}
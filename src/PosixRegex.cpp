@@ -0,0 +1,243 @@
+#include "PosixRegex.h"
+#include <QHash>
+#include <QList>
+#include <algorithm>
+
+// Index of the ']' closing the bracket expression at open, -1 if unclosed
+static qsizetype bracketEnd(const QString &pattern, qsizetype open) {
+  qsizetype i = open + 1;
+  if (i < pattern.size() && pattern[i] == '^') {
+    i++;
+  }
+  if (i < pattern.size() && pattern[i] == ']') {
+    i++; // a leading ']' is a member
+  }
+
+  for (; i < pattern.size(); i++) {
+    QChar c = pattern[i];
+    if (c == ']') {
+      return i;
+    }
+
+    // [:class:], [=x=] and [.x.] hold their own ']'
+    if (c == '[' && i + 1 < pattern.size() &&
+        QStringView(u":=.").contains(pattern[i + 1])) {
+      QChar kind = pattern[i + 1];
+      for (qsizetype j = i + 2; j + 1 < pattern.size(); j++) {
+        if (pattern[j] == kind && pattern[j + 1] == ']') {
+          i = j + 1;
+          break;
+        }
+      }
+    }
+  }
+  return -1;
+}
+
+// Bounds of an interval "m,n" as PCRE2 takes them, empty if malformed
+static QString intervalBounds(QStringView bounds) {
+  qsizetype comma = bounds.indexOf(u',');
+  QStringView low = comma < 0 ? bounds : bounds.left(comma);
+  QStringView high = comma < 0 ? QStringView() : bounds.mid(comma + 1);
+  auto digits = [](QStringView text) {
+    return std::all_of(text.begin(), text.end(),
+                       [](QChar c) { return c >= '0' && c <= '9'; });
+  };
+
+  if (bounds.isEmpty() || !digits(low) || !digits(high) ||
+      (low.isEmpty() && comma < 0)) {
+    return QString();
+  }
+  return (low.isEmpty() ? QString("0") : low.toString()) +
+         (comma < 0 ? QString() : "," + high.toString());
+}
+
+namespace PosixRegex {
+
+QString toPcre(const QString &pattern, bool extended) {
+  QString result;
+  QList<qsizetype> groups; // where the open groups start in result
+  qsizetype atom = -1;     // where the last repeatable item starts, or -1
+  bool quantified = false; // that item is repeated already
+  bool zeroWidth = false;  // that item is an anchor (extended)
+  bool groupStart = true;  // '^' anchors here in basic
+
+  // starts a repeatable item at the end of result
+  auto item = [&](bool anchor) {
+    atom = result.size();
+    quantified = false;
+    zeroWidth = anchor;
+  };
+
+  auto literal = [&](QChar c) {
+    item(false);
+    if (QStringView(u"\\^$.[]|()?*+{}").contains(c)) {
+      result += '\\';
+    }
+    result += c;
+  };
+
+  // an operator after a basic anchor is text, an extended one repeats it
+  auto anchor = [&](const QString &text) {
+    if (extended) {
+      item(true);
+    } else {
+      atom = -1;
+    }
+    result += text;
+  };
+
+  // text is what a basic operator with nothing to repeat stands for
+  auto repeat = [&](const QString &quantifier, QChar text) {
+    if (atom < 0) {
+      if (!extended) {
+        literal(text);
+      }
+      return;
+    }
+
+    if (quantified || zeroWidth) {
+      result.insert(atom, "(?:");
+      result += ')';
+    }
+    result += quantifier;
+    quantified = true;
+  };
+
+  for (qsizetype i = 0; i < pattern.size(); i++) {
+    QChar c = pattern[i];
+    bool start = groupStart;
+    groupStart = false;
+
+    // operators of the flavour: bare in extended, escaped in basic
+    QChar op;
+    if (c == '\\' && i + 1 < pattern.size()) {
+      QChar next = pattern[i + 1];
+      if (!extended && QStringView(u"(){}|+?").contains(next)) {
+        op = next;
+        i++;
+      }
+    } else if (extended && QStringView(u"(){}|+?").contains(c)) {
+      op = c;
+    }
+
+    if (op == '(') {
+      groups.append(result.size());
+      result += '(';
+      atom = -1;
+      groupStart = true;
+    } else if (op == ')') {
+      if (groups.isEmpty() && extended) {
+        literal(op); // an unmatched ')' is ordinary in extended
+      } else {
+        result += ')';
+        atom = groups.isEmpty() ? -1 : groups.takeLast();
+        quantified = false;
+        zeroWidth = false;
+      }
+    } else if (op == '|') {
+      result += '|';
+      atom = -1;
+      groupStart = true;
+    } else if (op == '+' || op == '?') {
+      repeat(QString(op), op);
+    } else if (op == '{') {
+      qsizetype close = pattern.indexOf(extended ? "}" : "\\}", i + 1);
+      QString bounds =
+          close < 0 ? QString()
+                    : intervalBounds(QStringView(pattern).mid(
+                          i + 1, close - i - 1));
+      if (bounds.isEmpty() || (atom < 0 && !extended)) {
+        literal(op); // text unless a well formed interval repeats something
+      } else {
+        repeat("{" + bounds + "}", op);
+        i = close + (extended ? 0 : 1);
+      }
+    } else if (op == '}') {
+      literal(op);
+    } else if (c == '*') {
+      repeat("*", c);
+    } else if (c == '[') {
+      qsizetype end = bracketEnd(pattern, i);
+      if (end < 0) {
+        result += pattern.mid(i); // PCRE2 reports the missing ']'
+        break;
+      }
+
+      item(false);
+      result += '[';
+      qsizetype j = i + 1;
+      if (pattern[j] == '^') {
+        result += '^';
+        j++;
+      }
+      if (pattern[j] == ']') {
+        result += "\\]";
+        j++;
+      }
+
+      for (; j < end; j++) {
+        QChar member = pattern[j];
+        if (member == '[' && QStringView(u":=.").contains(pattern[j + 1])) {
+          qsizetype close =
+              pattern.indexOf(QString(pattern[j + 1]) + ']', j + 2);
+          if (close >= 0) {
+            result += pattern.mid(j, close + 2 - j);
+            j = close + 1;
+            continue;
+          }
+        }
+
+        if (member == '\\' || member == '[') {
+          result += '\\';
+        }
+        result += member;
+      }
+
+      result += ']';
+      i = end;
+    } else if (c == '^') {
+      if (extended || start) {
+        anchor("^");
+      } else {
+        literal(c);
+      }
+    } else if (c == '$') {
+      // basic: an anchor at the end of the pattern or of a group
+      QStringView rest = QStringView(pattern).mid(i + 1);
+      if (extended || rest.isEmpty() || rest.startsWith(u"\\)") ||
+          rest.startsWith(u"\\|")) {
+        anchor("$");
+      } else {
+        literal(c);
+      }
+    } else if (c == '\\') {
+      if (i + 1 == pattern.size()) {
+        result += c; // PCRE2 reports the trailing backslash
+        break;
+      }
+
+      QChar next = pattern[++i];
+      static const QHash<QChar, QString> assertions = {
+          {'<', "\\b(?=\\w)"}, {'>', "\\b(?<=\\w)"}, {'`', "\\A"},
+          {'\'', "\\z"},       {'b', "\\b"},         {'B', "\\B"}};
+      if (assertions.contains(next)) {
+        anchor(assertions.value(next));
+      } else if (QStringView(u"123456789wWsS").contains(next)) {
+        item(false);
+        result += '\\';
+        result += next;
+      } else {
+        literal(next); // no meaning in POSIX
+      }
+    } else if (c == '.') {
+      item(false);
+      result += c;
+    } else {
+      literal(c);
+    }
+  }
+  return result;
+}
+
+} // namespace PosixRegex
@@ -1,32 +1,310 @@
 #include "ProcessManager.h"
+#include "ChildProcess.h"
+#include "DirectoryIndex.h"
+#include "FileFollower.h"
+#include "FilePager.h"
+#include "GrepSearch.h"
+#include "MappedFile.h"
+#include "ParallelRunner.h"
+#include "ProcessSpawn.h"
+#include "ScriptInterpreter.h"
+#include "ScriptParser.h"
+#include "SessionRecorder.h"
+#include "SessionReplay.h"
+#include "TextScan.h"
+#include "TextWidth.h"
+#include "Trace.h"
+#include "TreeWalk.h"
+#include "WatchCommand.h"
 #include <QDebug>
 #include <QDir>
+#include <QEventLoop>
 #include <QFile>
-#include <QStandardPaths>
+#include <QThread>
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <csignal>
+#include <cstring>
+#include <fnmatch.h>
+#include <memory>
+#include <unistd.h>
+#include <unordered_map>
 
 // Constructor initializes a process
 ProcessManager::ProcessManager(QObject *parent) : QObject(parent) {
-  // Initialize QProcess
-  process = new QProcess(this);
+  // Child process for external commands (posix_spawn backend)
+  process = new ChildProcess(this);
+
+  // Interpreter for compound command lines and .qsh scripts
+  interpreter = new ScriptInterpreter(this, this);
+  connect(interpreter, &ScriptInterpreter::errorReady, this,
+          &ProcessManager::processErrorReady);
+
+  // Capture process output and send it to QShellUI
+  connect(process, &ChildProcess::outputReady, this,
+          &ProcessManager::processOutputReady);
+
+  // Capture error
+  connect(process, &ChildProcess::errorReady, this,
+          &ProcessManager::processErrorReady);
+
+  // report completion (QShellUI shows the next prompt)
+  connect(process, &ChildProcess::finished, this, [this](int exitCode) {
+    lastExitCode = exitCode;
+    emit processFinished(lastExitCode);
+  });
+
+  // everything shown to the user goes to an active recording
+  recorder = new SessionRecorder();
+  connect(this, &ProcessManager::processOutputReady, this,
+          [this](QString output) { recorder->recordOutput(output); });
+  connect(this, &ProcessManager::processErrorReady, this,
+          [this](QString error) { recorder->recordError(error); });
+  connect(this, &ProcessManager::processHighlightedOutputReady, this,
+          [this](QString output, QList<OutputSpan>) {
+            recorder->recordOutput(output);
+          });
+
+  // visited directories for 'z', loaded once, written in the background
+  directoryIndex = new DirectoryIndex(DirectoryIndex::defaultPath());
 }
 
 ProcessManager::~ProcessManager() {
   // cleanign up process
   process->deleteLater();
+
+  // writes the queued events and closes the recording
+  delete recorder;
+
+  // writes the pending visits
+  delete directoryIndex;
 };
 
 bool ProcessManager::commandIsValid(const QString command) {
-  bool commandFound = !QStandardPaths::findExecutable(command).isEmpty();
+  // same cached lookup the spawn uses
+  bool commandFound = !ProcessSpawn::resolveExecutable(
+                           QFile::encodeName(command).toStdString())
+                           .empty();
 
   return commandFound;
 }
 
+int ProcessManager::exitStatus() const { return lastExitCode; }
+
+void ProcessManager::setTerminalColumns(int columns) {
+  terminalColumns = columns;
+  if (pager) {
+    pager->resize(terminalRows, terminalColumns);
+  }
+}
+
+void ProcessManager::setTerminalRows(int rows) {
+  terminalRows = rows;
+  if (pager) {
+    pager->resize(terminalRows, terminalColumns);
+  }
+}
+
+bool ProcessManager::keyPressed(int key, const QString &text) {
+  if (!pager) {
+    return false;
+  }
+
+  pager->keyPressed(key, text);
+  return true;
+}
+
+ScriptInterpreter *ProcessManager::scriptInterpreter() const {
+  return interpreter;
+}
+
+int ProcessManager::runBuiltin(const QString &program,
+                               const QStringList &args) {
+  lastExitCode = 0;
+  if (!handleFileSystemCommand(program, args)) {
+    return -1;
+  }
+
+  // long running builtins (tail -f) block the script until interrupted
+  if (builtinPending) {
+    QEventLoop loop;
+    builtinLoop = &loop;
+    loop.exec();
+    builtinLoop = nullptr;
+  }
+
+  return lastExitCode;
+}
+
+void ProcessManager::finishPendingBuiltin(int exitCode) {
+  builtinPending = false;
+  lastExitCode = exitCode;
+
+  if (builtinLoop) {
+    builtinLoop->quit();
+    return;
+  }
+
+  emit processFinished(lastExitCode);
+}
+
+TreeWalk *ProcessManager::startTreeWalk(const QString &name,
+                                        const WalkOptions &options) {
+  treeWalk = new TreeWalk(name, options, this);
+  connect(treeWalk, &TreeWalk::outputReady, this,
+          &ProcessManager::processOutputReady);
+  connect(treeWalk, &TreeWalk::errorReady, this,
+          &ProcessManager::processErrorReady);
+  connect(treeWalk, &TreeWalk::finished, this, [this](int exitCode) {
+    treeWalk->deleteLater();
+    treeWalk = nullptr;
+    finishPendingBuiltin(exitCode);
+  });
+
+  builtinPending = true;
+  return treeWalk;
+}
+
+void ProcessManager::interrupt() {
+  if (builtinPending) {
+    if (follower) {
+      follower->deleteLater();
+      follower = nullptr;
+    }
+
+    // cancels the walk and waits for its workers
+    delete treeWalk;
+    treeWalk = nullptr;
+
+    delete grep;
+    grep = nullptr;
+
+    delete replay;
+    replay = nullptr;
+
+    // kills the running jobs, unreported output is dropped
+    if (parallel) {
+      delete parallel;
+      parallel = nullptr;
+      emit progressChanged(QString());
+    }
+
+    if (pager) {
+      closePager();
+    }
+
+    // the last screen stays as regular output
+    if (watch) {
+      delete watch;
+      watch = nullptr;
+      emit pinnedRegionClosed();
+    }
+
+    finishPendingBuiltin(130);
+    return;
+  }
+
+  if (foregroundChild) {
+    foregroundChild->sendSignal(SIGINT);
+    return;
+  }
+
+  process->sendSignal(SIGINT);
+}
+
+int ProcessManager::runExternal(const QString &program,
+                                const QStringList &args) {
+  ChildProcess child;
+  connect(&child, &ChildProcess::outputReady, this,
+          &ProcessManager::processOutputReady);
+  connect(&child, &ChildProcess::errorReady, this,
+          &ProcessManager::processErrorReady);
+
+  if (!child.start(program, args)) {
+    return reportStartFailure(program, child.error());
+  }
+
+  // forward output while the child runs
+  int exitCode = 0;
+  QEventLoop loop;
+  connect(&child, &ChildProcess::finished, &loop, [&loop, &exitCode](int code) {
+    exitCode = code;
+    loop.quit();
+  });
+
+  ChildProcess *outerChild = foregroundChild;
+  foregroundChild = &child;
+  loop.exec();
+  foregroundChild = outerChild;
+
+  return exitCode;
+}
+
+int ProcessManager::reportStartFailure(const QString &program, int error) {
+  if (error == ENOENT) {
+    emit processOutputReady("Error: Command '" + program + "' not found.\n");
+    return 127;
+  }
+
+  emit processOutputReady("Error: Command '" + program +
+                          "' could not be started.\n");
+  return 126;
+}
+
+void ProcessManager::runScriptLine(const ScriptNodePtr &script) {
+  lastExitCode = interpreter->run(script);
+  emit processFinished(lastExitCode);
+
+  if (interpreter->exitRequested()) {
+    emit shellExitRequested(lastExitCode);
+  }
+}
+
+// Builtins complete synchronously, report them like a finished child process
+void ProcessManager::finishBuiltin() { emit processFinished(lastExitCode); }
+
+// Builtin error messages are complete lines and fail the command
+void ProcessManager::builtinError(const QString &message) {
+  lastExitCode = 1;
+  emit processOutputReady(message.endsWith('\n') ? message : message + "\n");
+}
+
 void ProcessManager::startProcess(QString command) {
+  // builtins (cat, ls, grep) read and display inside this span
+  QSHELL_TRACE_SCOPE(scope, "ProcessManager::startProcess");
+  recorder->recordCommand(command);
+
+  // parse with the script grammar (quoting, variables, lists, loops)
+  QString parseError;
+  ScriptNodePtr script = ScriptParser::parse(command, &parseError);
+
+  if (!script) {
+    lastExitCode = 2;
+    emit processOutputReady("qshell: " + parseError);
+    emit processFinished(lastExitCode);
+    return;
+  }
+
+  // compound lines and assignments run in the interpreter
+  if (script->type != ScriptNode::Command || !script->assignments.isEmpty()) {
+    runScriptLine(script);
+    return;
+  }
+
   // handle command arguments
-  QStringList args = command.split(" ", Qt::SkipEmptyParts);
+  QStringList args = interpreter->expandArguments(*script);
 
   // handle empty command
   if (args.isEmpty()) {
+    lastExitCode = 0;
+    emit processFinished(lastExitCode);
+    return;
+  }
+
+  // script builtins, functions and .qsh files
+  if (interpreter->isInternalCommand(args.first())) {
+    runScriptLine(script);
     return;
   }
 
@@ -34,54 +312,24 @@ void ProcessManager::startProcess(QString command) {
   QString program = args.takeFirst();
 
   // handle filesystem commands internally
+  lastExitCode = 0;
   const bool handledInternally = handleFileSystemCommand(program, args);
 
   if (handledInternally) {
-    return; // do not fallback to QProcess if handled internally
-  }
-
-  // validate command
-  bool validCommand = commandIsValid(program);
-  if (!validCommand) {
-    // error message
-    errorMessage = "Error: Command '" + program + "' not found.\n";
-
-    // send error message as ouput
-    emit processOutputReady(errorMessage);
-
-    return;
+    if (!builtinPending) {
+      finishBuiltin();
+    }
+    return; // do not fallback to a child process if handled internally
   }
 
   // clear last error message if none detected
   errorMessage.clear();
 
-  // Run command inside QProcess
-  process->start(program, args);
-
-  // Capture process output and send it to QShellUI
-  connect(process, &QProcess::readyReadStandardOutput, this, [this]() {
-    // get output from running command
-    QString output = process->readAllStandardOutput();
-
-    // send output back to QShellUI
-    emit processOutputReady(output);
-  });
-
-  // Capture error
-  connect(process, &QProcess::readyReadStandardError, this, [this]() {
-    QString error = process->readAllStandardError();
-    emit processErrorReady(error);
-  });
-
-  // needed to show prompt even with no content
-  connect(
-      process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-      this, [this](int /*exitCode*/, QProcess::ExitStatus /*status*/) {
-        if (process->readAllStandardOutput().trimmed().isEmpty() &&
-            process->readAllStandardError().trimmed().isEmpty()) {
-          emit processOutputReady(""); // Trigger prompt manually if no output
-        }
-      });
+  // resolve and spawn in one go (signals are connected once in constructor)
+  if (!process->start(program, args)) {
+    lastExitCode = reportStartFailure(program, process->error());
+    emit processFinished(lastExitCode);
+  }
 }
 
 // Method calls for filesystem specific command handlers
@@ -106,6 +354,63 @@ bool ProcessManager::handleFileSystemCommand(const QString &command,
     return handleCat(args);
   }
 
+  if (command == "wc")
+    return handleWc(args);
+
+  if (command == "head")
+    return handleHead(args);
+
+  if (command == "tail")
+    return handleTail(args);
+
+  if (command == "grep")
+    return handleGrep(args);
+
+  if (command == "du")
+    return handleDu(args);
+
+  if (command == "find")
+    return handleFind(args);
+
+  if (command == "cd")
+    return handleCd(args);
+
+  if (command == "pushd")
+    return handlePushd(args);
+
+  if (command == "popd")
+    return handlePopd(args);
+
+  if (command == "dirs")
+    return handleDirs(args);
+
+  if (command == "z")
+    return handleZ(args);
+
+  if (command == "echo")
+    return handleEcho(args);
+
+  if (command == "ls")
+    return handleLs(args);
+
+  if (command == "record")
+    return handleRecord(args);
+
+  if (command == "replay")
+    return handleReplay(args);
+
+  if (command == "watch")
+    return handleWatch(args);
+
+  if (command == "parallel")
+    return handleParallel(args);
+
+  if (command == "view" || command == "less")
+    return handleView(args);
+
+  if (command == "trace")
+    return handleTrace(args);
+
   return false; // not a filesystem command
 }
 
@@ -113,7 +418,7 @@ bool ProcessManager::handleFileSystemCommand(const QString &command,
 bool ProcessManager::handleMkdir(const QStringList &args) {
   // handle empty args
   if (args.isEmpty()) {
-    emit processOutputReady(
+    builtinError(
         "mkdir: missing operand\nTry 'mkdir --help' for more information.");
 
     return true;
@@ -128,12 +433,10 @@ bool ProcessManager::handleMkdir(const QStringList &args) {
       // error message
       QString errorMessage =
           QString("mkdir: cannot create directory '%1'").arg(dirName);
-      emit processOutputReady(errorMessage); // send error message to QShellUI.
+      builtinError(errorMessage); // send error message to QShellUI.
     }
   }
 
-  // emit newline as output to trigger prompt
-  emit processOutputReady("\n");
   return true;
 }
 
@@ -141,7 +444,7 @@ bool ProcessManager::handleMkdir(const QStringList &args) {
 bool ProcessManager::handleTouch(const QStringList &args) {
   // handle empty args
   if (args.isEmpty()) {
-    emit processOutputReady(
+    builtinError(
         "touch: missing operand\nTry 'touch --help' for more information.");
     return true;
   }
@@ -157,7 +460,7 @@ bool ProcessManager::handleTouch(const QStringList &args) {
     if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
       QString errorMessage =
           QString("touch: cannot create file '%1'").arg(fileName);
-      emit processOutputReady(errorMessage);
+      builtinError(errorMessage);
     }
 
     else {
@@ -165,15 +468,13 @@ bool ProcessManager::handleTouch(const QStringList &args) {
     }
   }
 
-  emit processOutputReady("\n");
-
   return true;
 }
 
 // rmdir logic implementation
 bool ProcessManager::handleRmdir(const QStringList &args) {
   if (args.isEmpty()) {
-    emit processOutputReady(
+    builtinError(
         "rmdir: missing operant\nTry rmdir --help for more information.");
     return true;
   }
@@ -189,7 +490,7 @@ bool ProcessManager::handleRmdir(const QStringList &args) {
       QString errorMessage =
           QString("rmdir: failed to remove '%1': No such file or directory")
               .arg(dirName);
-      emit processOutputReady(errorMessage);
+      builtinError(errorMessage);
       continue;
     }
 
@@ -199,12 +500,10 @@ bool ProcessManager::handleRmdir(const QStringList &args) {
           QString("rmdir: failed to remove '%1': Directory not empty or "
                   "permission denied")
               .arg(dirName);
-      emit processOutputReady(errorMessage);
+      builtinError(errorMessage);
     }
   }
 
-  emit processOutputReady("\n");
-
   return true;
 }
 
@@ -212,7 +511,7 @@ bool ProcessManager::handleRmdir(const QStringList &args) {
 bool ProcessManager::handleRm(const QStringList &args) {
   // handle empty args
   if (args.isEmpty()) {
-    emit processOutputReady(
+    builtinError(
         "rm: missing operand\nTry 'rm --help' for more information.");
     return true;
   }
@@ -234,7 +533,7 @@ bool ProcessManager::handleRm(const QStringList &args) {
 
   // handle missing operands
   if (paths.isEmpty()) {
-    emit processOutputReady("rm: missing file operand");
+    builtinError("rm: missing file operand");
     return true;
   }
 
@@ -249,7 +548,7 @@ bool ProcessManager::handleRm(const QStringList &args) {
       QString errorMessage =
           QString("rm: cannot remove '%1': no such file or directory")
               .arg(target);
-      emit processOutputReady(errorMessage);
+      builtinError(errorMessage);
       continue;
     }
 
@@ -260,7 +559,7 @@ bool ProcessManager::handleRm(const QStringList &args) {
         // send error message
         QString errorMessage =
             QString("rm: cannot remove '%1/': Is a directory").arg(target);
-        emit processOutputReady(errorMessage);
+        builtinError(errorMessage);
         continue;
       }
 
@@ -270,7 +569,7 @@ bool ProcessManager::handleRm(const QStringList &args) {
         // send error message if not possible
         QString errorMessage =
             QString("rm: failed to remove directory '%1'/").arg(target);
-        emit processOutputReady(errorMessage);
+        builtinError(errorMessage);
       }
 
     }
@@ -280,14 +579,11 @@ bool ProcessManager::handleRm(const QStringList &args) {
       if (!QFile::remove(target)) {
         // send error message on file removal failure
         QString errorMessage = QString("rm: failed to remove '%1'").arg(target);
-        emit processOutputReady(errorMessage);
+        builtinError(errorMessage);
       }
     }
   }
 
-  // trigger prompt
-  emit processOutputReady("\n");
-
   return true;
 }
 
@@ -296,7 +592,7 @@ bool ProcessManager::handleMv(const QStringList &args) {
   // handle missing operand
   if (args.isEmpty()) {
     // send error message
-    emit processOutputReady(
+    builtinError(
         "mv: missing file operand\nTry 'mv --help' for more information.");
     return true;
   }
@@ -308,7 +604,7 @@ bool ProcessManager::handleMv(const QStringList &args) {
         QString("mv: missing destination file operand after '%1'\nTry 'mv "
                 "--help' for more information.")
             .arg(lastArg);
-    emit processOutputReady(errorMessage);
+    builtinError(errorMessage);
     return true;
   }
 
@@ -323,7 +619,7 @@ bool ProcessManager::handleMv(const QStringList &args) {
     // send error message
     QString errorMessage =
         QString("mv: cannot stat '%1' : No such file or directory").arg(source);
-    emit processOutputReady(errorMessage);
+    builtinError(errorMessage);
     return true;
   }
 
@@ -336,7 +632,7 @@ bool ProcessManager::handleMv(const QStringList &args) {
     if (!QFile::rename(source, finalDest)) {
       QString errorMessage =
           QString("mv: failed to move '%1' to '%2'").arg(source, destination);
-      emit processOutputReady(errorMessage);
+      builtinError(errorMessage);
       return true;
     }
 
@@ -346,13 +642,11 @@ bool ProcessManager::handleMv(const QStringList &args) {
       // send error message
       QString errorMessage =
           QString("mv: failed to move '%1' to '%2'").arg(source, destination);
-      emit processOutputReady(errorMessage);
+      builtinError(errorMessage);
       return true;
     }
   }
 
-  // trigger prompt
-  emit processOutputReady("\n");
   return true;
 }
 
@@ -360,7 +654,7 @@ bool ProcessManager::handleMv(const QStringList &args) {
 bool ProcessManager::handleCat(const QStringList &args) {
   // check empty args
   if (args.isEmpty()) {
-    emit processOutputReady(
+    builtinError(
         "cat: missing file operand\nTry 'cat --help' for more information.");
     return true;
   }
@@ -372,7 +666,7 @@ bool ProcessManager::handleCat(const QStringList &args) {
     if (!file.exists()) {
       QString errorMessage =
           QString("cat: %1: No such file or directory").arg(fileName);
-      emit processOutputReady(errorMessage);
+      builtinError(errorMessage);
       continue;
     }
 
@@ -380,6 +674,7 @@ bool ProcessManager::handleCat(const QStringList &args) {
     if (!file.open(QIODevice::ReadOnly)) {
       QString errorMessage =
           QString("cat: %1: Permission denied").arg(fileName);
+      builtinError(errorMessage);
       continue;
     }
 
@@ -392,3 +687,1560 @@ bool ProcessManager::handleCat(const QStringList &args) {
 
   return true;
 }
+
+// Error text for a file that could not be mapped
+static QString mappingError(const QString &command, const QString &fileName,
+                            const MappedFile &file) {
+  return QString("%1: %2: %3")
+      .arg(command, fileName, QString::fromLocal8Bit(std::strerror(file.error())));
+}
+
+// Parses head/tail arguments: -n N, -nN, -N and, for tail (fromStart and
+// follow set), -n +N and -f. Returns false for anything else (-c, head
+// -n -N, malformed counts), the external tool handles and reports those.
+static bool parseLineArgs(const QStringList &args, qint64 *lines,
+                          bool *fromStart, bool *follow, QStringList *files) {
+  for (int i = 0; i < args.size(); i++) {
+    const QString &arg = args[i];
+    QString count;
+
+    if (arg == "-f" && follow) {
+      *follow = true;
+      continue;
+    }
+
+    if (arg == "-n") {
+      if (i + 1 == args.size()) {
+        return false;
+      }
+      count = args[++i];
+    } else if (arg.startsWith("-n")) {
+      count = arg.mid(2);
+    } else if (arg.startsWith('-') && arg.size() > 1) {
+      count = arg.mid(1);
+      if (!count[0].isDigit()) {
+        return false;
+      }
+    } else {
+      files->append(arg);
+      continue;
+    }
+
+    // tail -n +N prints from line N on
+    bool plus = count.startsWith('+');
+    if (plus) {
+      if (!fromStart) {
+        return false;
+      }
+      count.remove(0, 1);
+    }
+
+    if (count.isEmpty() ||
+        !std::all_of(count.begin(), count.end(),
+                     [](QChar c) { return c >= '0' && c <= '9'; })) {
+      return false;
+    }
+
+    bool valid = false;
+    *lines = count.toLongLong(&valid);
+    if (!valid) {
+      return false;
+    }
+    if (fromStart) {
+      *fromStart = plus;
+    }
+  }
+
+  return true;
+}
+
+// handle wc command implementation
+bool ProcessManager::handleWc(const QStringList &args) {
+  bool countLines = false;
+  bool countWords = false;
+  bool countBytes = false;
+  QStringList files;
+
+  // parse flags (-l, -w, -c and combinations like -lw)
+  for (const QString &arg : args) {
+    if (!arg.startsWith('-') || arg.size() == 1) {
+      files.append(arg);
+      continue;
+    }
+
+    for (const QChar flag : arg.mid(1)) {
+      if (flag == 'l') {
+        countLines = true;
+      } else if (flag == 'w') {
+        countWords = true;
+      } else if (flag == 'c') {
+        countBytes = true;
+      } else {
+        return false; // -m, -L, long options: the external wc
+      }
+    }
+  }
+
+  if (!countLines && !countWords && !countBytes) {
+    countLines = countWords = countBytes = true;
+  }
+
+  if (files.isEmpty()) {
+    builtinError(
+        "wc: missing file operand\nTry 'wc --help' for more information.");
+    return true;
+  }
+
+  struct Counts {
+    qint64 lines = 0;
+    qint64 words = 0;
+    qint64 bytes = 0;
+  };
+
+  QList<QPair<Counts, QString>> rows;
+  Counts total;
+
+  for (const QString &fileName : files) {
+    MappedFile file(QFile::encodeName(fileName).constData());
+    if (!file.isValid()) {
+      builtinError(mappingError("wc", fileName, file));
+      continue;
+    }
+
+    Counts counts;
+    counts.bytes = file.size();
+    if (countLines) {
+      counts.lines = TextScan::countNewlinesParallel(file.data(), file.size());
+    }
+    if (countWords) {
+      counts.words = TextScan::countWords(file.data(), file.size());
+    }
+
+    total.lines += counts.lines;
+    total.words += counts.words;
+    total.bytes += counts.bytes;
+    rows.append(qMakePair(counts, fileName));
+  }
+
+  if (rows.size() > 1) {
+    rows.append(qMakePair(total, QString("total")));
+  }
+
+  // columns are as wide as the largest number (the byte count of the total)
+  int width = QString::number(rows.isEmpty() ? 0 : rows.last().first.bytes)
+                  .size();
+
+  QString output;
+  for (const auto &[counts, name] : rows) {
+    QStringList columns;
+    if (countLines) {
+      columns.append(QString::number(counts.lines).rightJustified(width));
+    }
+    if (countWords) {
+      columns.append(QString::number(counts.words).rightJustified(width));
+    }
+    if (countBytes) {
+      columns.append(QString::number(counts.bytes).rightJustified(width));
+    }
+
+    output += columns.join(' ') + " " + name + "\n";
+  }
+
+  if (!output.isEmpty()) {
+    emit processOutputReady(output);
+  }
+
+  return true;
+}
+
+// handle head command implementation
+bool ProcessManager::handleHead(const QStringList &args) {
+  qint64 lines = 10;
+  QStringList files;
+
+  if (!parseLineArgs(args, &lines, nullptr, nullptr, &files)) {
+    return false; // -c, -n -N: the external head
+  }
+
+  if (files.isEmpty()) {
+    builtinError("head: missing file operand");
+    return true;
+  }
+
+  for (const QString &fileName : files) {
+    MappedFile file(QFile::encodeName(fileName).constData());
+    if (!file.isValid()) {
+      builtinError(mappingError("head", fileName, file));
+      continue;
+    }
+
+    // only the first lines are touched, the rest is never paged in
+    std::size_t length = TextScan::headLength(file.data(), file.size(), lines);
+    QString output = QString::fromUtf8(file.data(), length);
+
+    if (files.size() > 1) {
+      output.prepend(QString("==> %1 <==\n").arg(fileName));
+    }
+
+    emit processOutputReady(output);
+  }
+
+  return true;
+}
+
+// handle tail command implementation
+bool ProcessManager::handleTail(const QStringList &args) {
+  qint64 lines = 10;
+  bool fromStart = false;
+  bool follow = false;
+  QStringList files;
+
+  if (!parseLineArgs(args, &lines, &fromStart, &follow, &files)) {
+    return false; // -c, -F, long options: the external tail
+  }
+
+  if (files.isEmpty()) {
+    builtinError("tail: missing file operand");
+    return true;
+  }
+
+  if (follow && files.size() > 1) {
+    builtinError("tail: -f supports a single file");
+    return true;
+  }
+
+  qint64 shownBytes = 0;
+
+  for (const QString &fileName : files) {
+    MappedFile file(QFile::encodeName(fileName).constData(), MappedFile::Random);
+    if (!file.isValid()) {
+      builtinError(mappingError("tail", fileName, file));
+      continue;
+    }
+
+    // scan backward from the end, the head of the file is never read; +N
+    // skips the first N - 1 lines instead
+    std::size_t skipped = std::size_t(std::max<qint64>(lines - 1, 0));
+    std::size_t offset =
+        fromStart ? TextScan::headLength(file.data(), file.size(), skipped)
+                  : TextScan::tailOffset(file.data(), file.size(), lines);
+    QString output =
+        QString::fromUtf8(file.data() + offset, file.size() - offset);
+
+    if (files.size() > 1) {
+      output.prepend(QString("==> %1 <==\n").arg(fileName));
+    }
+
+    shownBytes = file.size();
+    emit processOutputReady(output);
+  }
+
+  if (!follow || lastExitCode != 0) {
+    return true;
+  }
+
+  // keep streaming appended data until interrupted
+  follower = new FileFollower(files.first(), shownBytes, this);
+  if (!follower->isValid()) {
+    delete follower;
+    follower = nullptr;
+    builtinError(QString("tail: cannot watch '%1'").arg(files.first()));
+    return true;
+  }
+
+  connect(follower, &FileFollower::dataAppended, this,
+          &ProcessManager::processOutputReady);
+  connect(follower, &FileFollower::followError, this,
+          &ProcessManager::processErrorReady);
+
+  builtinPending = true;
+  return true;
+}
+
+// handle grep command implementation
+bool ProcessManager::handleGrep(const QStringList &args) {
+  GrepOptions options;
+  QString pattern;
+  bool havePattern = false;
+  bool optionsDone = false;
+  QStringList paths;
+
+  for (int i = 0; i < args.size(); i++) {
+    const QString &arg = args[i];
+
+    if (optionsDone || !arg.startsWith('-') || arg.size() == 1) {
+      if (!havePattern) {
+        pattern = arg;
+        havePattern = true;
+      } else {
+        paths.append(arg);
+      }
+      continue;
+    }
+
+    if (arg == "--") {
+      optionsDone = true;
+      continue;
+    }
+
+    // combined flags (-rn), -e takes the pattern; other flags, long
+    // options and several patterns are left to the external grep
+    for (int j = 1; j < arg.size(); j++) {
+      QChar flag = arg[j];
+
+      if (flag == 'e') {
+        if (havePattern || (j + 1 == arg.size() && i + 1 == args.size())) {
+          return false;
+        }
+        pattern = j + 1 < arg.size() ? arg.mid(j + 1) : args[++i];
+        havePattern = true;
+        break;
+      }
+
+      if (flag == 'i') {
+        options.ignoreCase = true;
+      } else if (flag == 'v') {
+        options.invert = true;
+      } else if (flag == 'n') {
+        options.lineNumbers = true;
+      } else if (flag == 'c') {
+        options.countOnly = true;
+      } else if (flag == 'l') {
+        options.filesWithMatches = true;
+      } else if (flag == 'r') {
+        options.recursive = true;
+      } else if (flag == 'R') {
+        options.recursive = true;
+        options.followLinks = true;
+      } else if (flag == 'F') {
+        options.fixedStrings = true;
+      } else if (flag == 'w') {
+        options.wordRegexp = true;
+      } else if (flag == 'H') {
+        options.fileNames = 1;
+      } else if (flag == 'h') {
+        options.fileNames = 0;
+      } else if (flag == 'E') {
+        options.extendedRegexp = true;
+      } else if (flag == 'G') {
+        options.extendedRegexp = false;
+      } else {
+        return false; // -o, -q, -A, --color...: the external grep
+      }
+    }
+  }
+
+  // one pattern per line means several patterns
+  if (pattern.contains('\n')) {
+    return false;
+  }
+
+  if (!havePattern) {
+    builtinError("grep: missing pattern\nUsage: grep [OPTION]... PATTERNS "
+                 "[FILE]...");
+    lastExitCode = 2;
+    return true;
+  }
+
+  // recursive search defaults to the working directory
+  if (paths.isEmpty()) {
+    if (!options.recursive) {
+      builtinError("grep: missing file operand");
+      lastExitCode = 2;
+      return true;
+    }
+    paths.append(".");
+  }
+
+  grep = new GrepSearch(pattern, options, this);
+  connect(grep, &GrepSearch::matchesReady, this,
+          &ProcessManager::processHighlightedOutputReady);
+  connect(grep, &GrepSearch::searchError, this,
+          &ProcessManager::processErrorReady);
+  connect(grep, &GrepSearch::finished, this, [this](int exitCode) {
+    grep->deleteLater();
+    grep = nullptr;
+    finishPendingBuiltin(exitCode);
+  });
+
+  grep->start(paths);
+  builtinPending = true;
+  return true;
+}
+
+// Formats bytes like 'du -h' (4.0K, 12M, 1.5G), always rounding up
+static QString humanSize(quint64 bytes) {
+  if (bytes < 1024) {
+    return QString::number(bytes);
+  }
+
+  static const char *units[] = {"K", "M", "G", "T", "P", "E"};
+  double value = bytes;
+  int unit = -1;
+  while (value >= 1024 && unit < 5) {
+    value /= 1024;
+    unit++;
+  }
+
+  if (value < 10) {
+    double rounded = std::ceil(value * 10) / 10;
+    if (rounded < 10) {
+      return QString::number(rounded, 'f', 1) + units[unit];
+    }
+    value = rounded;
+  }
+
+  double rounded = std::ceil(value);
+  if (rounded >= 1024 && unit < 5) {
+    return QString("1.0") + units[unit + 1];
+  }
+
+  return QString::number(qint64(rounded)) + units[unit];
+}
+
+// Directory holding an entry, as the key its own entry is stored under
+static std::string parentKey(const DirectoryWalker::Entry &entry) {
+  std::size_t end = entry.nameOffset;
+  while (end > 1 && entry.path[end - 1] == '/') {
+    end--;
+  }
+  return entry.path.substr(0, end);
+}
+
+// Path without trailing slashes ("/" stays)
+static std::string trimmedKey(const std::string &path) {
+  std::size_t end = path.size();
+  while (end > 1 && path[end - 1] == '/') {
+    end--;
+  }
+  return path.substr(0, end);
+}
+
+// Orders paths so every directory directly precedes its contents
+static bool preorderLess(const std::string &a, const std::string &b) {
+  return std::lexicographical_compare(
+      a.begin(), a.end(), b.begin(), b.end(), [](char x, char y) {
+        unsigned char left = x == '/' ? 0 : static_cast<unsigned char>(x);
+        unsigned char right = y == '/' ? 0 : static_cast<unsigned char>(y);
+        return left < right;
+      });
+}
+
+static bool isAncestor(const std::string &directory, const std::string &path) {
+  if (path.size() <= directory.size() ||
+      path.compare(0, directory.size(), directory) != 0) {
+    return false;
+  }
+  return directory.back() == '/' || path[directory.size()] == '/';
+}
+
+// handle du command implementation
+bool ProcessManager::handleDu(const QStringList &args) {
+  bool summarize = false;
+  bool human = false;
+  bool all = false;
+  bool grandTotal = false;
+  int maxDepth = -1;
+  QStringList paths;
+
+  for (int i = 0; i < args.size(); i++) {
+    const QString &arg = args[i];
+
+    if (arg == "-d" || arg == "--max-depth") {
+      bool ok = i + 1 < args.size();
+      maxDepth = ok ? args[++i].toInt(&ok) : -1;
+      if (!ok || maxDepth < 0) {
+        return false; // the external du reports it
+      }
+      continue;
+    }
+
+    if (arg.startsWith("--max-depth=")) {
+      bool ok = false;
+      maxDepth = arg.mid(12).toInt(&ok);
+      if (!ok || maxDepth < 0) {
+        return false; // the external du reports it
+      }
+      continue;
+    }
+
+    if (!arg.startsWith('-') || arg.size() == 1) {
+      paths.append(arg);
+      continue;
+    }
+
+    if (arg.startsWith("--")) {
+      return false; // --apparent-size, --exclude...: the external du
+    }
+
+    for (QChar flag : arg.mid(1)) {
+      if (flag == 's') {
+        summarize = true;
+      } else if (flag == 'h') {
+        human = true;
+      } else if (flag == 'a') {
+        all = true;
+      } else if (flag == 'c') {
+        grandTotal = true;
+      } else if (flag == 'k') {
+        human = false;
+      } else {
+        return false; // -x, -b, -L...: the external du
+      }
+    }
+  }
+
+  if (summarize) {
+    maxDepth = 0;
+  }
+
+  if (paths.isEmpty()) {
+    paths.append(".");
+  }
+
+  WalkOptions options;
+  options.trackHardlinks = true; // hardlinked files are counted once
+
+  TreeWalk *walk = startTreeWalk("du", options);
+  const int workers = walk->threadCount();
+
+  // per worker totals, merged once the walk completed
+  struct DirectoryTotal {
+    quint64 blocks = 0;
+    int depth = -1;
+  };
+  struct Row {
+    std::string path;
+    quint64 blocks;
+    int depth;
+  };
+  struct Totals {
+    std::vector<std::vector<quint64>> roots;
+    std::vector<std::unordered_map<std::string, DirectoryTotal>> directories;
+    std::vector<std::vector<Row>> files;
+  };
+
+  auto totals = std::make_shared<Totals>();
+  totals->roots.assign(workers, std::vector<quint64>(paths.size(), 0));
+  totals->directories.resize(workers);
+  totals->files.resize(workers);
+
+  DirectoryWalker::Visitor visitor =
+      [totals, summarize, all, maxDepth](const DirectoryWalker::Entry &entry,
+                                         int worker) {
+        if (entry.seenLink) {
+          return true;
+        }
+
+        totals->roots[worker][entry.root] += entry.blocks;
+        if (summarize) {
+          return true;
+        }
+
+        if (entry.type == DirectoryWalker::Directory) {
+          DirectoryTotal &own =
+              totals->directories[worker][trimmedKey(entry.path)];
+          own.blocks += entry.blocks;
+          own.depth = entry.depth;
+          return true;
+        }
+
+        if (entry.depth > 0) {
+          totals->directories[worker][parentKey(entry)].blocks += entry.blocks;
+        }
+
+        if ((all || entry.depth == 0) &&
+            (maxDepth < 0 || entry.depth <= maxDepth)) {
+          totals->files[worker].push_back(
+              {entry.path, entry.blocks, entry.depth});
+        }
+        return true;
+      };
+
+  auto format = [human](quint64 blocks, const std::string &path) {
+    QString size = human ? humanSize(blocks * 512)
+                         : QString::number((blocks + 1) / 2);
+    return size + "\t" + QFile::decodeName(path.c_str()) + "\n";
+  };
+
+  auto finish = [walk, totals, paths, summarize, grandTotal, maxDepth,
+                 format]() {
+    QString output;
+    quint64 total = 0;
+
+    if (summarize) {
+      for (int root = 0; root < paths.size(); root++) {
+        quint64 blocks = 0;
+        for (const auto &worker : totals->roots) {
+          blocks += worker[root];
+        }
+        total += blocks;
+        output += format(blocks, QFile::encodeName(paths[root]).toStdString());
+      }
+    } else {
+      std::unordered_map<std::string, DirectoryTotal> directories;
+      for (auto &worker : totals->directories) {
+        for (auto &[path, own] : worker) {
+          DirectoryTotal &merged = directories[path];
+          merged.blocks += own.blocks;
+          merged.depth = qMax(merged.depth, own.depth);
+        }
+      }
+
+      // deepest first, so every directory is complete before its parent
+      std::vector<std::string> order;
+      for (const auto &[path, own] : directories) {
+        if (own.depth >= 0) {
+          order.push_back(path);
+        }
+      }
+      std::sort(order.begin(), order.end(),
+                [&directories](const std::string &a, const std::string &b) {
+                  return directories.at(a).depth > directories.at(b).depth;
+                });
+
+      std::vector<Row> rows;
+      for (const std::string &path : order) {
+        const DirectoryTotal &own = directories[path];
+        if (own.depth > 0) {
+          std::size_t slash = path.rfind('/');
+          std::string parent =
+              slash == 0 ? std::string("/") : path.substr(0, slash);
+          directories[parent].blocks += own.blocks;
+        }
+        if (maxDepth < 0 || own.depth <= maxDepth) {
+          rows.push_back({path, own.blocks, own.depth});
+        }
+      }
+
+      for (const auto &worker : totals->files) {
+        rows.insert(rows.end(), worker.begin(), worker.end());
+      }
+
+      // print contents before their directory, like du
+      std::sort(rows.begin(), rows.end(), [](const Row &a, const Row &b) {
+        return preorderLess(a.path, b.path);
+      });
+
+      std::vector<const Row *> open;
+      for (const Row &row : rows) {
+        while (!open.empty() && !isAncestor(open.back()->path, row.path)) {
+          output += format(open.back()->blocks, open.back()->path);
+          open.pop_back();
+        }
+        open.push_back(&row);
+      }
+      while (!open.empty()) {
+        output += format(open.back()->blocks, open.back()->path);
+        open.pop_back();
+      }
+
+      for (const auto &worker : totals->roots) {
+        for (quint64 blocks : worker) {
+          total += blocks;
+        }
+      }
+    }
+
+    if (grandTotal) {
+      output += format(total, "total");
+    }
+
+    walk->appendOutput(output);
+  };
+
+  walk->start(paths, visitor, finish);
+  return true;
+}
+
+// handle find command implementation
+bool ProcessManager::handleFind(const QStringList &args) {
+  QStringList paths;
+  int i = 0;
+  // '!' and '(' start an expression too, left to the external find
+  while (i < args.size() && !args[i].startsWith('-') && args[i] != "!" &&
+         args[i] != "(") {
+    paths.append(args[i++]);
+  }
+
+  // tests are combined with an implicit -and
+  std::string namePattern;
+  int nameFlags = 0;
+  bool matchName = false;
+  DirectoryWalker::EntryType type = DirectoryWalker::Unknown;
+  bool matchSize = false;
+  int sizeCompare = 0; // -1 smaller, 0 exactly, 1 larger
+  quint64 sizeValue = 0;
+  quint64 sizeUnit = 512;
+  int minDepth = 0;
+  WalkOptions options;
+  options.needMetadata = false; // names and types come from d_type
+
+  for (; i < args.size(); i++) {
+    const QString &test = args[i];
+
+    if (test == "-print") {
+      continue;
+    }
+
+    if (i + 1 >= args.size()) {
+      return false; // -print0, -delete, a missing argument: the external find
+    }
+    const QString value = args[++i];
+
+    // a repeated test is one more -and, which the walk keeps only once
+    if (((test == "-name" || test == "-iname") && matchName) ||
+        (test == "-type" && type != DirectoryWalker::Unknown) ||
+        (test == "-size" && matchSize)) {
+      return false;
+    }
+
+    if (test == "-name" || test == "-iname") {
+      namePattern = QFile::encodeName(value).toStdString();
+      nameFlags = test == "-iname" ? FNM_CASEFOLD : 0;
+      matchName = true;
+    } else if (test == "-type") {
+      if (value == "f") {
+        type = DirectoryWalker::Regular;
+      } else if (value == "d") {
+        type = DirectoryWalker::Directory;
+      } else if (value == "l") {
+        type = DirectoryWalker::Symlink;
+      } else {
+        return false; // sockets, pipes, devices, lists of types
+      }
+    } else if (test == "-size") {
+      QString number = value;
+      if (number.startsWith('+') || number.startsWith('-')) {
+        sizeCompare = number.startsWith('+') ? 1 : -1;
+        number.remove(0, 1);
+      }
+
+      static const QString suffixes = "ckMGb";
+      static const quint64 units[] = {1, 1024, 1024 * 1024,
+                                      1024 * 1024 * 1024, 512};
+      int suffix = number.isEmpty() ? -1 : suffixes.indexOf(number.back());
+      if (suffix >= 0) {
+        sizeUnit = units[suffix];
+        number.chop(1);
+      }
+
+      bool ok = false;
+      sizeValue = number.toULongLong(&ok);
+      if (!ok) {
+        return false; // the external find reports it
+      }
+      matchSize = true;
+      options.needMetadata = true;
+    } else if (test == "-maxdepth" || test == "-mindepth") {
+      bool ok = false;
+      int depth = value.toInt(&ok);
+      if (!ok || depth < 0) {
+        return false; // the external find reports it
+      }
+      if (test == "-maxdepth") {
+        options.maxDepth = depth;
+      } else {
+        minDepth = depth;
+      }
+    } else {
+      return false; // -exec, -o, -newer, -path...: the external find
+    }
+  }
+
+  if (paths.isEmpty()) {
+    paths.append(".");
+  }
+
+  TreeWalk *walk = startTreeWalk("find", options);
+
+  // matches are batched per worker before taking the output lock
+  auto buffers = std::make_shared<std::vector<QString>>(walk->threadCount());
+
+  DirectoryWalker::Visitor visitor = [=](const DirectoryWalker::Entry &entry,
+                                         int worker) {
+    if (entry.depth < minDepth) {
+      return true;
+    }
+    if (type != DirectoryWalker::Unknown && entry.type != type) {
+      return true;
+    }
+    if (matchName &&
+        ::fnmatch(namePattern.c_str(), entry.name(), nameFlags) != 0) {
+      return true;
+    }
+    if (matchSize) {
+      // sizes are rounded up to whole units, like find
+      quint64 size = (entry.size + sizeUnit - 1) / sizeUnit;
+      if ((sizeCompare > 0 && size <= sizeValue) ||
+          (sizeCompare < 0 && size >= sizeValue) ||
+          (sizeCompare == 0 && size != sizeValue)) {
+        return true;
+      }
+    }
+
+    QString &buffer = (*buffers)[worker];
+    buffer += QFile::decodeName(entry.path.c_str());
+    buffer += "\n";
+    if (buffer.size() > 16384) {
+      walk->appendOutput(buffer);
+      buffer.clear();
+    }
+    return true;
+  };
+
+  auto finish = [walk, buffers]() {
+    for (QString &buffer : *buffers) {
+      walk->appendOutput(buffer);
+    }
+  };
+
+  walk->start(paths, visitor, finish);
+  return true;
+}
+
+// handle cd command implementation
+bool ProcessManager::handleCd(const QStringList &args) {
+  // go home directory without arguments
+  QString newDIR = args.isEmpty() ? QDir::homePath() : args.first();
+
+  changeDirectory("cd", newDIR);
+  return true;
+}
+
+bool ProcessManager::changeDirectory(const QString &name,
+                                     const QString &path) {
+  // validate path existance
+  if (!QDir(path).exists() || !QDir::setCurrent(path)) {
+    builtinError(name + ": no such file or directory: " + path);
+    return false;
+  }
+
+  QString current = QDir::currentPath();
+  directoryIndex->recordVisit(QFile::encodeName(current).toStdString());
+  emit directoryChanged(current);
+  return true;
+}
+
+// Directory with the home directory shown as '~'
+static QString tildePath(const QString &path) {
+  QString home = QDir::homePath();
+  if (path == home) {
+    return "~";
+  }
+  if (path.startsWith(home + '/')) {
+    return '~' + path.mid(home.size());
+  }
+  return path;
+}
+
+void ProcessManager::printDirectoryStack(bool verbose, bool fullPaths) {
+  QStringList stack = directoryStack;
+  stack.prepend(QDir::currentPath());
+
+  QString output;
+  for (int i = 0; i < stack.size(); i++) {
+    QString path = fullPaths ? stack[i] : tildePath(stack[i]);
+    if (verbose) {
+      output += QString("%1  %2\n").arg(i, 2).arg(path);
+    } else {
+      output += (i ? " " : "") + path;
+    }
+  }
+
+  emit processOutputReady(verbose ? output : output + "\n");
+}
+
+bool ProcessManager::handlePushd(const QStringList &args) {
+  QString previous = QDir::currentPath();
+
+  // without arguments the top two directories trade places
+  if (args.isEmpty()) {
+    if (directoryStack.isEmpty()) {
+      builtinError("pushd: no other directory");
+      return true;
+    }
+    if (changeDirectory("pushd", directoryStack.first())) {
+      directoryStack.first() = previous;
+      printDirectoryStack(false, false);
+    }
+    return true;
+  }
+
+  // +N brings entry N of 'dirs' to the top, the stack is rotated
+  bool rotate = false;
+  int index = args.first().startsWith('+') ? args.first().mid(1).toInt(&rotate)
+                                           : 0;
+  if (rotate) {
+    QStringList stack = directoryStack;
+    stack.prepend(previous);
+    if (index >= stack.size()) {
+      builtinError("pushd: " + args.first() + ": directory stack index out "
+                   "of range");
+      return true;
+    }
+
+    std::rotate(stack.begin(), stack.begin() + index, stack.end());
+    if (changeDirectory("pushd", stack.first())) {
+      stack.removeFirst();
+      directoryStack = stack;
+      printDirectoryStack(false, false);
+    }
+    return true;
+  }
+
+  if (changeDirectory("pushd", args.first())) {
+    directoryStack.prepend(previous);
+    printDirectoryStack(false, false);
+  }
+  return true;
+}
+
+bool ProcessManager::handlePopd(const QStringList &args) {
+  if (directoryStack.isEmpty()) {
+    builtinError("popd: directory stack empty");
+    return true;
+  }
+
+  // +N drops entry N of 'dirs' (N > 0) without changing directory
+  if (!args.isEmpty()) {
+    bool valid = false;
+    int index = args.first().mid(1).toInt(&valid) - 1;
+    if (!args.first().startsWith('+') || !valid || index < -1 ||
+        index >= directoryStack.size()) {
+      builtinError("popd: " + args.first() + ": invalid argument");
+      return true;
+    }
+    if (index >= 0) {
+      directoryStack.removeAt(index);
+      printDirectoryStack(false, false);
+      return true;
+    }
+  }
+
+  if (changeDirectory("popd", directoryStack.first())) {
+    directoryStack.removeFirst();
+    printDirectoryStack(false, false);
+  }
+  return true;
+}
+
+bool ProcessManager::handleDirs(const QStringList &args) {
+  bool verbose = false;
+  bool fullPaths = false;
+
+  for (const QString &arg : args) {
+    if (arg == "-c") {
+      directoryStack.clear();
+      return true;
+    } else if (arg == "-v") {
+      verbose = true;
+    } else if (arg == "-l") {
+      fullPaths = true;
+    } else {
+      builtinError("dirs: invalid option: " + arg);
+      return true;
+    }
+  }
+
+  printDirectoryStack(verbose, fullPaths);
+  return true;
+}
+
+bool ProcessManager::handleZ(const QStringList &args) {
+  bool list = false;
+  std::vector<std::string> words;
+
+  for (const QString &arg : args) {
+    if (arg == "-l") {
+      list = true;
+    } else if (arg == "-x") {
+      // forget the current directory
+      directoryIndex->remove(
+          QFile::encodeName(QDir::currentPath()).toStdString());
+      return true;
+    } else {
+      words.push_back(arg.toStdString());
+    }
+  }
+
+  // an existing path is entered directly, like cd
+  if (!list && args.size() == 1 && QFileInfo(args.first()).isDir() &&
+      (args.first().contains('/') || args.first().startsWith('.'))) {
+    changeDirectory("z", args.first());
+    return true;
+  }
+
+  if (!list && words.empty()) {
+    changeDirectory("z", QDir::homePath());
+    return true;
+  }
+
+  std::vector<DirectoryIndex::Match> matches = directoryIndex->query(words);
+
+  if (list) {
+    // lowest score first, the best match ends up next to the prompt
+    QString output;
+    for (auto match = matches.rbegin(); match != matches.rend(); ++match) {
+      output += QString("%1  %2\n")
+                    .arg(match->score, 10, 'f', 1)
+                    .arg(QFile::decodeName(match->path.c_str()));
+    }
+    emit processOutputReady(output);
+    return true;
+  }
+
+  // best match that still exists, gone directories are forgotten
+  for (const DirectoryIndex::Match &match : matches) {
+    QString path = QFile::decodeName(match.path.c_str());
+    if (path == QDir::currentPath() && matches.size() > 1) {
+      continue;
+    }
+    if (!QFileInfo(path).isDir()) {
+      directoryIndex->remove(match.path);
+      continue;
+    }
+    changeDirectory("z", path);
+    return true;
+  }
+
+  builtinError("z: no match for: " + args.join(' '));
+  return true;
+}
+
+// handle echo command implementation
+bool ProcessManager::handleEcho(const QStringList &args) {
+  QStringList words = args;
+  bool newline = true;
+
+  // -n suppresses the trailing newline
+  if (!words.isEmpty() && words.first() == "-n") {
+    newline = false;
+    words.removeFirst();
+  }
+
+  emit processOutputReady(words.join(' ') + (newline ? "\n" : ""));
+  return true;
+}
+
+// Entry of an ls listing with its display width
+struct ListEntry {
+  QString name;
+  int width = 0;
+  bool directory = false;
+};
+
+static ListEntry listEntry(const QString &name, const QFileInfo &info) {
+  ListEntry entry;
+  entry.name = name;
+  entry.width = TextWidth::displayWidth(
+      reinterpret_cast<const char16_t *>(name.utf16()), name.size());
+  entry.directory = info.isDir();
+  return entry;
+}
+
+// Lays entries out column by column like ls on a terminal, 0 columns
+// prints one entry per line
+static void appendColumns(const QList<ListEntry> &entries, int columns,
+                          QString &output, QList<OutputSpan> &spans) {
+  int count = entries.size();
+  int columnCount = 1;
+  QList<int> widths(1, 0);
+
+  // most columns first, names need at least one column and two spaces
+  if (columns > 0) {
+    for (int tried = std::min<int>(count, std::max(1, columns / 3)); tried > 1;
+         tried--) {
+      int rows = (count + tried - 1) / tried;
+      if ((tried - 1) * rows >= count) {
+        continue; // last column would stay empty
+      }
+
+      QList<int> triedWidths(tried, 0);
+      for (int i = 0; i < count; i++) {
+        triedWidths[i / rows] = std::max(triedWidths[i / rows], entries[i].width);
+      }
+
+      int total = 2 * (tried - 1);
+      for (int width : triedWidths) {
+        total += width;
+      }
+
+      if (total <= columns) {
+        columnCount = tried;
+        widths = triedWidths;
+        break;
+      }
+    }
+  }
+
+  int rows = (count + columnCount - 1) / columnCount;
+  for (int row = 0; row < rows; row++) {
+    for (int column = 0; column < columnCount; column++) {
+      int index = column * rows + row;
+      if (index >= count) {
+        break;
+      }
+
+      const ListEntry &entry = entries[index];
+      if (entry.directory) {
+        spans.append({int(output.size()), int(entry.name.size()),
+                      OutputSpan::Directory});
+      }
+      output += entry.name;
+
+      // pad by display width, not by UTF-16 length
+      if (index + rows < count) {
+        output += QString(widths[column] - entry.width + 2, QChar(' '));
+      }
+    }
+    output += '\n';
+  }
+}
+
+// ls command implementation
+bool ProcessManager::handleLs(const QStringList &args) {
+  bool all = false;
+  bool almostAll = false;
+  bool onePerLine = false;
+  QStringList paths;
+
+  for (const QString &arg : args) {
+    if (arg.size() < 2 || !arg.startsWith('-')) {
+      paths.append(arg);
+      continue;
+    }
+
+    for (QChar flag : arg.mid(1)) {
+      if (flag == 'a') {
+        all = true;
+      } else if (flag == 'A') {
+        almostAll = true;
+      } else if (flag == '1') {
+        onePerLine = true;
+      } else {
+        return false; // -l, -t, long options: the external ls
+      }
+    }
+  }
+
+  if (paths.isEmpty()) {
+    paths.append(".");
+  }
+
+  int columns = onePerLine ? 0 : terminalColumns;
+
+  // file operands are listed together, before the directories
+  QList<ListEntry> files;
+  QStringList directories;
+  for (const QString &path : paths) {
+    QFileInfo info(path);
+    if (!info.exists() && !info.isSymLink()) {
+      builtinError(
+          QString("ls: cannot access '%1': No such file or directory").arg(path));
+      continue;
+    }
+
+    if (info.isDir()) {
+      directories.append(path);
+    } else {
+      files.append(listEntry(path, info));
+    }
+  }
+
+  QString output;
+  QList<OutputSpan> spans;
+  appendColumns(files, columns, output, spans);
+
+  QDir::Filters filters = QDir::AllEntries | QDir::System;
+  if (all || almostAll) {
+    filters |= QDir::Hidden;
+  }
+  if (!all) {
+    filters |= QDir::NoDotAndDotDot;
+  }
+
+  for (const QString &path : directories) {
+    QDir directory(path);
+    if (!directory.isReadable()) {
+      builtinError(
+          QString("ls: cannot open directory '%1': Permission denied").arg(path));
+      continue;
+    }
+
+    if (paths.size() > 1) {
+      if (!output.isEmpty()) {
+        output += '\n';
+      }
+      output += path + ":\n";
+    }
+
+    QList<ListEntry> entries;
+    const QFileInfoList infos =
+        directory.entryInfoList(filters, QDir::Name | QDir::LocaleAware);
+    for (const QFileInfo &info : infos) {
+      entries.append(listEntry(info.fileName(), info));
+    }
+
+    appendColumns(entries, columns, output, spans);
+  }
+
+  if (!output.isEmpty()) {
+    emit processHighlightedOutputReady(output, spans);
+  }
+
+  return true;
+}
+
+// record command implementation
+bool ProcessManager::handleRecord(const QStringList &args) {
+  if (args.isEmpty()) {
+    emit processOutputReady(
+        recorder->isRecording()
+            ? QString("record: recording to '%1'\n").arg(recorder->path())
+            : QString("record: not recording\n"));
+    return true;
+  }
+
+  if (args.size() > 1) {
+    builtinError("record: usage: record FILE | record stop");
+    return true;
+  }
+
+  if (args.first() == "stop") {
+    if (!recorder->isRecording()) {
+      builtinError("record: not recording");
+      return true;
+    }
+
+    QString path = recorder->path();
+    recorder->stop();
+    emit processOutputReady(QString("record: saved '%1'\n").arg(path));
+    return true;
+  }
+
+  // header size, the display only knows its width
+  int width = terminalColumns > 0 ? terminalColumns
+                                  : qEnvironmentVariableIntValue("COLUMNS");
+  int height = qEnvironmentVariableIntValue("LINES");
+
+  QString reason;
+  if (!recorder->start(args.first(), width > 0 ? width : 80,
+                       height > 0 ? height : 24, &reason)) {
+    builtinError(
+        QString("record: cannot create '%1': %2").arg(args.first(), reason));
+  }
+
+  return true;
+}
+
+// replay command implementation
+bool ProcessManager::handleReplay(const QStringList &args) {
+  double speed = 1;
+  QString path;
+
+  for (int i = 0; i < args.size(); i++) {
+    const QString &arg = args[i];
+
+    if (arg == "-f" || arg == "--fast") {
+      speed = 0;
+    } else if (arg == "-s" && i + 1 < args.size()) {
+      bool valid = false;
+      speed = args[++i].toDouble(&valid);
+      if (!valid || speed <= 0) {
+        builtinError(QString("replay: invalid speed '%1'").arg(args[i]));
+        return true;
+      }
+    } else if (path.isEmpty() && !arg.startsWith('-')) {
+      path = arg;
+    } else {
+      builtinError("replay: usage: replay [-f] [-s SPEED] FILE");
+      return true;
+    }
+  }
+
+  if (path.isEmpty()) {
+    builtinError("replay: usage: replay [-f] [-s SPEED] FILE");
+    return true;
+  }
+
+  replay = new SessionReplay(this);
+
+  QString reason;
+  if (!replay->load(path, &reason)) {
+    delete replay;
+    replay = nullptr;
+    builtinError(QString("replay: '%1': %2").arg(path, reason));
+    return true;
+  }
+
+  connect(replay, &SessionReplay::outputReady, this,
+          &ProcessManager::processOutputReady);
+  connect(replay, &SessionReplay::errorReady, this,
+          &ProcessManager::processErrorReady);
+  connect(replay, &SessionReplay::finished, this, [this, speed]() {
+    // fast replays measure how quickly the display keeps up
+    if (speed <= 0) {
+      emit processOutputReady(replay->statistics());
+    }
+
+    replay->deleteLater();
+    replay = nullptr;
+    finishPendingBuiltin(0);
+  });
+
+  builtinPending = true;
+  replay->start(speed);
+  return true;
+}
+
+// watch command implementation
+bool ProcessManager::handleWatch(const QStringList &args) {
+  double interval = 2;
+  bool highlight = false;
+  bool title = true;
+  int i = 0;
+
+  for (; i < args.size() && args[i].startsWith('-'); i++) {
+    const QString &arg = args[i];
+
+    if (arg == "--") {
+      i++;
+      break;
+    } else if (arg == "-d" || arg == "--differences") {
+      highlight = true;
+    } else if (arg == "-t" || arg == "--no-title") {
+      title = false;
+    } else if ((arg == "-n" || arg == "--interval") && i + 1 < args.size()) {
+      bool valid = false;
+      interval = args[++i].toDouble(&valid);
+      if (!valid || interval <= 0) {
+        builtinError(QString("watch: invalid interval '%1'").arg(args[i]));
+        return true;
+      }
+    } else {
+      builtinError("watch: usage: watch [-n SECONDS] [-d] [-t] COMMAND");
+      return true;
+    }
+  }
+
+  if (i >= args.size()) {
+    builtinError("watch: usage: watch [-n SECONDS] [-d] [-t] COMMAND");
+    return true;
+  }
+
+  // like watch, the words form one shell command line
+  QString commandLine = args.mid(i).join(' ');
+
+  watch = new WatchCommand(commandLine, interval, terminalColumns, highlight,
+                           title, this);
+  connect(watch, &WatchCommand::regionUpdated, this,
+          &ProcessManager::pinnedRegionUpdated);
+  connect(watch, &WatchCommand::errorReady, this,
+          &ProcessManager::processErrorReady);
+
+  builtinPending = true;
+  watch->start();
+  return true;
+}
+
+// Input lines of a ':::: FILE' source, '-' is the shell's standard input
+static bool readInputLines(const QString &path, QStringList *inputs) {
+  QFile file(path);
+  bool opened = path == "-" ? file.open(stdin, QIODevice::ReadOnly)
+                            : file.open(QIODevice::ReadOnly);
+  if (!opened) {
+    return false;
+  }
+
+  QStringList lines = QString::fromUtf8(file.readAll()).split('\n');
+  for (const QString &line : lines) {
+    if (!line.isEmpty()) {
+      inputs->append(line);
+    }
+  }
+  return true;
+}
+
+// parallel command implementation
+bool ProcessManager::handleParallel(const QStringList &args) {
+  const QString usage =
+      "parallel: usage: parallel [-j N] [-k] COMMAND [::: ARGS] [:::: FILES]";
+  int jobs = QThread::idealThreadCount();
+  bool keepOrder = false;
+  int i = 0;
+
+  for (; i < args.size() && args[i].startsWith('-'); i++) {
+    const QString &arg = args[i];
+
+    if (arg == "-k" || arg == "--keep-order") {
+      keepOrder = true;
+    } else if ((arg == "-j" || arg == "--jobs") && i + 1 < args.size()) {
+      bool valid = false;
+      jobs = args[++i].toInt(&valid);
+      if (!valid || jobs <= 0) {
+        builtinError(QString("parallel: invalid job count '%1'").arg(args[i]));
+        return true;
+      }
+    } else {
+      builtinError(usage);
+      return true;
+    }
+  }
+
+  // command words up to the first input source
+  QStringList words;
+  for (; i < args.size() && args[i] != ":::" && args[i] != "::::"; i++) {
+    words << args[i];
+  }
+
+  if (words.isEmpty()) {
+    builtinError(usage);
+    return true;
+  }
+
+  QStringList inputs;
+  bool fromFiles = false;
+  bool hasSource = i < args.size();
+
+  for (; i < args.size(); i++) {
+    if (args[i] == ":::" || args[i] == "::::") {
+      fromFiles = args[i] == "::::";
+      continue;
+    }
+
+    if (!fromFiles) {
+      inputs << args[i];
+    } else if (!readInputLines(args[i], &inputs)) {
+      builtinError(QString("parallel: cannot read '%1'").arg(args[i]));
+      return true;
+    }
+  }
+
+  // without ::: or ::::, lines come from standard input unless it's a terminal
+  if (!hasSource) {
+    if (isatty(STDIN_FILENO)) {
+      builtinError("parallel: no input, use ::: ARGS or :::: FILES");
+      return true;
+    }
+    readInputLines("-", &inputs);
+  }
+
+  if (inputs.isEmpty()) {
+    return true;
+  }
+
+  parallel = new ParallelRunner(words, inputs, jobs, keepOrder, this);
+  connect(parallel, &ParallelRunner::jobFinished, this,
+          [this](QString output, QString error) {
+            // one piece per job, never interleaved with other jobs
+            if (!output.isEmpty()) {
+              emit processOutputReady(output);
+            }
+            if (!error.isEmpty()) {
+              emit processErrorReady(error);
+            }
+          });
+  connect(parallel, &ParallelRunner::progressChanged, this,
+          &ProcessManager::progressChanged);
+  connect(parallel, &ParallelRunner::finished, this, [this](int failed) {
+    parallel->deleteLater();
+    parallel = nullptr;
+
+    // like GNU parallel, the number of failed jobs (at most 101)
+    finishPendingBuiltin(std::min(failed, 101));
+  });
+
+  builtinPending = true;
+  parallel->start();
+  return true;
+}
+
+// view / less command implementation
+bool ProcessManager::handleView(const QStringList &args) {
+  qint64 line = 0;
+  QStringList files;
+
+  for (const QString &arg : args) {
+    bool valid = false;
+    qint64 number = arg.startsWith('+') ? arg.mid(1).toLongLong(&valid) : 0;
+    if (valid) {
+      line = std::max<qint64>(0, number - 1);
+    } else {
+      files.append(arg);
+    }
+  }
+
+  if (files.size() != 1) {
+    builtinError("view: usage: view [+LINE] FILE");
+    return true;
+  }
+
+  // without a screen to page on the file is just printed
+  if (terminalRows == 0) {
+    return handleCat(files);
+  }
+
+  auto file = std::make_unique<MappedFile>(
+      QFile::encodeName(files.first()).constData(), MappedFile::Random);
+  if (file->isDirectory()) {
+    builtinError("view: " + files.first() + ": Is a directory");
+    return true;
+  }
+  if (!file->isValid()) {
+    builtinError(mappingError("view", files.first(), *file));
+    return true;
+  }
+
+  pager = new FilePager(files.first(), std::move(file), terminalRows,
+                        terminalColumns, this);
+  connect(pager, &FilePager::pageChanged, this,
+          &ProcessManager::pinnedRegionUpdated);
+  connect(pager, &FilePager::finished, this, [this]() {
+    closePager();
+    finishPendingBuiltin(0);
+  });
+
+  builtinPending = true;
+  pager->start(line);
+  return true;
+}
+
+// trace command implementation
+bool ProcessManager::handleTrace(const QStringList &args) {
+#ifdef QSHELL_TRACING
+  if (args.size() == 1 && args.first() == "clear") {
+    Trace::clear();
+    return true;
+  }
+
+  if (args.size() == 2 && args.first() == "dump") {
+    std::string error;
+    long count = Trace::writeChromeTrace(
+        QFile::encodeName(args[1]).toStdString(), &error);
+    if (count < 0) {
+      builtinError("trace: " + args[1] + ": " +
+                   QString::fromLocal8Bit(error.c_str()));
+      return true;
+    }
+
+    emit processOutputReady(
+        QString("trace: %1 events written to %2\n").arg(count).arg(args[1]));
+    return true;
+  }
+
+  builtinError("trace: usage: trace dump FILE | trace clear");
+#else
+  Q_UNUSED(args);
+  builtinError("trace: built without QSHELL_TRACING");
+#endif
+  return true;
+}
+
+void ProcessManager::closePager() {
+  // the page goes away with the pager, like leaving less
+  pager->deleteLater();
+  pager = nullptr;
+  emit pinnedRegionUpdated(0, {});
+  emit pinnedRegionClosed();
+}
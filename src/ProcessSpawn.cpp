@@ -0,0 +1,173 @@
+#include "ProcessSpawn.h"
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <fcntl.h>
+#include <memory>
+#include <mutex>
+#include <spawn.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+
+extern char **environ;
+
+namespace {
+
+// Immutable copy of the environment handed to every child
+struct EnvironmentBlock {
+  std::vector<std::string> strings;
+  std::vector<char *> pointers; // into strings, null terminated
+};
+
+std::mutex environmentMutex;
+std::shared_ptr<const EnvironmentBlock> environmentBlock;
+std::atomic<unsigned> environmentGeneration{1};
+unsigned builtGeneration = 0;
+
+std::mutex lookupMutex;
+std::unordered_map<std::string, std::string> lookupCache; // name -> path
+std::string lookupPath; // PATH the cache was filled with
+
+std::shared_ptr<const EnvironmentBlock> currentEnvironment() {
+  std::lock_guard<std::mutex> lock(environmentMutex);
+
+  unsigned generation = environmentGeneration;
+  if (environmentBlock && builtGeneration == generation) {
+    return environmentBlock;
+  }
+
+  auto block = std::make_shared<EnvironmentBlock>();
+  for (char **variable = environ; variable && *variable; variable++) {
+    block->strings.emplace_back(*variable);
+  }
+  for (std::string &variable : block->strings) {
+    block->pointers.push_back(variable.data());
+  }
+  block->pointers.push_back(nullptr);
+
+  environmentBlock = block;
+  builtGeneration = generation;
+  return environmentBlock;
+}
+
+bool isExecutableFile(const std::string &path) {
+  struct stat info;
+  return ::stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode) &&
+         ::access(path.c_str(), X_OK) == 0;
+}
+
+} // namespace
+
+std::string ProcessSpawn::resolveExecutable(const std::string &name) {
+  if (name.empty()) {
+    return {};
+  }
+
+  if (name.find('/') != std::string::npos) {
+    return isExecutableFile(name) ? name : std::string();
+  }
+
+  const char *pathVariable = std::getenv("PATH");
+  std::string searchPath = pathVariable ? pathVariable : "/usr/bin:/bin";
+
+  std::lock_guard<std::mutex> lock(lookupMutex);
+  if (searchPath != lookupPath) {
+    lookupCache.clear();
+    lookupPath = searchPath;
+  }
+
+  auto cached = lookupCache.find(name);
+  if (cached != lookupCache.end()) {
+    return cached->second;
+  }
+
+  std::size_t begin = 0;
+  while (begin <= searchPath.size()) {
+    std::size_t end = searchPath.find(':', begin);
+    if (end == std::string::npos) {
+      end = searchPath.size();
+    }
+
+    std::string directory = searchPath.substr(begin, end - begin);
+    begin = end + 1;
+
+    std::string candidate =
+        (directory.empty() ? std::string(".") : directory) + "/" + name;
+    if (!isExecutableFile(candidate)) {
+      continue;
+    }
+
+    // relative PATH entries depend on the working directory
+    if (!directory.empty() && directory[0] == '/') {
+      lookupCache.emplace(name, candidate);
+    }
+    return candidate;
+  }
+
+  // misses are not cached, the command may be installed later
+  return {};
+}
+
+void ProcessSpawn::forgetExecutable(const std::string &name) {
+  std::lock_guard<std::mutex> lock(lookupMutex);
+  lookupCache.erase(name);
+}
+
+void ProcessSpawn::environmentChanged() { environmentGeneration++; }
+
+pid_t ProcessSpawn::spawn(const std::string &path,
+                          const std::vector<std::string> &args, int outputFd,
+                          int errorFd, int *error) {
+  std::vector<char *> argv;
+  for (const std::string &arg : args) {
+    argv.push_back(const_cast<char *>(arg.c_str()));
+  }
+  argv.push_back(nullptr);
+
+  std::shared_ptr<const EnvironmentBlock> environment = currentEnvironment();
+
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null",
+                                   O_RDONLY, 0);
+  posix_spawn_file_actions_adddup2(&actions, outputFd, STDOUT_FILENO);
+  posix_spawn_file_actions_adddup2(&actions, errorFd, STDERR_FILENO);
+
+  // ignored dispositions survive exec, the child gets the defaults back
+  sigset_t defaults;
+  sigemptyset(&defaults);
+  for (int signal : {SIGINT, SIGQUIT, SIGPIPE, SIGTERM, SIGCHLD, SIGTSTP,
+                     SIGTTIN, SIGTTOU}) {
+    sigaddset(&defaults, signal);
+  }
+
+  sigset_t mask;
+  sigemptyset(&mask);
+
+  posix_spawnattr_t attributes;
+  posix_spawnattr_init(&attributes);
+  posix_spawnattr_setsigdefault(&attributes, &defaults);
+  posix_spawnattr_setsigmask(&attributes, &mask);
+
+  short flags = POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETSIGMASK;
+#ifdef POSIX_SPAWN_USEVFORK
+  flags |= POSIX_SPAWN_USEVFORK;
+#endif
+  posix_spawnattr_setflags(&attributes, flags);
+
+  pid_t pid = -1;
+  int result = posix_spawn(&pid, path.c_str(), &actions, &attributes,
+                           argv.data(), environment->pointers.data());
+
+  posix_spawnattr_destroy(&attributes);
+  posix_spawn_file_actions_destroy(&actions);
+
+  if (result != 0) {
+    *error = result;
+    return -1;
+  }
+
+  return pid;
+}
@@ -0,0 +1,151 @@
+#include "PromptEngine.h"
+#include <QDir>
+#include <QFileInfo>
+
+// Color of a segment that has not been computed yet
+static const char *placeholderColor = "#5C6370";
+
+PromptEngine::PromptEngine(QObject *parent) : QObject(parent) {
+  // one worker: segments queue behind each other instead of racing
+  pool.setMaxThreadCount(1);
+
+  connect(&watcher, &QFileSystemWatcher::fileChanged, this,
+          &PromptEngine::watchedPathChanged);
+}
+
+PromptEngine::~PromptEngine() {
+  pool.clear();
+  pool.waitForDone();
+}
+
+void PromptEngine::addSegment(std::shared_ptr<PromptSegment> segment) {
+  segments.append(std::move(segment));
+}
+
+void PromptEngine::commandStarted() { commandTimer.start(); }
+
+void PromptEngine::commandFinished(int exitCode) {
+  context.exitCode = exitCode;
+  context.durationMs = commandTimer.isValid() ? commandTimer.elapsed() : -1;
+  commandTimer.invalidate();
+
+  // commands may have touched files, cached text is shown and refreshed
+  for (auto it = cache.cbegin(); it != cache.cend(); ++it) {
+    stale.insert(it.key());
+  }
+}
+
+QList<PromptPart> PromptEngine::prompt(const QString &cwd) {
+  context.cwd = cwd;
+  context.home = QDir::homePath();
+  parts.clear();
+
+  for (int index = 0; index < segments.size(); index++) {
+    const PromptSegment &segment = *segments[index];
+
+    if (!segment.isAsync()) {
+      parts.append(partFor(index, segment.render(context).text));
+      continue;
+    }
+
+    QString key = cacheKey(index);
+    auto cached = cache.constFind(key);
+
+    if (cached != cache.cend()) {
+      parts.append(partFor(index, *cached));
+      if (stale.contains(key)) {
+        schedule(index);
+      }
+      continue;
+    }
+
+    parts.append({segment.placeholder(context), placeholderColor, true});
+    schedule(index);
+  }
+
+  return parts;
+}
+
+QList<PromptPart> PromptEngine::currentPrompt() const { return parts; }
+
+QString PromptEngine::plainText(const QList<PromptPart> &parts) {
+  QString text;
+  for (const PromptPart &part : parts) {
+    text += part.text;
+  }
+  return text;
+}
+
+QString PromptEngine::cacheKey(int index) const {
+  return segments[index]->name() + "\n" + segments[index]->cacheKey(context);
+}
+
+PromptPart PromptEngine::partFor(int index, const QString &text) const {
+  return {text, segments[index]->color(), false};
+}
+
+void PromptEngine::schedule(int index) {
+  QString key = cacheKey(index);
+
+  // a refresh already running picks up the latest state when it is done
+  if (rendering.contains(key)) {
+    return;
+  }
+
+  rendering.insert(key);
+  stale.remove(key);
+
+  std::shared_ptr<PromptSegment> segment = segments[index];
+  PromptContext snapshot = context;
+
+  pool.start([this, segment, snapshot, index, key]() {
+    PromptValue value = segment->render(snapshot);
+
+    // back to the UI thread, dropped if the engine is gone
+    QMetaObject::invokeMethod(
+        this,
+        [this, index, key, value]() { segmentRendered(index, key, value); },
+        Qt::QueuedConnection);
+  });
+}
+
+void PromptEngine::segmentRendered(int index, const QString &key,
+                                   const PromptValue &value) {
+  rendering.remove(key);
+
+  bool changed = cache.value(key) != value.text || !cache.contains(key);
+  cache.insert(key, value.text);
+
+  // files replaced by rename (git index) drop out of the watcher
+  for (const QString &path : value.watchPaths) {
+    watchedKeys[path].insert(key);
+    if (!watcher.files().contains(path) && QFileInfo::exists(path)) {
+      watcher.addPath(path);
+    }
+  }
+
+  bool shown = index < parts.size() && cacheKey(index) == key;
+
+  // invalidated while rendering
+  if (shown && stale.contains(key)) {
+    schedule(index);
+  }
+
+  if (!shown || (!changed && !parts[index].placeholder)) {
+    return;
+  }
+
+  parts[index] = partFor(index, value.text);
+  emit promptUpdated();
+}
+
+void PromptEngine::watchedPathChanged(const QString &path) {
+  const QSet<QString> keys = watchedKeys.value(path);
+  stale.unite(keys);
+
+  for (int index = 0; index < segments.size(); index++) {
+    if (segments[index]->isAsync() && keys.contains(cacheKey(index))) {
+      schedule(index);
+    }
+  }
+}
@@ -0,0 +1,184 @@
+#include "PromptSegment.h"
+#include "ProcessSpawn.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+TextSegment::TextSegment(const QString &name, const QString &text,
+                         const QString &color)
+    : segmentName(name), text(text), textColor(color) {}
+
+QString TextSegment::name() const { return segmentName; }
+
+PromptValue TextSegment::render(const PromptContext & /*context*/) const {
+  return {text, {}};
+}
+
+QString TextSegment::color() const { return textColor; }
+
+QString DirectorySegment::name() const { return "cwd"; }
+
+PromptValue DirectorySegment::render(const PromptContext &context) const {
+  QString path = context.cwd;
+
+  // replace home DIR with '~'
+  if (!context.home.isEmpty() &&
+      (path == context.home || path.startsWith(context.home + "/"))) {
+    path.replace(0, context.home.length(), "~");
+  }
+
+  return {path, {}};
+}
+
+// Locates the git directory for path (handles 'gitdir:' files of worktrees)
+static QString findGitDirectory(const QString &path) {
+  QDir dir(path);
+
+  while (true) {
+    QFileInfo candidate(dir.filePath(".git"));
+
+    if (candidate.isDir()) {
+      return candidate.filePath();
+    }
+
+    if (candidate.isFile()) {
+      QFile link(candidate.filePath());
+      if (link.open(QIODevice::ReadOnly)) {
+        QString line = QString::fromUtf8(link.readLine()).trimmed();
+        if (line.startsWith("gitdir:")) {
+          return dir.absoluteFilePath(line.mid(7).trimmed());
+        }
+      }
+    }
+
+    if (!dir.cdUp()) {
+      return QString();
+    }
+  }
+}
+
+// Runs git and reports whether it printed anything, without reading it all
+static bool gitPrintsOutput(const QString &workTree, const QStringList &args) {
+  std::string git = ProcessSpawn::resolveExecutable("git");
+  if (git.empty()) {
+    return false;
+  }
+
+  std::vector<std::string> argv = {"git", "-C",
+                                   QFile::encodeName(workTree).toStdString()};
+  for (const QString &arg : args) {
+    argv.push_back(arg.toStdString());
+  }
+
+  int output[2];
+  if (::pipe2(output, O_CLOEXEC) != 0) {
+    return false;
+  }
+
+  int devNull = ::open("/dev/null", O_WRONLY | O_CLOEXEC);
+  int error = 0;
+  pid_t pid = ProcessSpawn::spawn(git, argv, output[1],
+                                  devNull >= 0 ? devNull : output[1], &error);
+  ::close(output[1]);
+  if (devNull >= 0) {
+    ::close(devNull);
+  }
+
+  // one byte answers the question, closing the pipe ends git early
+  char byte;
+  bool printed = pid > 0 && ::read(output[0], &byte, 1) == 1;
+  ::close(output[0]);
+
+  if (pid > 0) {
+    ::waitpid(pid, nullptr, 0);
+  }
+
+  return printed;
+}
+
+QString GitSegment::name() const { return "git"; }
+
+PromptValue GitSegment::render(const PromptContext &context) const {
+  QString gitDir = findGitDirectory(context.cwd);
+  if (gitDir.isEmpty()) {
+    return {};
+  }
+
+  QFile head(gitDir + "/HEAD");
+  if (!head.open(QIODevice::ReadOnly)) {
+    return {};
+  }
+
+  // branch name, or the short hash of a detached HEAD
+  QString ref = QString::fromUtf8(head.readLine()).trimmed();
+  QString branch = ref.startsWith("ref: ") ? ref.mid(5) : ref.left(7);
+  if (branch.startsWith("refs/heads/")) {
+    branch = branch.mid(11);
+  }
+
+  bool dirty = gitPrintsOutput(
+      context.cwd, {"--no-optional-locks", "status", "--porcelain",
+                    "--untracked-files=no", "--ignore-submodules"});
+
+  PromptValue value;
+  value.text = QString(" (%1%2)").arg(branch, dirty ? QString("*") : QString());
+  value.watchPaths = {gitDir + "/HEAD", gitDir + "/index"};
+  return value;
+}
+
+bool GitSegment::isAsync() const { return true; }
+
+// one stat per parent directory, no git process on the GUI thread
+QString GitSegment::placeholder(const PromptContext &context) const {
+  QDir dir(context.cwd);
+  do {
+    if (QFileInfo::exists(dir.filePath(".git"))) {
+      return " (…)";
+    }
+  } while (dir.cdUp());
+  return QString();
+}
+
+QString GitSegment::color() const { return "#C678DD"; }
+
+QString StatusSegment::name() const { return "status"; }
+
+PromptValue StatusSegment::render(const PromptContext &context) const {
+  if (context.exitCode == 0) {
+    return {};
+  }
+  return {QString(" [%1]").arg(context.exitCode), {}};
+}
+
+QString StatusSegment::cacheKey(const PromptContext &context) const {
+  return QString::number(context.exitCode);
+}
+
+QString StatusSegment::color() const { return "#FF5555"; }
+
+QString DurationSegment::name() const { return "duration"; }
+
+PromptValue DurationSegment::render(const PromptContext &context) const {
+  if (context.durationMs < 1000) {
+    return {};
+  }
+
+  qint64 seconds = context.durationMs / 1000;
+  if (seconds < 60) {
+    return {QString(" %1s").arg(context.durationMs / 1000.0, 0, 'f', 1), {}};
+  }
+
+  return {QString(" %1m%2s")
+              .arg(seconds / 60)
+              .arg(seconds % 60, 2, 10, QChar('0')),
+          {}};
+}
+
+QString DurationSegment::cacheKey(const PromptContext &context) const {
+  return QString::number(context.durationMs);
+}
+
+QString DurationSegment::color() const { return "#E5C07B"; }
@@ -1,16 +1,120 @@
+#include "InputLine.h"
+#include "OutputBlockIndex.h"
+#include "OutputClassifier.h"
+#include "OutputHighlighter.h"
 #include "ProcessManager.h"
+#include "PromptEngine.h"
 #include "QShellUI.h"
+#include "ScriptParser.h"
+#include "ScrollbackStore.h"
+#include "SessionSnapshot.h"
+#include "Trace.h"
+#include <QAbstractTextDocumentLayout>
 #include <QApplication>
+#include <QClipboard>
 #include <QDebug>
+#include <QDateTime>
+#include <QDesktopServices>
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
 #include <QHostInfo>
+#include <QInputDialog>
 #include <QKeyEvent>
+#include <QLabel>
+#include <QLocale>
+#include <QMessageBox>
+#include <QMouseEvent>
 #include <QProcessEnvironment>
 #include <QScrollBar>
+#include <QTextBlock>
 #include <QTextDocumentFragment>
 #include <QTimer>
+#include <QToolTip>
+#include <QUrl>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+// Lines moved into the cold scrollback at once (one compressed chunk)
+static const int scrollbackChunkLines = 2000;
+
+// Characters of a large paste inserted per event loop pass
+static const int pasteChunkSize = 256 * 1024;
+
+// Pasted command count that asks before running them
+static const int pasteConfirmCommands = 10;
+
+// Milliseconds between periodic session snapshots (QSHELL_SESSION)
+static const int sessionSaveInterval = 60 * 1000;
+
+// Milliseconds between HUD refreshes
+static const int hudInterval = 500;
+
+// Output area, its paints are the frames of the trace and the HUD
+class TerminalArea : public QTextEdit {
+public:
+  using QTextEdit::QTextEdit;
+
+protected:
+  void paintEvent(QPaintEvent *event) override {
+    QSHELL_TRACE_SCOPE(scope, "TerminalArea::paint");
+    QTextEdit::paintEvent(event);
+  }
+};
+
+// Text and formatting of up to maxLines blocks, each line ends with '\n'
+static ScrollbackChunk captureBlocks(QTextBlock block, int maxLines) {
+  ScrollbackChunk chunk;
+  for (; chunk.lines < maxLines && block.isValid(); block = block.next()) {
+    int base = chunk.text.size();
+
+    for (QTextBlock::iterator it = block.begin(); !it.atEnd(); ++it) {
+      QTextFragment fragment = it.fragment();
+      QTextCharFormat format = fragment.charFormat();
+
+      ScrollbackRun run;
+      run.start = base + fragment.position() - block.position();
+      run.length = fragment.length();
+      run.bold = format.fontWeight() > QFont::Normal;
+      if (format.hasProperty(QTextFormat::ForegroundBrush)) {
+        run.color = format.foreground().color().rgba();
+      }
+      chunk.runs.append(run);
+    }
+
+    chunk.text += block.text();
+    chunk.text += "\n";
+    chunk.lines++;
+  }
+  return chunk;
+}
+
+// Inserts captured text with its formatting at cursor
+static void insertChunk(QTextCursor &cursor, const ScrollbackChunk &chunk) {
+  // runs cover the line text, newlines in between take the default format
+  int position = 0;
+  for (const ScrollbackRun &run : chunk.runs) {
+    if (run.start > position) {
+      cursor.insertText(chunk.text.mid(position, run.start - position),
+                        QTextCharFormat());
+    }
+
+    QTextCharFormat format;
+    if (run.color != 0) {
+      format.setForeground(QColor::fromRgba(run.color));
+    }
+    if (run.bold) {
+      format.setFontWeight(QFont::Bold);
+    }
+    cursor.insertText(chunk.text.mid(run.start, run.length), format);
+    position = run.start + run.length;
+  }
+
+  if (position < chunk.text.size()) {
+    cursor.insertText(chunk.text.mid(position), QTextCharFormat());
+  }
+}
 
 // Initialize QShell UI.
 QShellUI::QShellUI(QWidget *parent) : QMainWindow(parent) {
@@ -30,10 +134,47 @@ QShellUI::QShellUI(QWidget *parent) : QMainWindow(parent) {
 
   // Connect ProcessManager output error 
   connect(processManager, &ProcessManager::processErrorReady, this, &QShellUI::displayError);
+
+  // Connect ProcessManager highlighted output (grep matches)
+  connect(processManager, &ProcessManager::processHighlightedOutputReady, this,
+          &QShellUI::displayHighlightedOutput);
+
+  // watch repaints its own region instead of appending output
+  connect(processManager, &ProcessManager::pinnedRegionUpdated, this,
+          &QShellUI::updatePinnedRegion);
+  connect(processManager, &ProcessManager::pinnedRegionClosed, this,
+          &QShellUI::closePinnedRegion);
+
+  // parallel reports its progress where the prompt goes
+  connect(processManager, &ProcessManager::progressChanged, this,
+          &QShellUI::showProgress);
+
+  // Prompt returns once the command (builtin, script or process) completed
+  connect(processManager, &ProcessManager::processFinished, this,
+          &QShellUI::commandFinished);
+
+  // relative paths in the rest of the output refer to the new directory
+  connect(processManager, &ProcessManager::directoryChanged, this,
+          [this](QString path) { outputIndex.setDirectory(path); });
+
+  // 'exit' inside a command line or script closes the shell
+  connect(processManager, &ProcessManager::shellExitRequested, this,
+          [](int /*exitCode*/) { QApplication::quit(); });
+
+  updateTerminalSize();
 }
 
 // Cleans up resources.
-QShellUI::~QShellUI() {}
+QShellUI::~QShellUI() {
+  // the document is still alive, the last snapshot is written in place
+  if (session) {
+    QString error;
+    if (!session->saveNow(sessionState(), &error)) {
+      qDebug() << "Session not saved:" << error;
+    }
+    delete session;
+  }
+}
 
 // Load stylesheet
 void QShellUI::loadStyleSheet() {
@@ -69,12 +210,26 @@ void QShellUI::setupUI() {
   mainLayout = new QVBoxLayout(centralWidget);
 
   // Create a QTextEdit for displaying prompts, input, and output
-  terminalArea = new QTextEdit(this);
+  terminalArea = new TerminalArea(this);
+
+  // output only, commands are typed in the input line below
+  terminalArea->setReadOnly(true);
+  terminalArea->setTextInteractionFlags(Qt::TextSelectableByMouse |
+                                        Qt::TextSelectableByKeyboard);
 
-  terminalArea->setCursorWidth(8);
-  terminalArea->setReadOnly(false); // Allow typing
+  // apply class property (QTextEdit area styles)
+  terminalArea->setObjectName("defaultTerminal");
+
+  // output is never undone, the undo stack would keep trimmed lines alive
+  terminalArea->setUndoRedoEnabled(false);
+
+  // prompt and command line, repainted on its own per keystroke
+  inputLine = new InputLine(this);
+  inputLine->setObjectName("inputLine");
 
   mainLayout->addWidget(terminalArea);
+  mainLayout->addWidget(inputLine);
+  mainLayout->setSpacing(0);
   setCentralWidget(centralWidget);
 
   // Retrieve system details for prompt
@@ -83,9 +238,55 @@ void QShellUI::setupUI() {
   setHomeDIR();
   setCWD();
 
+  // Prompt segments, slow ones (git) fill in after the prompt is shown
+  promptEngine = new PromptEngine(this);
+  promptEngine->addSegment(std::make_shared<TextSegment>(
+      "user", QString("%1@%2").arg(username, hostname), "#9BDB0F"));
+  promptEngine->addSegment(std::make_shared<TextSegment>(":", ":", ""));
+  promptEngine->addSegment(std::make_shared<DirectorySegment>());
+  promptEngine->addSegment(std::make_shared<GitSegment>());
+  promptEngine->addSegment(std::make_shared<StatusSegment>());
+  promptEngine->addSegment(std::make_shared<DurationSegment>());
+  promptEngine->addSegment(std::make_shared<TextSegment>("end", "$ ", ""));
+
+  connect(promptEngine, &PromptEngine::promptUpdated, this,
+          &QShellUI::refreshPrompt);
+
+  // Older output is compressed, QSHELL_SCROLLBACK_LINES sets the hot window
+  scrollback = new ScrollbackStore(4, this);
+  bool validLines = false;
+  int lines = qEnvironmentVariableIntValue("QSHELL_SCROLLBACK_LINES",
+                                           &validLines);
+  if (validLines && lines > 0) {
+    hotLines = lines;
+  }
+
+  connect(terminalArea->verticalScrollBar(), &QScrollBar::valueChanged, this,
+          &QShellUI::scrollbackScrolled);
+
+  // QSHELL_SESSION names a snapshot file: restored now, saved periodically
+  // and on exit
+  QString sessionPath = qEnvironmentVariable("QSHELL_SESSION");
+  if (!sessionPath.isEmpty()) {
+    session = new SessionSnapshot(sessionPath);
+    restoreSession();
+
+    QTimer *sessionTimer = new QTimer(this);
+    connect(sessionTimer, &QTimer::timeout, this, &QShellUI::saveSession);
+    sessionTimer->start(sessionSaveInterval);
+  }
+
+  // Paths, URLs and diagnostics, classified lazily around the viewport
+  outputHighlighter = new OutputHighlighter(terminalArea);
+  outputHighlighter->setDirectoryResolver(
+      [this](int position) { return directoryAt(position); });
+  terminalArea->viewport()->installEventFilter(this);
+
   // Making sure QShellUI gets key events, without it QTextEdit handles key
   // presses
   terminalArea->installEventFilter(this);
+  inputLine->installEventFilter(this);
+  inputLine->setFocus();
 
   // Generate and display the initial prompt
   prompt = createPrompt();
@@ -110,80 +311,90 @@ void QShellUI::setHomeDIR() {
 // Sets the current working directory to the home directory.
 void QShellUI::setCWD() {
   QDir::setCurrent(homeDIR);
-  cwd = "~"; // Display as ~ instead of full path
 }
 
 // Creates the shell prompt string in format: `username@hostname:cwd$ `
 QString QShellUI::createPrompt() {
-  QString rawPrompt = QString("%1@%2:%3$").arg(username, hostname, cwd);
-  // Convert to plain text before storing
-  return QTextDocumentFragment::fromHtml(rawPrompt).toPlainText();
+  return PromptEngine::plainText(promptEngine->currentPrompt());
 }
 
-// Displays a new prompt at the bottom of the terminal.
+// Shows a new prompt in the input line below the output.
 void QShellUI::displayShellPrompt() {
-  terminalArea->moveCursor(QTextCursor::End); // Move cursor to the end
+  QSHELL_TRACE_SCOPE(scope, "QShellUI::displayShellPrompt");
+  commandRunning = false;
 
-  // refresh current working directory (this handles the cd command prompt
-  // update)
-  cwd = QDir::currentPath();
+  // build prompt for the current working directory (this handles the cd
+  // command prompt update), slow segments show cached text or placeholders
+  inputLine->setPrompt(promptEngine->prompt(QDir::currentPath()));
+  prompt = createPrompt();
+  inputLine->setText(editor.text(), editor.cursor());
+}
 
-  // replace home DIR with '~'
-  QString homePath = QDir::homePath();
-  if (cwd.startsWith(homePath)) {
-    cwd.replace(0, homePath.length(), "~");
+// Inserts prompt parts with their colors at cursor
+void QShellUI::insertPrompt(QTextCursor &cursor,
+                            const QList<PromptPart> &parts) {
+  for (const PromptPart &part : parts) {
+    QTextCharFormat format;
+    format.setFontWeight(QFont::Bold);
+    if (!part.color.isEmpty()) {
+      format.setForeground(QColor(part.color));
+    }
+    cursor.insertText(part.text, format);
   }
+}
 
-  // create prompt with updated path
-  prompt = createPrompt();
+// Replaces the live prompt once a slow segment (git) is ready
+void QShellUI::refreshPrompt() {
+  // the command line was already submitted, leave the echoed prompt alone
+  if (commandRunning) {
+    return;
+  }
 
-  // Get the last line in the terminal
-  QStringList lines = terminalArea->toPlainText().split("\n");
-  QString lastLine = lines.isEmpty() ? "" : lines.last().trimmed();
+  inputLine->setPrompt(promptEngine->currentPrompt());
+  prompt = createPrompt();
+}
 
-  // prevents double prompts from stacking up when the user presses Enter multiple times
-  if ((lastLine == prompt.trimmed()) && !isFirstPrompt) {
+// The input line has no prompt while a command runs, progress goes there
+void QShellUI::showProgress(QString progress) {
+  if (!commandRunning) {
     return;
   }
 
-  // prevents from adding a new line to the first time a prompt is displayed
-  if (!isFirstPrompt) {
-    // add new line before prompt
-    terminalArea->insertPlainText("\n");
+  QList<PromptPart> parts;
+  if (!progress.isEmpty()) {
+    parts.append({progress, "#888888"});
   }
+  inputLine->setPrompt(parts);
+}
 
-  // apply class property (QTextEdit area styles)
-  terminalArea->setObjectName("defaultTerminal");
-
-  // apply default style
-  QString styledPrompt =
-      QString("<span style='font: monospace; font-weight: bold;'>"
-              "<span style='font-weight: bold; color: "
-              "#9BDB0F;'>%1@%2</span>:"
-              "<span style='color: #11E3DF;'>%3</span>$ "
-              "</span>")
-          .arg(username, hostname, cwd);
+// Keep the column count used by ls in sync with the window
+void QShellUI::resizeEvent(QResizeEvent *event) {
+  QMainWindow::resizeEvent(event);
+  updateTerminalSize();
+}
 
-  terminalArea->insertHtml(styledPrompt);     // Insert the new prompt
-  terminalArea->moveCursor(QTextCursor::End); // Ensure cursor is at the end
+// Columns and rows of the terminal grid, the font is monospace
+void QShellUI::updateTerminalSize() {
+  if (!processManager) {
+    return;
+  }
 
-  // Save position where user input starts (to prevent deleting the prompt)
-  promptPosition = terminalArea->textCursor().position();
+  int margin = 2 * qRound(terminalArea->document()->documentMargin());
+  int cellWidth = terminalArea->fontMetrics().horizontalAdvance(QChar('M'));
+  int width = terminalArea->viewport()->width() - margin;
+  processManager->setTerminalColumns(std::max(1, width / std::max(1, cellWidth)));
 
-  // flag first prompt as done
-  isFirstPrompt = false;
+  int lineHeight = terminalArea->fontMetrics().lineSpacing();
+  int height = terminalArea->viewport()->height() - margin;
+  processManager->setTerminalRows(std::max(2, height / std::max(1, lineHeight)));
 }
 
-// Captures user input and prevents backspacing beyond the prompt.
+// Captures user input, the command line is edited in LineEditor.
 void QShellUI::keyPressEvent(QKeyEvent *event) {
-  // get the cursor
-  QTextCursor cursor = terminalArea->textCursor();
-
-  // Prevent moving cursor before the prompt (Left Arrow)
-  if (event->key() == Qt::Key_Left) {
-    if (cursor.position() <= promptPosition) {
-      return; // Ignore left arrow if it's at or before the prompt
-    }
+  // An interactive builtin (view) takes the keys, Ctrl keys stay ours
+  if (commandRunning && !(event->modifiers() & Qt::ControlModifier) &&
+      processManager->keyPressed(event->key(), event->text())) {
+    return;
   }
 
   // Ignore ESC key
@@ -191,39 +402,46 @@ void QShellUI::keyPressEvent(QKeyEvent *event) {
     return;
   }
 
-  // Prevent moving cursor before the prompt (Up Arrow)
-  if (event->key() == Qt::Key_Up) {
-    return; // Ignore up arrow to keep cursor within the current command line
-  }
-
-  // Prevent Backspace from deleting the prompt
-  if (event->key() == Qt::Key_Backspace) {
-    if (cursor.position() <= promptPosition) {
-      return; // Ignore backspace if at prompt position
-    }
-
-    cursor.deletePreviousChar(); // Allow deleting user input
+  // Search the output, including the compressed scrollback (Ctrl + Shift + F)
+  if (event->key() == Qt::Key_F &&
+      event->modifiers() == (Qt::ControlModifier | Qt::ShiftModifier)) {
+    findInScrollback();
     return;
   }
 
-  // Prevent selecting and deleting the prompt
-  if (cursor.hasSelection()) {
-    if (cursor.selectionStart() < promptPosition ||
-        cursor.selectionEnd() < promptPosition) {
-      return; // Ignore selection if it includes the prompt
+  // Command blocks: previous / next, copy the last output, fold
+  if (event->modifiers() == (Qt::ControlModifier | Qt::ShiftModifier)) {
+    switch (event->key()) {
+    case Qt::Key_Up:
+      showBlock(outputIndex.previous(viewTopOffset()));
+      return;
+    case Qt::Key_Down:
+      showBlock(outputIndex.next(viewTopOffset()));
+      return;
+    case Qt::Key_O:
+      copyLastOutput();
+      return;
+    case Qt::Key_H:
+      toggleFold();
+      return;
+    case Qt::Key_T:
+      toggleHud();
+      return;
     }
   }
 
-  // Block "Cut" (Ctrl + X) if it includes the prompt
-  if (event->matches(QKeySequence::Cut)) {
-    return;
-  }
-
-  // Block "Paste" (Ctrl + V) if it would overwrite the prompt
-  if (event->matches(QKeySequence::Paste)) {
-    if (cursor.position() < promptPosition) {
-      return;
+  // Ctrl + C copies a selection, otherwise interrupts the running command
+  // and drops the rest of a paste
+  if (event->key() == Qt::Key_C && event->modifiers() & Qt::ControlModifier) {
+    if (terminalArea->textCursor().hasSelection()) {
+      terminalArea->copy();
+    } else {
+      pendingPaste.clear();
+      pasteOffset = 0;
+      pasteQueue.clear();
+      processManager->interrupt();
     }
+    return;
   }
 
   // Handle clear screen
@@ -234,193 +452,479 @@ void QShellUI::keyPressEvent(QKeyEvent *event) {
     return;
   }
 
+  // the line is still filling up with a large paste
+  if (!pendingPaste.isEmpty()) {
+    return;
+  }
+
+  // Paste (Ctrl + V, Shift + Insert)
+  if (event->matches(QKeySequence::Paste)) {
+    pasteText(QApplication::clipboard()->text());
+    return;
+  }
+
   // Handle 'Enter' key (User submits command)
-  if (event->key() == Qt::Key_Return) {
-    // Ensure no text is selected
-    cursor.clearSelection();
-
-    // Extract the command from QTextEdit using promptPosition
-    QString terminalText = terminalArea->toHtml(); // Get full HTML
-    terminalText = QTextDocumentFragment::fromHtml(terminalText)
-                       .toPlainText(); // Strip formatting
-
-    // Find the last occurrence of the prompt
-    int lastPromptIndex = terminalText.lastIndexOf(prompt);
-    if (lastPromptIndex == -1) {
-      return;
+  if (event->key() == Qt::Key_Return || event->key() == Qt::Key_Enter) {
+    // typing ahead is fine, submitting waits for the prompt
+    if (!commandRunning) {
+      QString line = editor.text();
+      editor.clear();
+      inputLine->setText(editor.text(), editor.cursor());
+      submitLine(line);
     }
+    return;
+  }
 
-    // Extract the user command correctly
-    QString userCommand =
-        terminalText.mid(lastPromptIndex + prompt.length()).trimmed();
+  if (editLine(event)) {
+    // only the input line repaints, the output document is untouched
+    inputLine->setText(editor.text(), editor.cursor());
+    return;
+  }
 
-    // Store last command
-    lastCommand = userCommand;
+  // Default behavior for other keys
+  QMainWindow::keyPressEvent(event);
+}
 
+// Readline keys, see LineEditor for the commands
+bool QShellUI::editLine(QKeyEvent *event) {
+  Qt::KeyboardModifiers modifiers =
+      event->modifiers() & (Qt::ControlModifier | Qt::AltModifier |
+                            Qt::ShiftModifier | Qt::MetaModifier);
+  bool control = modifiers == Qt::ControlModifier;
+  bool alt = modifiers == Qt::AltModifier;
+
+  switch (event->key()) {
+  case Qt::Key_Left:
+    control ? editor.backwardWord() : editor.backwardChar();
+    return true;
+  case Qt::Key_Right:
+    control ? editor.forwardWord() : editor.forwardChar();
+    return true;
+  case Qt::Key_Home:
+    editor.beginningOfLine();
+    return true;
+  case Qt::Key_End:
+    editor.endOfLine();
+    return true;
+  case Qt::Key_Backspace:
+    alt ? editor.backwardKillWord() : editor.backwardDeleteChar();
+    return true;
+  case Qt::Key_Delete:
+    editor.deleteChar();
+    return true;
+  case Qt::Key_Up:
+  case Qt::Key_Down:
+    return true; // no history yet, keep the line as it is
+  }
 
-    // trigger prompt on empty command
-    if (userCommand.isEmpty()) {
-      displayOutput("", "");
-      return;
+  if (control) {
+    switch (event->key()) {
+    case Qt::Key_A: editor.beginningOfLine(); return true;
+    case Qt::Key_E: editor.endOfLine(); return true;
+    case Qt::Key_B: editor.backwardChar(); return true;
+    case Qt::Key_F: editor.forwardChar(); return true;
+    case Qt::Key_D: editor.deleteChar(); return true;
+    case Qt::Key_H: editor.backwardDeleteChar(); return true;
+    case Qt::Key_K: editor.killLine(); return true;
+    case Qt::Key_U: editor.unixLineDiscard(); return true;
+    case Qt::Key_W: editor.unixWordRubout(); return true;
+    case Qt::Key_Y: editor.yank(); return true;
     }
+    return false;
+  }
 
-    // handle exit command
-    if (userCommand == "exit") {
-      // close shell
-      QApplication::quit();
-      return;
+  if (alt) {
+    switch (event->key()) {
+    case Qt::Key_B: editor.backwardWord(); return true;
+    case Qt::Key_F: editor.forwardWord(); return true;
+    case Qt::Key_D: editor.killWord(); return true;
+    case Qt::Key_Y: editor.yankPop(); return true;
     }
+    return false;
+  }
 
-    // handle DIR changes
-    if (userCommand.startsWith("cd")) {
-      // placeholders
-      QString newDIR;
+  // Allow typing, control characters never reach the line
+  QString text = event->text();
+  if (!text.isEmpty() && text.at(0).isPrint()) {
+    editor.insert(text);
+    return true;
+  }
 
-      // get command arguments
-      QStringList args = userCommand.split(" ", Qt::SkipEmptyParts);
+  return false;
+}
 
-      if (args.size() == 1) {
-        // go home directory
-        newDIR = QDir::homePath();
-      } else {
-        // grab new path
-        newDIR = args[1];
-      }
+// Echo the prompt and the command into the output, then run it
+void QShellUI::submitLine(const QString &line) {
+  QString userCommand = line.trimmed();
 
-      // validate path existance
-      if (QDir(newDIR).exists()) {
-        // change working DIR
-        QDir::setCurrent(newDIR);
+  QTextCursor cursor(terminalArea->document());
+  cursor.movePosition(QTextCursor::End);
+  if (!terminalArea->document()->isEmpty()) {
+    cursor.insertBlock(); // the echoed line starts below the last output
+  }
+  qint64 start = coldChars + cursor.position();
+  insertPrompt(cursor, promptEngine->currentPrompt());
+  cursor.insertText(line, QTextCharFormat());
+  terminalArea->moveCursor(QTextCursor::End);
 
-        // update shells current working directory
-        cwd = QDir::currentPath();
+  // trigger prompt on empty command
+  if (userCommand.isEmpty()) {
+    displayShellPrompt();
+    return;
+  }
 
-        // replace home directory with "~"
-        QString homePath = QDir::homePath();
-        if (cwd.startsWith(homePath)) {
-          cwd.replace(0, homePath.length(), "~");
-        }
+  // handle exit command
+  if (userCommand == "exit") {
+    // close shell
+    QApplication::quit();
+    return;
+  }
 
-        // generate prompt with new path
-        prompt = createPrompt();
-      } else {
-        displayOutput("cd: no such file or directory: " + newDIR);
-      }
+  // output starts on the line below the echo
+  outputIndex.begin(userCommand, start, coldChars + cursor.position() + 1,
+                    QDir::currentPath());
 
-      // display new prompt with new DIR
-      displayShellPrompt();
+  // no prompt while the command runs
+  commandRunning = true;
+  inputLine->setPrompt({});
 
-      // stop further processing of the command (No need to send command to
-      // child Process)
-      return;
+  // Send command with signal to ProcessManager
+  promptEngine->commandStarted();       // duration segment
+  emit commandOutputReady(userCommand); // send command to ProcessManager
+  trimScrollback();
+}
+
+// Single lines go into the editor, several lines become queued commands
+void QShellUI::pasteText(QString text) {
+  text.replace("\r\n", "\n");
+  text.replace('\r', '\n');
+
+  if (!text.contains('\n')) {
+    // large lines are inserted a chunk at a time between events
+    bool idle = pendingPaste.isEmpty();
+    pendingPaste += text;
+    if (idle) {
+      insertPasteChunk();
     }
+    return;
+  }
 
-    // Move the cursor to the end before appending output
-    terminalArea->moveCursor(QTextCursor::End);
+  // like a terminal, a last line without newline is left to finish by hand
+  bool complete = text.endsWith('\n');
+  while (text.endsWith('\n')) {
+    text.chop(1);
+  }
 
-    // Send command with signal to ProcessManager
-    if (!userCommand.isEmpty()) {
-      emit commandOutputReady(userCommand); // send command to ProcessManager
+  // lines of an if/for/while or an open quote stay one command
+  QStringList commands;
+  QString command;
+  for (const QString &line : text.split('\n')) {
+    command = command.isEmpty() ? line : command + "\n" + line;
+    if (ScriptParser::isIncomplete(command)) {
+      continue;
+    }
+    if (!command.trimmed().isEmpty()) {
+      commands << command;
     }
+    command.clear();
+  }
+  if (!command.isEmpty()) {
+    commands << command; // reported as a syntax error when it runs
+  }
+
+  QString unfinished;
+  if (!complete && !commands.isEmpty()) {
+    unfinished = commands.takeLast();
+  }
 
+  if (commands.size() >= pasteConfirmCommands &&
+      QMessageBox::question(
+          this, "Paste",
+          QString("Run %1 pasted commands?").arg(commands.size())) !=
+          QMessageBox::Yes) {
     return;
   }
 
-  // Allow typing by manually inserting text into QTextEdit
-  if (!event->text().isEmpty()) {
-    cursor.insertText(event->text());
-    // promptPosition = cursor.position(); // Update prompt position
+  // the first command continues what was typed already
+  if (!commands.isEmpty()) {
+    editor.insert(commands.first());
+    commands.first() = editor.text();
+    editor.clear();
+  }
+  editor.insert(unfinished);
+  inputLine->setText(editor.text(), editor.cursor());
+
+  pasteQueue += commands;
+  runPastedCommand();
+}
+
+// Inserts the next chunk of a large single line paste
+void QShellUI::insertPasteChunk() {
+  if (pendingPaste.isEmpty()) {
+    return; // cancelled with Ctrl + C
+  }
+
+  int length = std::min<int>(pasteChunkSize, pendingPaste.size() - pasteOffset);
+
+  // a surrogate pair stays in one chunk
+  if (pasteOffset + length < pendingPaste.size() &&
+      pendingPaste.at(pasteOffset + length).isLowSurrogate()) {
+    length--;
+  }
+
+  editor.insert(pendingPaste.mid(pasteOffset, length));
+  inputLine->setText(editor.text(), editor.cursor());
+  pasteOffset += length;
+
+  if (pasteOffset < pendingPaste.size()) {
+    QTimer::singleShot(0, this, &QShellUI::insertPasteChunk);
     return;
   }
 
-  // Default behavior for other keys
-  QMainWindow::keyPressEvent(event);
+  pendingPaste.clear();
+  pasteOffset = 0;
+}
+
+// Runs the next queued command once the prompt is back
+void QShellUI::runPastedCommand() {
+  if (commandRunning || pasteQueue.isEmpty()) {
+    return;
+  }
+
+  submitLine(pasteQueue.takeFirst());
 }
 
 /**
- * This method intercepts key press events targeted at the terminal area (`QTextEdit`). 
- * If a key press event occurs in the terminal, it manually calls `keyPressEvent()` to handle user input. 
+ * This method intercepts key press events targeted at the terminal area (`QTextEdit`)
+ * and the input line.
+ * If a key press event occurs in either, it manually calls `keyPressEvent()` to handle user input.
  *
  * This ensures that the terminal behaves as expected.
  */
 bool QShellUI::eventFilter(QObject *object, QEvent *event) {
-  if (object == terminalArea && event->type() == QEvent::KeyPress) {
+  if ((object == terminalArea || object == inputLine) &&
+      event->type() == QEvent::KeyPress) {
     QKeyEvent *keyEvent = static_cast<QKeyEvent *>(event);
+
     keyPressEvent(keyEvent); // Call keyPressEvent manually
+    return true;             // Mark event as handled
+  }
 
-    // If it's Backspace, we mark it as handled to prevent QTextEdit from
-    // interfering
-    if (keyEvent->key() == Qt::Key_Backspace) {
-      return true; // Stop propagation so QTextEdit does not process it
+  // Ctrl + click opens highlighted links, paths and file:line locations
+  if (object == terminalArea->viewport() &&
+      event->type() == QEvent::MouseButtonRelease) {
+    QMouseEvent *mouseEvent = static_cast<QMouseEvent *>(event);
+    if (mouseEvent->button() == Qt::LeftButton &&
+        mouseEvent->modifiers() & Qt::ControlModifier &&
+        openSpanAt(mouseEvent->position().toPoint())) {
+      return true;
     }
-
-    return true; // Mark event as handled
   }
+
   return QMainWindow::eventFilter(object, event);
 }
 
- // Slot handler
+// Slot handler
 void QShellUI::displayOutput(QString output) {
-  displayOutput(output, lastCommand);
-}
-
-//Display output override to handle user input
-void QShellUI::displayOutput(QString output, QString command) {
-  // If user just pressed Enter (empty command), just show a new prompt
-  if (command.trimmed().isEmpty()) { 
-    // position cursor
-    QTextCursor cursor = terminalArea->textCursor();
-    cursor.movePosition(QTextCursor::End);
-    cursor.insertBlock(); // inserts a new line
+  QSHELL_TRACE_SCOPE(scope, "QShellUI::displayOutput");
+  QSHELL_TRACE_VALUE(scope, output.size());
 
-    terminalArea->setTextCursor(cursor);
-    
-    isFirstPrompt = true; // allow new line without double spacing
-    displayShellPrompt();
-    return;
-}
-    // Ignore empty output
+  // Ignore empty output (prompt follows commandFinished)
   if (output.trimmed().isEmpty()) {
-
-    displayShellPrompt();
     return;
   }
 
-  terminalArea->moveCursor(QTextCursor::End);      // Move cursor to the end
-  QTextCursor cursor = terminalArea->textCursor(); // Insert output as new block
-  cursor.insertBlock();                            // New line before output
+  QTextCursor cursor = outputCursor(); // Insert output as new block
+  cursor.insertBlock();                // New line before output
 
   // Apply formatting using QTextCharFormat
   QTextCharFormat format;
   format.setForeground(QColor("#11E3DF")); // Cyan color for output
   cursor.setCharFormat(format);
  
-  // Handle 'ls' command formatting
-  if (command.trimmed().startsWith("ls")) { 
-    // format and clorize directories
-    QString styledLSOutput = styleOutput(output);
-    cursor.insertHtml(styledLSOutput);
-  } else {
-    // Insert output
-    cursor.insertText(output.trimmed());
-  }
+  // Insert output, OutputHighlighter marks it up once it is in view
+  cursor.insertText(output.trimmed());
 
   terminalArea->moveCursor(QTextCursor::End); // Move cursor to end
+  indexOutput(output);
+  trimScrollback();
+}
+
+// Show the prompt after the command completed
+void QShellUI::commandFinished(int exitCode) {
+  // exit code and duration segments
+  promptEngine->commandFinished(exitCode);
+  outputIndex.finish(exitCode);
+
+  // Delay new prompt after last output, queued pasted commands don't wait
+  std::int64_t finished = QSHELL_TRACE_NOW();
+  QTimer::singleShot(pasteQueue.isEmpty() ? 15 : 0, this, [this, finished]() {
+    QSHELL_TRACE_SINCE("QShellUI::promptDelay", finished);
+    displayShellPrompt();
+    runPastedCommand();
+  });
+}
+
+// Display output with highlighted ranges
+void QShellUI::displayHighlightedOutput(QString output,
+                                        QList<OutputSpan> highlights) {
+  QSHELL_TRACE_SCOPE(scope, "QShellUI::displayHighlightedOutput");
+  QSHELL_TRACE_VALUE(scope, output.size());
+
+  // blocks already separate output chunks
+  while (output.endsWith('\n')) {
+    output.chop(1);
+  }
+
+  if (output.isEmpty()) {
+    return;
+  }
+
+  QTextCursor cursor = outputCursor();
+  cursor.insertBlock();
+
+  QTextCharFormat plainFormat;
+  plainFormat.setForeground(QColor("#11E3DF")); // Cyan like regular output
+
+  QTextCharFormat matchFormat;
+  matchFormat.setForeground(QColor("#FF5555")); // Red matches
+  matchFormat.setFontWeight(QFont::Bold);
+
+  QTextCharFormat labelFormat;
+  labelFormat.setForeground(QColor("#C678DD")); // Purple file:line labels
+
+  QTextCharFormat directoryFormat;
+  directoryFormat.setForeground(QColor("steelblue")); // ls directories
+
+  // insert plain and highlighted runs in order, no reformatting afterwards
+  int position = 0;
+  for (const OutputSpan &span : highlights) {
+    if (span.start >= output.size()) {
+      break;
+    }
+
+    if (span.start > position) {
+      cursor.insertText(output.mid(position, span.start - position),
+                        plainFormat);
+    }
+
+    const QTextCharFormat &spanFormat =
+        span.role == OutputSpan::Match   ? matchFormat
+        : span.role == OutputSpan::Label ? labelFormat
+                                         : directoryFormat;
+    cursor.insertText(output.mid(span.start, span.length), spanFormat);
+    position = span.start + span.length;
+  }
+
+  if (position < output.size()) {
+    cursor.insertText(output.mid(position), plainFormat);
+  }
+
+  terminalArea->moveCursor(QTextCursor::End);
+  indexOutput(output);
+  trimScrollback();
+}
+
+// Rewrite only the changed lines, the rest of the document isn't touched
+void QShellUI::updatePinnedRegion(int lineCount, QList<WatchLine> lines) {
+  QTextDocument *document = terminalArea->document();
+  QScrollBar *scrollBar = terminalArea->verticalScrollBar();
+  bool atBottom = scrollBar->value() == scrollBar->maximum();
+
+  QTextCharFormat plainFormat;
+  plainFormat.setForeground(QColor("#11E3DF")); // Cyan like regular output
+
+  QTextCharFormat changedFormat;
+  changedFormat.setForeground(QColor("black")); // Reverse video like watch -d
+  changedFormat.setBackground(QColor("#11E3DF"));
+
+  // one layout pass for the whole update
+  QTextCursor cursor(document);
+  cursor.beginEditBlock();
+
+  // the region ends the document, other output goes above it
+  while (regionLines < lineCount) {
+    cursor.movePosition(QTextCursor::End);
+    cursor.insertBlock();
+    if (regionLines++ == 0) {
+      // rewriting the first line must not push the anchor past it
+      regionStart = QTextCursor(document->lastBlock());
+      regionStart.setKeepPositionOnInsert(true);
+    }
+  }
+
+  int first = regionStart.block().blockNumber();
+  if (regionLines > lineCount) {
+    // drop the trailing lines with the newline in front of them
+    cursor.setPosition(document->findBlockByNumber(first + lineCount).position() - 1);
+    cursor.movePosition(QTextCursor::End, QTextCursor::KeepAnchor);
+    cursor.removeSelectedText();
+    regionLines = lineCount;
+    if (regionLines == 0) {
+      regionStart = QTextCursor();
+    }
+  }
+
+  for (const WatchLine &line : lines) {
+    QTextBlock block = document->findBlockByNumber(first + line.row);
+    cursor.setPosition(block.position());
+    cursor.setPosition(block.position() + block.length() - 1,
+                       QTextCursor::KeepAnchor);
+    cursor.removeSelectedText();
+
+    int position = 0;
+    for (const OutputSpan &span : line.highlights) {
+      cursor.insertText(line.text.mid(position, span.start - position),
+                        plainFormat);
+      cursor.insertText(line.text.mid(span.start, span.length), changedFormat);
+      position = span.start + span.length;
+    }
+    cursor.insertText(line.text.mid(position), plainFormat);
+  }
+
+  cursor.endEditBlock();
+  outputIndex.extend(coldChars + document->characterCount() - 1, 0);
+
+  if (atBottom) {
+    scrollBar->setValue(scrollBar->maximum());
+  }
+}
+
+void QShellUI::closePinnedRegion() {
+  regionLines = 0;
+  regionStart = QTextCursor();
+}
 
-  // Delay new prompt after last output
-  QTimer::singleShot(15, this, &QShellUI::displayShellPrompt);
+QTextCursor QShellUI::outputCursor() {
+  QTextCursor cursor(terminalArea->document());
+  if (regionLines > 0) {
+    cursor.setPosition(regionStart.position() - 1);
+  } else {
+    cursor.movePosition(QTextCursor::End);
+  }
+  return cursor;
 }
 
 // clear screen implementation
 void QShellUI::clearScreen() {
+  scrollback->clear();
+  outputIndex.clear();
+  coldChars = 0;
+
+  // a running watch keeps its region, only the lines above it go, output
+  // still needs the empty line in front of it
+  if (regionLines > 0) {
+    QTextCursor cursor(terminalArea->document());
+    cursor.setPosition(regionStart.position() - 1, QTextCursor::KeepAnchor);
+    cursor.removeSelectedText();
+    return;
+  }
+
   terminalArea->clear(); // Clears everything
 
   // Reset cursor position to absolute start
   terminalArea->moveCursor(QTextCursor::Start);
 
-  // Reset first prompt flag to ensure it doesn't add a new line
-  isFirstPrompt = true;
-
   // Reset scrollbar position to the top
   QScrollBar *scrollBar = terminalArea->verticalScrollBar();
   if (scrollBar) {
@@ -430,56 +934,483 @@ void QShellUI::clearScreen() {
   // Force a full UI refresh to reflect changes
   terminalArea->update();
 
-  // Add new prompt at the top
-  displayShellPrompt();
+  // Add new prompt at the top, a running command keeps it hidden
+  if (!commandRunning) {
+    displayShellPrompt();
+  }
 }
 
-// Style output for ls commmand
-QString QShellUI::styleOutput(QString output) {
-  // get each output entry
-  QStringList entries = output.split("\n", Qt::SkipEmptyParts);
-  QStringList styledOutput;
-
-  // apply style to each entry
-  for (const QString entry : entries) {
-    // place holder
-    QString styledEntry;
+// display error implementation
+void QShellUI::displayError(QString error) {
+    QSHELL_TRACE_SCOPE(scope, "QShellUI::displayError");
+    QSHELL_TRACE_VALUE(scope, error.size());
 
-    // file type
-    QFileInfo fileType(entry.trimmed());
+    QTextCursor cursor = outputCursor();
 
-    // apply style
-    if (fileType.isDir()) {
-      styledEntry = "<span style='color:steelblue'>" + entry + "</span>";
+    // Only insert block if the last line isn't already empty
+    if (!cursor.block().text().isEmpty()) {
+        cursor.insertBlock();  // Only insert block when needed
     }
 
-    else {
+    QTextCharFormat errorFormat;
+    errorFormat.setForeground(QColor("#FF5555")); // Light red
+    cursor.setCharFormat(errorFormat);
+    cursor.insertText(error.trimmed());
+    indexOutput(error);
+    trimScrollback();
+}
+
+// Move the oldest lines into the compressed scrollback
+void QShellUI::trimScrollback() {
+  QTextDocument *document = terminalArea->document();
+  if (document->blockCount() <= hotLines + scrollbackChunkLines) {
+    return;
+  }
+
+  // don't pull lines away while the user reads them
+  QScrollBar *scrollBar = terminalArea->verticalScrollBar();
+  if (scrollBar->value() < scrollBar->maximum()) {
+    return;
+  }
+
+  // collect text and formatting of the oldest lines
+  ScrollbackChunk chunk =
+      captureBlocks(document->begin(), scrollbackChunkLines);
+
+  int removed = chunk.text.size();
+  QTextCursor cursor(document);
+  cursor.setPosition(0);
+  cursor.setPosition(removed, QTextCursor::KeepAnchor);
+  cursor.removeSelectedText();
+  coldChars += removed;
+
+  scrollback->append(chunk);
+  terminalArea->moveCursor(QTextCursor::End);
+
+  // output restored by a search or scrolling goes back a chunk at a time
+  if (document->blockCount() > hotLines + scrollbackChunkLines) {
+    queueTrim();
+  }
+}
+
+void QShellUI::queueTrim() {
+  if (trimQueued) {
+    return;
+  }
+
+  trimQueued = true;
+  QTimer::singleShot(0, this, [this]() {
+    trimQueued = false;
+    trimScrollback();
+  });
+}
+
+// Insert the newest cold chunk back above the document
+int QShellUI::restoreScrollback() {
+  if (scrollback->chunkCount() == 0) {
+    return 0;
+  }
+
+  ScrollbackChunk chunk = scrollback->takeLast();
+  QTextCursor cursor(terminalArea->document());
+  cursor.setPosition(0);
+  insertChunk(cursor, chunk);
+
+  coldChars -= chunk.text.size();
+  return chunk.text.size();
+}
+
+// Restore older output when the view is scrolled to the top
+void QShellUI::scrollbackScrolled(int value) {
+  QScrollBar *scrollBar = terminalArea->verticalScrollBar();
+
+  // back at the bottom, what search or scrolling restored can go again
+  if (value == scrollBar->maximum() && value != scrollBar->minimum()) {
+    queueTrim();
+    return;
+  }
+
+  if (value != scrollBar->minimum() || scrollback->chunkCount() == 0) {
+    return;
+  }
+
+  int lines = scrollback->chunk(scrollback->chunkCount() - 1).lines;
+  restoreScrollback();
+
+  // keep the line that was at the top where it was
+  QTextDocument *document = terminalArea->document();
+  QTextBlock previousTop = document->findBlockByNumber(lines);
+  int offset = qRound(
+      document->documentLayout()->blockBoundingRect(previousTop).top());
+  scrollBar->setValue(offset);
+}
+
+// Find text backwards, decompressing cold chunks only when needed
+void QShellUI::findInScrollback() {
+  bool accepted = false;
+  QString text = QInputDialog::getText(this, "Find", "Search output:",
+                                       QLineEdit::Normal, lastSearch,
+                                       &accepted);
+  if (!accepted || text.isEmpty()) {
+    return;
+  }
+  lastSearch = text;
+
+  // the uncompressed document first, backwards from the cursor
+  if (terminalArea->find(text, QTextDocument::FindBackward)) {
+    return;
+  }
+
+  int index = scrollback->find(text, Qt::CaseInsensitive);
+  if (index < 0) {
+    QApplication::beep();
+    return;
+  }
+
+  // chunks come back newest first, the matching one ends up on top; they
+  // are compressed again once the view is back at the bottom
+  int inserted = 0;
+  while (scrollback->chunkCount() > index) {
+    inserted = restoreScrollback();
+  }
+
+  QTextCursor cursor(terminalArea->document());
+  cursor.setPosition(inserted);
+  terminalArea->setTextCursor(cursor);
+  terminalArea->find(text, QTextDocument::FindBackward);
+}
 
-      styledEntry = entry;
+// Open the link or file under a viewport position
+bool QShellUI::openSpanAt(const QPoint &position) {
+  OutputSpan span;
+  QString text;
+  if (!outputHighlighter->spanAt(position, &span, &text)) {
+    return false;
+  }
+
+  if (span.role == OutputSpan::Url) {
+    return QDesktopServices::openUrl(QUrl(text));
+  }
+
+  if (span.role == OutputSpan::Path || span.role == OutputSpan::Location) {
+    int offset = terminalArea->cursorForPosition(position).position();
+    return QDesktopServices::openUrl(QUrl::fromLocalFile(
+        OutputClassifier::filePath(text, directoryAt(offset))));
+  }
+
+  return false;
+}
+
+// Directory of the command whose output is at a document position
+QString QShellUI::directoryAt(int position) const {
+  int index = outputIndex.blockAt(coldChars + position);
+  if (index < 0 || outputIndex.block(index).directory.isEmpty()) {
+    return QDir::currentPath();
+  }
+  return outputIndex.block(index).directory;
+}
+
+// Record output of the running command in its block
+void QShellUI::indexOutput(const QString &output) {
+  outputIndex.extend(
+      coldChars + terminalArea->document()->characterCount() - 1,
+      OutputBlockIndex::utf8Length(output));
+}
+
+// Session offset of the first line in view
+qint64 QShellUI::viewTopOffset() {
+  return coldChars + terminalArea->cursorForPosition(QPoint(0, 0)).position();
+}
+
+// Scroll a command line to the top of the view, with its record as tooltip
+void QShellUI::showBlock(int index) {
+  if (index < 0) {
+    QApplication::beep();
+    return;
+  }
+
+  const OutputBlock &block = outputIndex.block(index);
+
+  // output that went to the compressed scrollback comes back first
+  while (block.start < coldChars && scrollback->chunkCount() > 0) {
+    restoreScrollback();
+  }
+
+  QTextDocument *document = terminalArea->document();
+  QTextBlock textBlock =
+      document->findBlock(int(std::max<qint64>(0, block.start - coldChars)));
+  terminalArea->verticalScrollBar()->setValue(qRound(
+      document->documentLayout()->blockBoundingRect(textBlock).top()));
+
+  QString status = block.exitCode < 0
+                       ? QString("running")
+                       : QString("exit %1, %2 s")
+                             .arg(block.exitCode)
+                             .arg((block.endTime - block.startTime) / 1000.0,
+                                  0, 'f', 1);
+  QString info =
+      QString("%1\n%2, %3, started %4%5")
+          .arg(block.command, status,
+               QLocale().formattedDataSize(block.bytes),
+               QDateTime::fromMSecsSinceEpoch(block.startTime)
+                   .toString("HH:mm:ss"),
+               block.folded ? QString(", folded") : QString());
+
+  QTextCursor cursor(document);
+  cursor.setPosition(textBlock.position());
+  QPoint position = terminalArea->cursorRect(cursor).bottomLeft();
+  QToolTip::showText(terminalArea->viewport()->mapToGlobal(position), info,
+                     terminalArea);
+}
+
+// Text between two session offsets, cold parts are decompressed
+QString QShellUI::sessionText(qint64 from, qint64 to) {
+  QString text;
+  qint64 chunkStart = 0;
+
+  for (int index = 0; index < scrollback->chunkCount() && chunkStart < to;
+       index++) {
+    ScrollbackChunk chunk = scrollback->chunk(index);
+    qint64 chunkEnd = chunkStart + chunk.text.size();
+    if (chunkEnd > from) {
+      qint64 begin = std::max(from, chunkStart) - chunkStart;
+      qint64 end = std::min(to, chunkEnd) - chunkStart;
+      text += chunk.text.mid(begin, end - begin);
     }
+    chunkStart = chunkEnd;
+  }
 
-    // build styled output
-    styledOutput.append(styledEntry);
+  if (to > coldChars) {
+    QTextCursor cursor(terminalArea->document());
+    cursor.setPosition(int(std::max(from, coldChars) - coldChars));
+    cursor.setPosition(int(to - coldChars), QTextCursor::KeepAnchor);
+    text += cursor.selection().toPlainText();
   }
 
-  return styledOutput.join("<br>");
+  return text;
 }
 
-// display error implementation
-void QShellUI::displayError(QString error) {
-    terminalArea->moveCursor(QTextCursor::End);
-    QTextCursor cursor = terminalArea->textCursor();
+// Copy the output of the last command
+void QShellUI::copyLastOutput() {
+  if (outputIndex.count() == 0) {
+    QApplication::beep();
+    return;
+  }
 
-    // Only insert block if last character isn't already a newline
-    QString lastChar = terminalArea->toPlainText().right(1);
-    if (lastChar != "\n") {
-        cursor.insertBlock();  // Only insert block when needed
+  const OutputBlock &block = outputIndex.block(outputIndex.count() - 1);
+  if (block.end <= block.outputStart) {
+    QApplication::beep();
+    return;
+  }
+
+  QApplication::clipboard()->setText(
+      sessionText(block.outputStart, block.end));
+}
+
+// Hide or show the output of the block in view, hidden lines skip layout
+void QShellUI::toggleFold() {
+  int index = outputIndex.blockAt(viewTopOffset());
+  if (index < 0) {
+    index = outputIndex.count() - 1;
+  }
+  if (index < 0) {
+    return;
+  }
+
+  if (!foldBlock(index, !outputIndex.block(index).folded)) {
+    QApplication::beep();
+    return;
+  }
+
+  showBlock(index);
+}
+
+// Hide or show the output lines of a block that are in the document
+bool QShellUI::foldBlock(int index, bool folded) {
+  const OutputBlock &block = outputIndex.block(index);
+  qint64 from = std::max(block.outputStart, coldChars) - coldChars;
+  qint64 to = block.end - coldChars;
+  if (to < from) {
+    return false;
+  }
+
+  outputIndex.setFolded(index, folded);
+
+  QTextDocument *document = terminalArea->document();
+  for (QTextBlock textBlock = document->findBlock(int(from));
+       textBlock.isValid() && textBlock.position() <= to;
+       textBlock = textBlock.next()) {
+    textBlock.setVisible(!folded);
+  }
+  document->markContentsDirty(int(from), int(to - from) + 1);
+  return true;
+}
+
+// Everything a restart brings back, cold chunks are shared, not copied
+SessionState QShellUI::sessionState() {
+  SessionState state;
+  state.directory = QDir::currentPath();
+
+  for (int index = 0; index < scrollback->chunkCount(); index++) {
+    SessionChunk chunk;
+    chunk.compressed =
+        scrollback->compressedChunk(index, &chunk.lines, &chunk.rawBytes);
+    state.cold.append(chunk);
+  }
+  state.coldChars = coldChars;
+
+  state.hot = captureBlocks(terminalArea->document()->begin(),
+                            std::numeric_limits<int>::max());
+
+  for (int index = 0; index < outputIndex.count(); index++) {
+    state.blocks.append(outputIndex.block(index));
+  }
+  return state;
+}
+
+// Periodic snapshot, skipped while nothing changed
+void QShellUI::saveSession() {
+  int revision = terminalArea->document()->revision();
+  QString directory = QDir::currentPath();
+  if (revision == savedRevision && directory == savedDirectory) {
+    return;
+  }
+
+  session->save(sessionState());
+  savedRevision = revision;
+  savedDirectory = directory;
+}
+
+// Bring back the snapshot of the last session
+void QShellUI::restoreSession() {
+  SessionState state;
+  QString error;
+  if (!session->restore(&state, &error)) {
+    if (QFile::exists(session->path())) {
+      qDebug() << "Session not restored:" << error;
     }
+    return;
+  }
 
-    QTextCharFormat errorFormat;
-    errorFormat.setForeground(QColor("#FF5555")); // Light red
-    cursor.setCharFormat(errorFormat);
-    cursor.insertText(error.trimmed());
+  if (!state.directory.isEmpty() && QDir(state.directory).exists()) {
+    QDir::setCurrent(state.directory);
+  }
+
+  // compressed chunks go back as they are, only the hot lines are laid out
+  for (const SessionChunk &chunk : state.cold) {
+    scrollback->appendCompressed(chunk.compressed, chunk.lines,
+                                 chunk.rawBytes);
+  }
+  coldChars = state.coldChars;
+
+  QTextCursor cursor(terminalArea->document());
+  cursor.beginEditBlock();
+  insertChunk(cursor, state.hot);
+  cursor.deletePreviousChar(); // the last line had no newline
+  cursor.endEditBlock();
+
+  for (OutputBlock block : state.blocks) {
+    // a command that was still running died with the old window
+    if (block.exitCode < 0) {
+      block.exitCode = 130;
+      block.endTime = block.startTime;
+    }
+
+    bool folded = block.folded;
+    block.folded = false;
+    outputIndex.append(block);
+    if (folded && !foldBlock(outputIndex.count() - 1, true)) {
+      outputIndex.setFolded(outputIndex.count() - 1, true);
+    }
+  }
+
+  terminalArea->moveCursor(QTextCursor::End);
+  savedRevision = terminalArea->document()->revision();
+  savedDirectory = QDir::currentPath();
+}
+
+// Frame time overlay in the top right corner of the output
+void QShellUI::toggleHud() {
+  if (!hud) {
+    hud = new QLabel(terminalArea->viewport());
+    hud->setFont(terminalArea->font());
+    hud->setMargin(6);
+
+    // opaque, refreshing it doesn't repaint the output below
+    QPalette palette = hud->palette();
+    palette.setColor(QPalette::Window, QColor("#202020"));
+    palette.setColor(QPalette::WindowText, QColor("#9BDB0F"));
+    hud->setPalette(palette);
+    hud->setAutoFillBackground(true);
+
+    hudTimer = new QTimer(this);
+    connect(hudTimer, &QTimer::timeout, this, &QShellUI::updateHud);
+  }
+
+  if (hud->isVisible()) {
+    hud->hide();
+    hudTimer->stop();
+    return;
+  }
+
+  // counting starts now, older events would skew the first rates
+  std::vector<Trace::Event> skipped;
+  hudPosition = Trace::read(hudPosition, &skipped);
+  hudTime = Trace::now();
+  hudQueue = 0;
+
+  updateHud();
+  hud->show();
+  hudTimer->start(hudInterval);
+}
+
+void QShellUI::updateHud() {
+#ifdef QSHELL_TRACING
+  std::vector<Trace::Event> events;
+  hudPosition = Trace::read(hudPosition, &events);
+
+  int frames = 0;
+  qint64 frameTime = 0;
+  qint64 worstFrame = 0;
+  qint64 bytes = 0;
+  for (const Trace::Event &event : events) {
+    if (std::strcmp(event.name, "TerminalArea::paint") == 0) {
+      frames++;
+      frameTime += event.duration;
+      worstFrame = std::max(worstFrame, event.duration);
+      hudQueue = 0;
+    } else if (std::strcmp(event.name, "ChildProcess::read") == 0) {
+      bytes += event.value;
+    } else if (std::strcmp(event.name, "pipe backlog") == 0) {
+      hudBacklog = event.value;
+    } else if (std::strcmp(event.name, "QShellUI::displayOutput") == 0 ||
+               std::strcmp(event.name, "QShellUI::displayError") == 0 ||
+               std::strcmp(event.name,
+                           "QShellUI::displayHighlightedOutput") == 0) {
+      hudQueue++; // in the document, not on screen yet
+    }
+  }
 
-    QTimer::singleShot(15, this, &QShellUI::displayShellPrompt);
+  qint64 time = Trace::now();
+  double seconds = std::max(1e-3, double(time - hudTime) / 1e9);
+  hudTime = time;
+
+  QLocale locale;
+  double averageFrame = frames ? double(frameTime) / frames / 1e6 : 0;
+  hud->setText(
+      QString("frame %1 ms, worst %2 ms, %3 fps\n"
+              "queue %4 chunks, pipe %5\n"
+              "read %6/s")
+          .arg(averageFrame, 0, 'f', 1)
+          .arg(double(worstFrame) / 1e6, 0, 'f', 1)
+          .arg(qRound(frames / seconds))
+          .arg(hudQueue)
+          .arg(locale.formattedDataSize(hudBacklog))
+          .arg(locale.formattedDataSize(qint64(bytes / seconds))));
+#else
+  hud->setText("built without QSHELL_TRACING");
+#endif
+
+  hud->adjustSize();
+  hud->move(terminalArea->viewport()->width() - hud->width() - 8, 8);
 }
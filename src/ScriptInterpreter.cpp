@@ -0,0 +1,895 @@
+#include "ScriptInterpreter.h"
+#include "Glob.h"
+#include "ProcessManager.h"
+#include "ProcessSpawn.h"
+#include "ScriptParser.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcessEnvironment>
+
+// Commands owned by the interpreter rather than ProcessManager
+static const QSet<QString> scriptBuiltins = {
+    ":",     "true",   "false", "test",  "[",     "exit",   "return",
+    "break", "continue", "export", "unset", "local", "shift", "source",
+    ".",     "set"};
+
+// Environment updates invalidate the envp block shared by spawned children
+static void setEnvironment(const QByteArray &key, const QByteArray &value) {
+  qputenv(key.constData(), value);
+  ProcessSpawn::environmentChanged();
+}
+
+static void unsetEnvironment(const QByteArray &key) {
+  qunsetenv(key.constData());
+  ProcessSpawn::environmentChanged();
+}
+
+// Puts back the environment a script run as a command started with
+static void restoreEnvironment(const QProcessEnvironment &saved) {
+  QProcessEnvironment current = QProcessEnvironment::systemEnvironment();
+  for (const QString &key : current.keys()) {
+    if (!saved.contains(key)) {
+      unsetEnvironment(key.toLocal8Bit());
+    }
+  }
+  for (const QString &key : saved.keys()) {
+    if (!current.contains(key) || current.value(key) != saved.value(key)) {
+      setEnvironment(key.toLocal8Bit(), saved.value(key).toLocal8Bit());
+    }
+  }
+}
+
+ScriptInterpreter::ScriptInterpreter(ProcessManager *processManager,
+                                     QObject *parent)
+    : QObject(parent), processManager(processManager) {}
+
+ScriptInterpreter::~ScriptInterpreter() {}
+
+int ScriptInterpreter::run(const ScriptNodePtr &script) {
+  flow = Flow::Normal;
+  flowLevels = 0;
+
+  if (!script) {
+    return lastStatus;
+  }
+
+  return execute(*script);
+}
+
+int ScriptInterpreter::runSource(const QString &source, const QString &name,
+                                 const QStringList &args) {
+  QString parseError;
+  ScriptNodePtr script = ScriptParser::parse(source, &parseError);
+
+  if (!script) {
+    reportError(name + ": " + parseError);
+    lastStatus = 2;
+    return lastStatus;
+  }
+
+  scriptName = name;
+  positional = args;
+
+  return run(script);
+}
+
+int ScriptInterpreter::runFile(const QString &path, const QStringList &args) {
+  flow = Flow::Normal;
+  flowLevels = 0;
+
+  return runScriptFile(path, args, false);
+}
+
+QStringList ScriptInterpreter::expandArguments(const ScriptNode &command) {
+  QStringList argv;
+  for (const Word &word : command.words) {
+    argv += expandWord(word);
+  }
+
+  return argv;
+}
+
+bool ScriptInterpreter::isInternalCommand(const QString &name) const {
+  return scriptBuiltins.contains(name) || functions.contains(name) ||
+         name.endsWith(".qsh");
+}
+
+bool ScriptInterpreter::exitRequested() const { return flow == Flow::Exit; }
+
+int ScriptInterpreter::exitStatus() const { return lastStatus; }
+
+QString ScriptInterpreter::variable(const QString &name) const {
+  if (name == "?") {
+    return QString::number(lastStatus);
+  }
+
+  if (name == "#") {
+    return QString::number(positional.size());
+  }
+
+  if (name == "$") {
+    return QString::number(QCoreApplication::applicationPid());
+  }
+
+  if (name == "0") {
+    return scriptName;
+  }
+
+  if (name == "@" || name == "*") {
+    return positional.join(' ');
+  }
+
+  if (name.size() == 1 && name[0].isDigit()) {
+    int index = name.toInt() - 1;
+    return index < positional.size() ? positional[index] : QString();
+  }
+
+  if (variables.contains(name)) {
+    return variables.value(name);
+  }
+
+  return qEnvironmentVariable(name.toLocal8Bit().constData());
+}
+
+void ScriptInterpreter::setVariable(const QString &name, const QString &value) {
+  variables.insert(name, value);
+
+  // keep exported and inherited variables in sync with the environment
+  QByteArray key = name.toLocal8Bit();
+  if (exported.contains(name) || qEnvironmentVariableIsSet(key.constData())) {
+    setEnvironment(key, value.toLocal8Bit());
+  }
+}
+
+void ScriptInterpreter::reportError(const QString &message) {
+  emit errorReady("qshell: " + message);
+}
+
+// ---------------------------------------------------------------------------
+// Execution
+// ---------------------------------------------------------------------------
+
+int ScriptInterpreter::execute(const ScriptNode &node) {
+  int status = 0;
+
+  switch (node.type) {
+  case ScriptNode::Command:
+    status = executeCommand(node);
+
+    // 'set -e' stops on the first failing command outside conditions
+    if (errexit && status != 0 && conditionDepth == 0 &&
+        flow == Flow::Normal) {
+      flow = Flow::Exit;
+    }
+    break;
+
+  case ScriptNode::Sequence:
+    for (const ScriptNodePtr &child : node.children) {
+      status = execute(*child);
+      if (flow != Flow::Normal) {
+        break;
+      }
+    }
+    break;
+
+  case ScriptNode::Group:
+    status = execute(*node.children.front());
+    break;
+
+  case ScriptNode::AndList:
+  case ScriptNode::OrList:
+    status = executeCondition(*node.children[0]);
+    if (flow != Flow::Normal) {
+      break;
+    }
+    if ((node.type == ScriptNode::AndList) == (status == 0)) {
+      status = execute(*node.children[1]);
+    }
+    break;
+
+  case ScriptNode::Not:
+    status = executeCondition(*node.children.front()) == 0 ? 1 : 0;
+    break;
+
+  case ScriptNode::If:
+    status = executeIf(node);
+    break;
+
+  case ScriptNode::For:
+    status = executeFor(node);
+    break;
+
+  case ScriptNode::While:
+  case ScriptNode::Until:
+    status = executeLoop(node);
+    break;
+
+  case ScriptNode::Function:
+    functions.insert(node.name, node.children.front());
+    status = 0;
+    break;
+  }
+
+  // return/exit set their own status
+  if (flow != Flow::Return && flow != Flow::Exit) {
+    lastStatus = status;
+  }
+
+  return lastStatus;
+}
+
+// Conditions never trigger 'set -e'
+int ScriptInterpreter::executeCondition(const ScriptNode &node) {
+  conditionDepth++;
+  int status = execute(node);
+  conditionDepth--;
+
+  return status;
+}
+
+int ScriptInterpreter::executeCommand(const ScriptNode &node) {
+  QStringList argv = expandArguments(node);
+
+  // plain assignments set shell variables
+  if (argv.isEmpty()) {
+    for (const Assignment &assignment : node.assignments) {
+      setVariable(assignment.name, expandWordToString(assignment.value));
+    }
+    return 0;
+  }
+
+  // prefix assignments only live in the environment of this command
+  QList<QPair<QByteArray, std::optional<QByteArray>>> savedEnvironment;
+  for (const Assignment &assignment : node.assignments) {
+    QByteArray key = assignment.name.toLocal8Bit();
+    std::optional<QByteArray> previous;
+    if (qEnvironmentVariableIsSet(key.constData())) {
+      previous = qgetenv(key.constData());
+    }
+    savedEnvironment.append({key, previous});
+    setEnvironment(key, expandWordToString(assignment.value).toLocal8Bit());
+  }
+
+  int status = dispatch(argv);
+
+  for (const auto &[key, previous] : savedEnvironment) {
+    if (previous) {
+      setEnvironment(key, *previous);
+    } else {
+      unsetEnvironment(key);
+    }
+  }
+
+  return status;
+}
+
+// Script builtins, functions, scripts, ProcessManager builtins, programs
+int ScriptInterpreter::dispatch(QStringList argv) {
+  QString name = argv.takeFirst();
+
+  bool handled = false;
+  int status = runScriptBuiltin(name, argv, &handled);
+  if (handled) {
+    return status;
+  }
+
+  if (functions.contains(name)) {
+    return callFunction(name, argv);
+  }
+
+  if (name.endsWith(".qsh")) {
+    return runScriptFile(name, argv, false);
+  }
+
+  status = processManager->runBuiltin(name, argv);
+  if (status >= 0) {
+    return status;
+  }
+
+  return processManager->runExternal(name, argv);
+}
+
+int ScriptInterpreter::executeIf(const ScriptNode &node) {
+  size_t count = node.children.size();
+
+  for (size_t i = 0; i + 1 < count; i += 2) {
+    int condition = executeCondition(*node.children[i]);
+    if (flow != Flow::Normal) {
+      return condition;
+    }
+
+    if (condition == 0) {
+      return execute(*node.children[i + 1]);
+    }
+  }
+
+  // else branch
+  if (count % 2 == 1) {
+    return execute(*node.children.back());
+  }
+
+  return 0;
+}
+
+int ScriptInterpreter::executeFor(const ScriptNode &node) {
+  QStringList items;
+  if (node.implicitArgs) {
+    items = positional;
+  } else {
+    for (const Word &word : node.words) {
+      items += expandWord(word);
+    }
+  }
+
+  int status = 0;
+  loopDepth++;
+
+  for (const QString &item : items) {
+    setVariable(node.name, item);
+
+    status = execute(*node.children.front());
+    if (loopShouldStop()) {
+      break;
+    }
+  }
+
+  loopDepth--;
+  return status;
+}
+
+int ScriptInterpreter::executeLoop(const ScriptNode &node) {
+  bool until = node.type == ScriptNode::Until;
+  int status = 0;
+  loopDepth++;
+
+  while (true) {
+    int condition = executeCondition(*node.children[0]);
+    if (flow != Flow::Normal || (condition == 0) == until) {
+      break;
+    }
+
+    status = execute(*node.children[1]);
+    if (loopShouldStop()) {
+      break;
+    }
+  }
+
+  loopDepth--;
+  return status;
+}
+
+// Consumes one level of break/continue, returns true when the loop must end
+bool ScriptInterpreter::loopShouldStop() {
+  if (flow == Flow::Break) {
+    if (--flowLevels <= 0) {
+      flow = Flow::Normal;
+    }
+    return true;
+  }
+
+  if (flow == Flow::Continue) {
+    if (--flowLevels <= 0) {
+      flow = Flow::Normal;
+      return false;
+    }
+    return true;
+  }
+
+  return flow != Flow::Normal;
+}
+
+int ScriptInterpreter::callFunction(const QString &name,
+                                    const QStringList &args) {
+  ScriptNodePtr body = functions.value(name);
+
+  QStringList savedPositional = positional;
+  positional = args;
+  localFrames.append(QHash<QString, std::optional<QString>>());
+  functionDepth++;
+
+  int status = execute(*body);
+
+  if (flow == Flow::Return) {
+    flow = Flow::Normal;
+  }
+
+  // restore variables shadowed with 'local'
+  const QHash<QString, std::optional<QString>> frame = localFrames.takeLast();
+  for (auto it = frame.cbegin(); it != frame.cend(); ++it) {
+    if (it.value()) {
+      variables.insert(it.key(), *it.value());
+    } else {
+      variables.remove(it.key());
+    }
+  }
+
+  functionDepth--;
+  positional = savedPositional;
+
+  return status;
+}
+
+int ScriptInterpreter::runScriptFile(const QString &path,
+                                     const QStringList &args, bool sourced) {
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    reportError(path + ": No such file or directory");
+    lastStatus = 127;
+    return lastStatus;
+  }
+
+  QString parseError;
+  ScriptNodePtr script =
+      ScriptParser::parse(QString::fromUtf8(file.readAll()), &parseError);
+  file.close();
+
+  if (!script) {
+    reportError(path + ": " + parseError);
+    lastStatus = 2;
+    return lastStatus;
+  }
+
+  QStringList savedPositional = positional;
+  QString savedName = scriptName;
+  if (!sourced || !args.isEmpty()) {
+    positional = args;
+  }
+
+  // a script run as a command gets a state of its own like an sh child:
+  // it sees the environment only, and its cd, variables, exports and
+  // functions go away with it ('source' shares the session's state)
+  QHash<QString, QString> savedVariables;
+  QSet<QString> savedExported;
+  QHash<QString, ScriptNodePtr> savedFunctions;
+  QList<QHash<QString, std::optional<QString>>> savedFrames;
+  QProcessEnvironment savedEnvironment;
+  QString savedDirectory;
+  bool savedErrexit = errexit;
+  if (!sourced) {
+    scriptName = path;
+    savedVariables.swap(variables);
+    savedExported.swap(exported);
+    savedFunctions.swap(functions);
+    savedFrames.swap(localFrames);
+    savedEnvironment = QProcessEnvironment::systemEnvironment();
+    savedDirectory = QDir::currentPath();
+    errexit = false;
+  }
+  sourceDepth++;
+
+  int status = execute(*script);
+
+  // return ends a sourced file, exit only ends a script run as a command
+  if (flow == Flow::Return || (!sourced && flow == Flow::Exit)) {
+    flow = Flow::Normal;
+  }
+
+  sourceDepth--;
+  scriptName = savedName;
+  positional = savedPositional;
+
+  if (!sourced) {
+    variables.swap(savedVariables);
+    exported.swap(savedExported);
+    functions.swap(savedFunctions);
+    localFrames.swap(savedFrames);
+    restoreEnvironment(savedEnvironment);
+    if (QDir::currentPath() != savedDirectory) {
+      processManager->changeDirectory(path, savedDirectory);
+    }
+    errexit = savedErrexit;
+  }
+
+  return status;
+}
+
+// ---------------------------------------------------------------------------
+// Script builtins
+// ---------------------------------------------------------------------------
+
+int ScriptInterpreter::runScriptBuiltin(const QString &name,
+                                        const QStringList &args,
+                                        bool *handled) {
+  *handled = scriptBuiltins.contains(name);
+  if (!*handled) {
+    return 0;
+  }
+
+  if (name == ":" || name == "true") {
+    return 0;
+  }
+
+  if (name == "false") {
+    return 1;
+  }
+
+  if (name == "test" || name == "[") {
+    return runTest(args, name == "[");
+  }
+
+  if (name == "exit" || name == "return" || name == "break" ||
+      name == "continue") {
+    return runFlowBuiltin(name, args);
+  }
+
+  if (name == "export") {
+    return runExport(args);
+  }
+
+  if (name == "unset") {
+    for (const QString &variableName : args) {
+      variables.remove(variableName);
+      exported.remove(variableName);
+      functions.remove(variableName);
+      unsetEnvironment(variableName.toLocal8Bit());
+    }
+    return 0;
+  }
+
+  if (name == "local") {
+    return runLocal(args);
+  }
+
+  if (name == "shift") {
+    int count = args.isEmpty() ? 1 : args.first().toInt();
+    if (count < 0 || count > positional.size()) {
+      return 1;
+    }
+    positional.remove(0, count);
+    return 0;
+  }
+
+  if (name == "source" || name == ".") {
+    if (args.isEmpty()) {
+      reportError(name + ": filename argument required");
+      return 2;
+    }
+    return runScriptFile(args.first(), args.mid(1), true);
+  }
+
+  return runSet(args);
+}
+
+// exit/return/break/continue [n]
+int ScriptInterpreter::runFlowBuiltin(const QString &name,
+                                      const QStringList &args) {
+  int value = -1;
+  if (!args.isEmpty()) {
+    bool valid = false;
+    value = args.first().toInt(&valid);
+    if (!valid) {
+      reportError(name + ": " + args.first() + ": numeric argument required");
+      value = 2;
+    }
+  }
+
+  if (name == "break" || name == "continue") {
+    if (loopDepth == 0) {
+      reportError(name + ": only meaningful in a loop");
+      return 0;
+    }
+
+    flow = name == "break" ? Flow::Break : Flow::Continue;
+    flowLevels = qBound(1, value < 0 ? 1 : value, loopDepth);
+    return 0;
+  }
+
+  if (name == "return" && functionDepth == 0 && sourceDepth == 0) {
+    reportError("return: can only 'return' from a function or sourced script");
+    return 1;
+  }
+
+  lastStatus = value < 0 ? lastStatus : (value & 0xff);
+  flow = name == "exit" ? Flow::Exit : Flow::Return;
+  return lastStatus;
+}
+
+// export NAME[=value] ...
+int ScriptInterpreter::runExport(const QStringList &args) {
+  for (const QString &arg : args) {
+    int equals = arg.indexOf('=');
+    QString name = equals < 0 ? arg : arg.left(equals);
+
+    if (!ScriptParser::isValidName(name)) {
+      reportError("export: '" + arg + "': not a valid identifier");
+      return 1;
+    }
+
+    exported.insert(name);
+    setVariable(name, equals < 0 ? variable(name) : arg.mid(equals + 1));
+  }
+
+  return 0;
+}
+
+// local NAME[=value] ... (restored when the function returns)
+int ScriptInterpreter::runLocal(const QStringList &args) {
+  if (localFrames.isEmpty()) {
+    reportError("local: can only be used in a function");
+    return 1;
+  }
+
+  QHash<QString, std::optional<QString>> &frame = localFrames.last();
+  for (const QString &arg : args) {
+    int equals = arg.indexOf('=');
+    QString name = equals < 0 ? arg : arg.left(equals);
+
+    if (!ScriptParser::isValidName(name)) {
+      reportError("local: '" + arg + "': not a valid identifier");
+      return 1;
+    }
+
+    if (!frame.contains(name)) {
+      frame.insert(name, variables.contains(name)
+                             ? std::optional<QString>(variables.value(name))
+                             : std::nullopt);
+    }
+
+    variables.insert(name, equals < 0 ? QString() : arg.mid(equals + 1));
+  }
+
+  return 0;
+}
+
+// set -e / set +e / set -- args
+int ScriptInterpreter::runSet(const QStringList &args) {
+  for (int i = 0; i < args.size(); i++) {
+    const QString &arg = args[i];
+
+    if (arg == "-e") {
+      errexit = true;
+    } else if (arg == "+e") {
+      errexit = false;
+    } else if (arg == "--") {
+      positional = args.mid(i + 1);
+      break;
+    } else {
+      reportError("set: " + arg + ": invalid option");
+      return 2;
+    }
+  }
+
+  return 0;
+}
+
+// test / [ with the common file, string and integer operators
+int ScriptInterpreter::runTest(QStringList args, bool bracket) {
+  if (bracket) {
+    if (args.isEmpty() || args.last() != "]") {
+      reportError("[: missing ']'");
+      return 2;
+    }
+    args.removeLast();
+  }
+
+  bool negate = false;
+  if (!args.isEmpty() && args.first() == "!" && args.size() > 1) {
+    negate = true;
+    args.removeFirst();
+  }
+
+  bool result = false;
+
+  if (args.isEmpty()) {
+    result = false;
+  } else if (args.size() == 1) {
+    result = !args[0].isEmpty();
+  } else if (args.size() == 2) {
+    const QString &op = args[0];
+    const QString &operand = args[1];
+    QFileInfo info(operand);
+
+    if (op == "-z") {
+      result = operand.isEmpty();
+    } else if (op == "-n") {
+      result = !operand.isEmpty();
+    } else if (op == "-e") {
+      result = info.exists();
+    } else if (op == "-f") {
+      result = info.isFile();
+    } else if (op == "-d") {
+      result = info.isDir();
+    } else if (op == "-s") {
+      result = info.exists() && info.size() > 0;
+    } else if (op == "-r") {
+      result = info.isReadable();
+    } else if (op == "-w") {
+      result = info.isWritable();
+    } else if (op == "-x") {
+      result = info.isExecutable();
+    } else {
+      reportError("test: " + op + ": unary operator expected");
+      return 2;
+    }
+  } else if (args.size() == 3) {
+    const QString &left = args[0];
+    const QString &op = args[1];
+    const QString &right = args[2];
+
+    if (op == "=" || op == "==") {
+      result = left == right;
+    } else if (op == "!=") {
+      result = left != right;
+    } else {
+      bool leftValid = false;
+      bool rightValid = false;
+      qlonglong a = left.toLongLong(&leftValid);
+      qlonglong b = right.toLongLong(&rightValid);
+
+      if (!leftValid || !rightValid) {
+        reportError("test: integer expression expected");
+        return 2;
+      }
+
+      if (op == "-eq") {
+        result = a == b;
+      } else if (op == "-ne") {
+        result = a != b;
+      } else if (op == "-lt") {
+        result = a < b;
+      } else if (op == "-le") {
+        result = a <= b;
+      } else if (op == "-gt") {
+        result = a > b;
+      } else if (op == "-ge") {
+        result = a >= b;
+      } else {
+        reportError("test: " + op + ": binary operator expected");
+        return 2;
+      }
+    }
+  } else {
+    reportError("test: too many arguments");
+    return 2;
+  }
+
+  return (result != negate) ? 0 : 1;
+}
+
+// ---------------------------------------------------------------------------
+// Expansion
+// ---------------------------------------------------------------------------
+
+// Quoted text never acts as a wildcard or brace
+static QString escapeGlob(const QString &text) {
+  QString escaped;
+  for (QChar character : text) {
+    if (character == '\\' || character == '*' || character == '?' ||
+        character == '[' || character == ']' || character == '{' ||
+        character == '}' || character == ',') {
+      escaped += '\\';
+    }
+    escaped += character;
+  }
+  return escaped;
+}
+
+// Expands a word into fields, splitting unquoted variables on whitespace,
+// then expands braces and wildcards of its unquoted literal text
+QStringList ScriptInterpreter::expandWord(const Word &word) const {
+  QStringList fields;
+  QString current;
+  QString pattern;      // current with quoted characters escaped
+  bool hasField = false;
+  bool globbing = false; // unquoted *, ?, [ or { in the field
+
+  auto endField = [&]() {
+    fields += globbing ? expandGlob(pattern) : QStringList{current};
+    current.clear();
+    pattern.clear();
+    globbing = false;
+  };
+
+  for (const WordPart &part : word.parts) {
+    if (part.kind == WordPart::Literal) {
+      current += part.text;
+      hasField = true;
+
+      if (part.quoted) {
+        pattern += escapeGlob(part.text);
+        continue;
+      }
+
+      pattern += part.text;
+      for (QChar character : part.text) {
+        if (character == '*' || character == '?' || character == '[' ||
+            character == '{') {
+          globbing = true;
+          break;
+        }
+      }
+      continue;
+    }
+
+    // "$@" keeps every positional parameter as its own field
+    if (part.text == "@" && part.quoted) {
+      for (int i = 0; i < positional.size(); i++) {
+        if (i > 0) {
+          endField();
+        }
+        current += positional[i];
+        pattern += escapeGlob(positional[i]);
+        hasField = true;
+      }
+      continue;
+    }
+
+    QString value = variable(part.text);
+
+    if (part.quoted) {
+      current += value;
+      pattern += escapeGlob(value);
+      hasField = true;
+      continue;
+    }
+
+    if (value.isEmpty()) {
+      continue;
+    }
+
+    QStringList pieces = value.simplified().split(' ', Qt::SkipEmptyParts);
+    bool leadingSpace = value.front().isSpace();
+    bool trailingSpace = value.back().isSpace();
+
+    if (hasField && (leadingSpace || pieces.isEmpty())) {
+      endField();
+      hasField = false;
+    }
+
+    for (int i = 0; i < pieces.size(); i++) {
+      if (i > 0) {
+        endField();
+      }
+      current += pieces[i];
+      pattern += escapeGlob(pieces[i]);
+      hasField = true;
+    }
+
+    if (trailingSpace && hasField) {
+      endField();
+      hasField = false;
+    }
+  }
+
+  if (hasField) {
+    endField();
+  }
+
+  return fields;
+}
+
+// Brace expansion, then pathname expansion of every resulting word
+QStringList ScriptInterpreter::expandGlob(const QString &pattern) const {
+  QStringList fields;
+
+  for (const std::string &word :
+       Glob::expandBraces(QFile::encodeName(pattern).toStdString())) {
+    // Glob::expand collects and sorts every match before it calls back
+    std::size_t matches = 0;
+    if (Glob::hasWildcards(word)) {
+      matches = Glob::expand(word, [&fields](const std::string &path) {
+        fields.append(QFile::decodeName(QByteArray::fromStdString(path)));
+      });
+    }
+
+    // like sh, a pattern without matches stays as written
+    if (matches == 0) {
+      fields.append(
+          QFile::decodeName(QByteArray::fromStdString(Glob::unescape(word))));
+    }
+  }
+
+  return fields;
+}
+
+// Assignment values are never split
+QString ScriptInterpreter::expandWordToString(const Word &word) const {
+  QString value;
+  for (const WordPart &part : word.parts) {
+    value += part.kind == WordPart::Literal ? part.text : variable(part.text);
+  }
+
+  return value;
+}
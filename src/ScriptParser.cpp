@@ -0,0 +1,751 @@
+#include "ScriptParser.h"
+
+// Words with special meaning at the start of a command
+static const QSet<QString> reservedWords = {
+    "if",   "then",  "elif", "else", "fi", "for",      "in", "do",
+    "done", "while", "until", "{",   "}",  "function", "!"};
+
+ScriptParser::ScriptParser(const QString &source) : source(source) {}
+
+ScriptNodePtr ScriptParser::parse(const QString &source,
+                                  QString *errorMessage) {
+  ScriptParser parser(source);
+
+  ScriptNodePtr root;
+  if (parser.tokenize()) {
+    root = parser.parseList({});
+
+    // anything left over is a stray terminator (fi, done, '}', ')')
+    if (root && parser.peek().type != Token::End) {
+      root = parser.fail(QString("syntax error near unexpected token '%1'")
+                             .arg(parser.peek().text));
+    }
+  }
+
+  if (errorMessage) {
+    *errorMessage = parser.error;
+  }
+
+  return root;
+}
+
+bool ScriptParser::isIncomplete(const QString &source) {
+  ScriptParser parser(source);
+
+  if (parser.tokenize()) {
+    parser.parseList({});
+  }
+
+  return parser.incomplete;
+}
+
+bool ScriptParser::isValidName(const QString &name) {
+  if (name.isEmpty() || !(name[0].isLetter() || name[0] == '_')) {
+    return false;
+  }
+
+  for (const QChar character : name) {
+    if (!(character.isLetterOrNumber() || character == '_')) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// ---------------------------------------------------------------------------
+// Lexer
+// ---------------------------------------------------------------------------
+
+bool ScriptParser::tokenize() {
+  while (position < source.size()) {
+    QChar character = source[position];
+
+    // line continuation
+    if (character == '\\' && position + 1 < source.size() &&
+        source[position + 1] == '\n') {
+      position += 2;
+      line++;
+      continue;
+    }
+
+    // blanks separate words
+    if (character == ' ' || character == '\t' || character == '\r') {
+      position++;
+      continue;
+    }
+
+    // comments run to the end of the line
+    if (character == '#') {
+      while (position < source.size() && source[position] != '\n') {
+        position++;
+      }
+      continue;
+    }
+
+    Token token;
+    token.line = line;
+
+    if (character == '\n') {
+      token.type = Token::Newline;
+      token.text = "newline";
+      tokens.append(token);
+      position++;
+      line++;
+      continue;
+    }
+
+    // two character operators first
+    QString pair = source.mid(position, 2);
+    if (pair == "&&" || pair == "||") {
+      token.type = Token::Operator;
+      token.text = pair;
+      tokens.append(token);
+      position += 2;
+      continue;
+    }
+
+    if (character == ';' || character == '(' || character == ')' ||
+        character == '|' || character == '&' || character == '<' ||
+        character == '>') {
+      // reject what the engine can not run instead of misreading it
+      if (character == '|') {
+        error = QString("line %1: pipes are not supported").arg(line);
+        return false;
+      }
+      if (character == '&') {
+        error = QString("line %1: background jobs are not supported").arg(line);
+        return false;
+      }
+      if (character == '<' || character == '>') {
+        error = QString("line %1: redirections are not supported").arg(line);
+        return false;
+      }
+
+      token.type = Token::Operator;
+      token.text = character;
+      tokens.append(token);
+      position++;
+      continue;
+    }
+
+    token.type = Token::WordToken;
+    if (!readWord(token)) {
+      return false;
+    }
+    tokens.append(token);
+  }
+
+  Token end;
+  end.type = Token::End;
+  end.text = "end of file";
+  end.line = line;
+  tokens.append(end);
+
+  return true;
+}
+
+// Merge consecutive literal characters into a single part
+void ScriptParser::appendLiteral(Word &word, QChar character, bool quoted) {
+  if (!word.parts.isEmpty() && word.parts.last().kind == WordPart::Literal &&
+      word.parts.last().quoted == quoted) {
+    word.parts.last().text.append(character);
+    return;
+  }
+
+  WordPart part;
+  part.kind = WordPart::Literal;
+  part.text = character;
+  part.quoted = quoted;
+  word.parts.append(part);
+}
+
+bool ScriptParser::readWord(Token &token) {
+  bool plain = true;
+
+  while (position < source.size()) {
+    QChar character = source[position];
+
+    // word ends on blanks, newlines and operators
+    if (character == ' ' || character == '\t' || character == '\r' ||
+        character == '\n' || character == ';' || character == '(' ||
+        character == ')' || character == '|' || character == '&' ||
+        character == '<' || character == '>') {
+      break;
+    }
+
+    // single quotes: everything literal
+    if (character == '\'') {
+      plain = false;
+      int close = source.indexOf('\'', position + 1);
+      if (close == -1) {
+        error = QString("line %1: unterminated single quote").arg(line);
+        incomplete = true;
+        return false;
+      }
+
+      QString text = source.mid(position + 1, close - position - 1);
+      line += text.count('\n');
+
+      WordPart part;
+      part.text = text;
+      part.quoted = true;
+      token.word.parts.append(part);
+
+      position = close + 1;
+      continue;
+    }
+
+    // double quotes: literal except for $ and backslash escapes
+    if (character == '"') {
+      plain = false;
+      position++;
+
+      bool closed = false;
+      while (position < source.size()) {
+        QChar inner = source[position];
+
+        if (inner == '"') {
+          closed = true;
+          position++;
+          break;
+        }
+
+        if (inner == '\\' && position + 1 < source.size()) {
+          QChar escaped = source[position + 1];
+          if (escaped == '$' || escaped == '"' || escaped == '\\' ||
+              escaped == '`') {
+            appendLiteral(token.word, escaped, true);
+            position += 2;
+            continue;
+          }
+          if (escaped == '\n') {
+            position += 2;
+            line++;
+            continue;
+          }
+        }
+
+        if (inner == '$') {
+          if (!readVariable(token.word, true)) {
+            return false;
+          }
+          continue;
+        }
+
+        if (inner == '`') {
+          error =
+              QString("line %1: command substitution is not supported").arg(line);
+          return false;
+        }
+
+        if (inner == '\n') {
+          line++;
+        }
+
+        appendLiteral(token.word, inner, true);
+        position++;
+      }
+
+      if (!closed) {
+        error = QString("line %1: unterminated double quote").arg(line);
+        incomplete = true;
+        return false;
+      }
+
+      // "" is still a (empty) word
+      if (token.word.parts.isEmpty()) {
+        WordPart part;
+        part.quoted = true;
+        token.word.parts.append(part);
+      }
+      continue;
+    }
+
+    // backslash quotes the next character
+    if (character == '\\') {
+      plain = false;
+      if (position + 1 < source.size()) {
+        appendLiteral(token.word, source[position + 1], true);
+      }
+      position += 2;
+      continue;
+    }
+
+    if (character == '$') {
+      int partsBefore = token.word.parts.size();
+      if (!readVariable(token.word, false)) {
+        return false;
+      }
+      if (token.word.parts.size() != partsBefore &&
+          token.word.parts.last().kind == WordPart::Variable) {
+        plain = false;
+      }
+      continue;
+    }
+
+    if (character == '`') {
+      error = QString("line %1: command substitution is not supported").arg(line);
+      return false;
+    }
+
+    appendLiteral(token.word, character, false);
+    position++;
+  }
+
+  token.plain = plain;
+  if (plain && !token.word.parts.isEmpty()) {
+    token.text = token.word.parts.first().text;
+  }
+
+  return true;
+}
+
+// Reads $NAME, ${NAME} or a special parameter ($?, $#, $@, $*, $$, $0-$9)
+bool ScriptParser::readVariable(Word &word, bool quoted) {
+  position++; // skip '$'
+
+  if (position >= source.size()) {
+    appendLiteral(word, '$', quoted);
+    return true;
+  }
+
+  QChar character = source[position];
+  WordPart part;
+  part.kind = WordPart::Variable;
+  part.quoted = quoted;
+
+  if (character == '{') {
+    int close = source.indexOf('}', position + 1);
+    if (close == -1) {
+      error = QString("line %1: missing '}' in variable expansion").arg(line);
+      return false;
+    }
+
+    part.text = source.mid(position + 1, close - position - 1);
+    if (!isValidName(part.text) && !(part.text.size() == 1 &&
+                                     QString("?#@*$0123456789").contains(part.text))) {
+      error = QString("line %1: ${%2}: bad substitution").arg(line).arg(part.text);
+      return false;
+    }
+
+    position = close + 1;
+    word.parts.append(part);
+    return true;
+  }
+
+  if (character == '(') {
+    error = QString("line %1: command substitution is not supported").arg(line);
+    return false;
+  }
+
+  if (QString("?#@*$").contains(character) || character.isDigit()) {
+    part.text = character;
+    position++;
+    word.parts.append(part);
+    return true;
+  }
+
+  if (character.isLetter() || character == '_') {
+    int start = position;
+    while (position < source.size() &&
+           (source[position].isLetterOrNumber() || source[position] == '_')) {
+      position++;
+    }
+    part.text = source.mid(start, position - start);
+    word.parts.append(part);
+    return true;
+  }
+
+  // lone '$' is literal
+  appendLiteral(word, '$', quoted);
+  return true;
+}
+
+// ---------------------------------------------------------------------------
+// Parser
+// ---------------------------------------------------------------------------
+
+const ScriptParser::Token &ScriptParser::peek(int offset) const {
+  int index = qMin(current + offset, int(tokens.size()) - 1);
+  return tokens[index];
+}
+
+ScriptParser::Token ScriptParser::take() {
+  Token token = peek();
+  if (current < tokens.size() - 1) {
+    current++;
+  }
+  return token;
+}
+
+bool ScriptParser::peekOperator(const QString &op, int offset) const {
+  const Token &token = peek(offset);
+  return token.type == Token::Operator && token.text == op;
+}
+
+bool ScriptParser::peekReserved(const QString &word) const {
+  const Token &token = peek();
+  return token.type == Token::WordToken && token.plain && token.text == word;
+}
+
+bool ScriptParser::peekAnyReserved(const QSet<QString> &words) const {
+  const Token &token = peek();
+  return token.type == Token::WordToken && token.plain &&
+         words.contains(token.text);
+}
+
+bool ScriptParser::expectReserved(const QString &word) {
+  if (!peekReserved(word)) {
+    fail(QString("syntax error near '%1', expected '%2'")
+             .arg(peek().text, word));
+    return false;
+  }
+
+  take();
+  return true;
+}
+
+void ScriptParser::skipNewlines() {
+  while (peek().type == Token::Newline) {
+    take();
+  }
+}
+
+ScriptNodePtr ScriptParser::fail(const QString &message) {
+  if (error.isEmpty()) {
+    error = QString("line %1: %2").arg(peek().line).arg(message);
+    incomplete = peek().type == Token::End;
+  }
+  return nullptr;
+}
+
+// list := and_or ((';' | newline) and_or)*
+ScriptNodePtr ScriptParser::parseList(const QSet<QString> &terminators) {
+  auto list = std::make_shared<ScriptNode>();
+  list->type = ScriptNode::Sequence;
+  list->line = peek().line;
+
+  while (true) {
+    // skip separators
+    while (peek().type == Token::Newline || peekOperator(";")) {
+      take();
+    }
+
+    if (peek().type == Token::End || peekOperator(")") ||
+        peekAnyReserved(terminators)) {
+      break;
+    }
+
+    ScriptNodePtr node = parseAndOr();
+    if (!node) {
+      return nullptr;
+    }
+    list->children.push_back(node);
+
+    if (peek().type == Token::Newline || peekOperator(";")) {
+      continue;
+    }
+
+    if (peek().type == Token::End || peekOperator(")") ||
+        peekAnyReserved(terminators)) {
+      break;
+    }
+
+    return fail(
+        QString("syntax error near unexpected token '%1'").arg(peek().text));
+  }
+
+  // a single command does not need a sequence around it
+  if (list->children.size() == 1) {
+    return list->children.front();
+  }
+
+  return list;
+}
+
+// and_or := pipeline (('&&' | '||') newline* pipeline)*
+ScriptNodePtr ScriptParser::parseAndOr() {
+  ScriptNodePtr left = parsePipeline();
+
+  while (left && (peekOperator("&&") || peekOperator("||"))) {
+    Token op = take();
+    skipNewlines();
+
+    ScriptNodePtr right = parsePipeline();
+    if (!right) {
+      return nullptr;
+    }
+
+    auto node = std::make_shared<ScriptNode>();
+    node->type = op.text == "&&" ? ScriptNode::AndList : ScriptNode::OrList;
+    node->line = op.line;
+    node->children = {left, right};
+    left = node;
+  }
+
+  return left;
+}
+
+// pipeline := '!'? command
+ScriptNodePtr ScriptParser::parsePipeline() {
+  if (peekReserved("!")) {
+    Token bang = take();
+
+    ScriptNodePtr command = parseCommand();
+    if (!command) {
+      return nullptr;
+    }
+
+    auto node = std::make_shared<ScriptNode>();
+    node->type = ScriptNode::Not;
+    node->line = bang.line;
+    node->children = {command};
+    return node;
+  }
+
+  return parseCommand();
+}
+
+ScriptNodePtr ScriptParser::parseCommand() {
+  const Token &token = peek();
+
+  if (token.type != Token::WordToken) {
+    return fail(
+        QString("syntax error near unexpected token '%1'").arg(token.text));
+  }
+
+  if (peekReserved("if")) {
+    return parseIf();
+  }
+
+  if (peekReserved("for")) {
+    return parseFor();
+  }
+
+  if (peekReserved("while")) {
+    return parseLoop(ScriptNode::While);
+  }
+
+  if (peekReserved("until")) {
+    return parseLoop(ScriptNode::Until);
+  }
+
+  if (peekReserved("{")) {
+    return parseGroup();
+  }
+
+  // function name { ... } or name() { ... }
+  if (peekReserved("function") ||
+      (token.plain && peekOperator("(", 1) && peekOperator(")", 2))) {
+    return parseFunction();
+  }
+
+  if (token.plain && reservedWords.contains(token.text)) {
+    return fail(
+        QString("syntax error near unexpected token '%1'").arg(token.text));
+  }
+
+  return parseSimpleCommand();
+}
+
+ScriptNodePtr ScriptParser::parseSimpleCommand() {
+  auto node = std::make_shared<ScriptNode>();
+  node->type = ScriptNode::Command;
+  node->line = peek().line;
+
+  while (peek().type == Token::WordToken) {
+    Token token = take();
+
+    // NAME=value is an assignment while no command word was seen yet
+    if (node->words.isEmpty() && !token.word.parts.isEmpty()) {
+      const WordPart &first = token.word.parts.first();
+      int equals = first.kind == WordPart::Literal && !first.quoted
+                       ? first.text.indexOf('=')
+                       : -1;
+
+      if (equals > 0 && isValidName(first.text.left(equals))) {
+        Assignment assignment;
+        assignment.name = first.text.left(equals);
+
+        WordPart rest = first;
+        rest.text = first.text.mid(equals + 1);
+        if (!rest.text.isEmpty()) {
+          assignment.value.parts.append(rest);
+        }
+        for (int i = 1; i < token.word.parts.size(); i++) {
+          assignment.value.parts.append(token.word.parts[i]);
+        }
+
+        node->assignments.append(assignment);
+        continue;
+      }
+    }
+
+    node->words.append(token.word);
+  }
+
+  if (peekOperator("(")) {
+    return fail("syntax error near unexpected token '('");
+  }
+
+  return node;
+}
+
+// if list then list (elif list then list)* (else list)? fi
+ScriptNodePtr ScriptParser::parseIf() {
+  auto node = std::make_shared<ScriptNode>();
+  node->type = ScriptNode::If;
+  node->line = peek().line;
+  take(); // if
+
+  while (true) {
+    ScriptNodePtr condition = parseList({"then"});
+    if (!condition || !expectReserved("then")) {
+      return nullptr;
+    }
+
+    ScriptNodePtr body = parseList({"elif", "else", "fi"});
+    if (!body) {
+      return nullptr;
+    }
+
+    node->children.push_back(condition);
+    node->children.push_back(body);
+
+    if (!peekReserved("elif")) {
+      break;
+    }
+    take(); // elif
+  }
+
+  if (peekReserved("else")) {
+    take();
+
+    ScriptNodePtr elseBody = parseList({"fi"});
+    if (!elseBody) {
+      return nullptr;
+    }
+    node->children.push_back(elseBody);
+  }
+
+  if (!expectReserved("fi")) {
+    return nullptr;
+  }
+
+  return node;
+}
+
+// for NAME (in word*)? (';' | newline) do list done
+ScriptNodePtr ScriptParser::parseFor() {
+  auto node = std::make_shared<ScriptNode>();
+  node->type = ScriptNode::For;
+  node->line = peek().line;
+  take(); // for
+
+  Token name = take();
+  if (name.type != Token::WordToken || !name.plain || !isValidName(name.text)) {
+    return fail(QString("'%1': not a valid identifier").arg(name.text));
+  }
+  node->name = name.text;
+
+  skipNewlines();
+
+  if (peekReserved("in")) {
+    take();
+    while (peek().type == Token::WordToken) {
+      node->words.append(take().word);
+    }
+  } else {
+    node->implicitArgs = true;
+  }
+
+  if (peekOperator(";")) {
+    take();
+  }
+  skipNewlines();
+
+  if (!expectReserved("do")) {
+    return nullptr;
+  }
+
+  ScriptNodePtr body = parseList({"done"});
+  if (!body || !expectReserved("done")) {
+    return nullptr;
+  }
+
+  node->children.push_back(body);
+  return node;
+}
+
+// (while | until) list do list done
+ScriptNodePtr ScriptParser::parseLoop(ScriptNode::Type type) {
+  auto node = std::make_shared<ScriptNode>();
+  node->type = type;
+  node->line = peek().line;
+  take(); // while / until
+
+  ScriptNodePtr condition = parseList({"do"});
+  if (!condition || !expectReserved("do")) {
+    return nullptr;
+  }
+
+  ScriptNodePtr body = parseList({"done"});
+  if (!body || !expectReserved("done")) {
+    return nullptr;
+  }
+
+  node->children = {condition, body};
+  return node;
+}
+
+// { list }
+ScriptNodePtr ScriptParser::parseGroup() {
+  auto node = std::make_shared<ScriptNode>();
+  node->type = ScriptNode::Group;
+  node->line = peek().line;
+  take(); // {
+
+  ScriptNodePtr body = parseList({"}"});
+  if (!body || !expectReserved("}")) {
+    return nullptr;
+  }
+
+  node->children.push_back(body);
+  return node;
+}
+
+// function NAME ('(' ')')? command | NAME '(' ')' command
+ScriptNodePtr ScriptParser::parseFunction() {
+  auto node = std::make_shared<ScriptNode>();
+  node->type = ScriptNode::Function;
+  node->line = peek().line;
+
+  if (peekReserved("function")) {
+    take();
+  }
+
+  Token name = take();
+  if (name.type != Token::WordToken || !name.plain || !isValidName(name.text)) {
+    return fail(QString("'%1': not a valid function name").arg(name.text));
+  }
+  node->name = name.text;
+
+  if (peekOperator("(")) {
+    take();
+    if (!peekOperator(")")) {
+      return fail("syntax error, expected ')'");
+    }
+    take();
+  }
+
+  skipNewlines();
+
+  ScriptNodePtr body = parseCommand();
+  if (!body) {
+    return nullptr;
+  }
+
+  node->children.push_back(body);
+  return node;
+}
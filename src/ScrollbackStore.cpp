@@ -0,0 +1,184 @@
+#include "ScrollbackStore.h"
+#include <QDataStream>
+#include <QIODevice>
+
+ScrollbackStore::ScrollbackStore(int cachedChunks, QObject *parent)
+    : QObject(parent), recent(cachedChunks) {
+  // compression trails output, one thread is enough and stays out of the way
+  pool.setMaxThreadCount(1);
+}
+
+ScrollbackStore::~ScrollbackStore() {
+  pool.clear();
+  pool.waitForDone();
+}
+
+void ScrollbackStore::append(const ScrollbackChunk &chunk) {
+  StoredChunk stored;
+  stored.id = nextId++;
+  stored.pending = chunk;
+  stored.lines = chunk.lines;
+  stored.rawBytes = chunk.text.size() * sizeof(QChar);
+  chunks.append(stored);
+  lines += chunk.lines;
+
+  quint64 id = stored.id;
+  pool.start([this, id, chunk]() {
+    QByteArray data = qCompress(serialize(chunk));
+
+    // back to the owner thread, dropped if the store is gone
+    QMetaObject::invokeMethod(
+        this, [this, id, data]() { compressed(id, data); },
+        Qt::QueuedConnection);
+  });
+}
+
+void ScrollbackStore::appendCompressed(const QByteArray &data, int chunkLines,
+                                       qint64 rawBytes) {
+  StoredChunk stored;
+  stored.id = nextId++;
+  stored.compressed = data;
+  stored.lines = chunkLines;
+  stored.rawBytes = rawBytes;
+  chunks.append(stored);
+  lines += chunkLines;
+}
+
+QByteArray ScrollbackStore::compressedChunk(int index, int *chunkLines,
+                                            qint64 *rawBytes) const {
+  const StoredChunk &stored = chunks[index];
+  *chunkLines = stored.lines;
+  *rawBytes = stored.rawBytes;
+
+  // the worker hasn't got to it yet
+  if (stored.compressed.isEmpty()) {
+    return qCompress(serialize(stored.pending));
+  }
+  return stored.compressed;
+}
+
+ScrollbackChunk ScrollbackStore::takeLast() {
+  if (chunks.isEmpty()) {
+    return {};
+  }
+
+  ScrollbackChunk last = chunk(chunks.size() - 1);
+  recent.remove(chunks.last().id);
+  lines -= chunks.last().lines;
+  chunks.removeLast();
+  return last;
+}
+
+ScrollbackChunk ScrollbackStore::chunk(int index) {
+  if (index < 0 || index >= chunks.size()) {
+    return {};
+  }
+
+  const StoredChunk &stored = chunks[index];
+  if (stored.compressed.isEmpty()) {
+    return stored.pending;
+  }
+
+  if (ScrollbackChunk *cached = recent.object(stored.id)) {
+    return *cached;
+  }
+
+  ScrollbackChunk *decompressed =
+      new ScrollbackChunk(deserialize(qUncompress(stored.compressed)));
+  ScrollbackChunk result = *decompressed;
+  recent.insert(stored.id, decompressed);
+  return result;
+}
+
+int ScrollbackStore::find(const QString &text,
+                          Qt::CaseSensitivity caseSensitivity) {
+  for (int index = chunks.size() - 1; index >= 0; index--) {
+    if (chunk(index).text.contains(text, caseSensitivity)) {
+      return index;
+    }
+  }
+  return -1;
+}
+
+void ScrollbackStore::clear() {
+  // compression still running for these is dropped on arrival
+  chunks.clear();
+  recent.clear();
+  lines = 0;
+}
+
+int ScrollbackStore::chunkCount() const { return chunks.size(); }
+
+qint64 ScrollbackStore::lineCount() const { return lines; }
+
+qint64 ScrollbackStore::memoryUsage() const {
+  qint64 bytes = 0;
+  for (const StoredChunk &stored : chunks) {
+    bytes += stored.compressed.isEmpty() ? stored.rawBytes
+                                         : stored.compressed.size();
+  }
+  return bytes;
+}
+
+qint64 ScrollbackStore::rawSize() const {
+  qint64 bytes = 0;
+  for (const StoredChunk &stored : chunks) {
+    bytes += stored.rawBytes;
+  }
+  return bytes;
+}
+
+QByteArray ScrollbackStore::serialize(const ScrollbackChunk &chunk) {
+  QByteArray data;
+  QDataStream stream(&data, QIODevice::WriteOnly);
+
+  stream << chunk.text << qint32(chunk.lines) << qint32(chunk.runs.size());
+  for (const ScrollbackRun &run : chunk.runs) {
+    stream << qint32(run.start) << qint32(run.length) << run.color << run.bold;
+  }
+
+  return data;
+}
+
+ScrollbackChunk ScrollbackStore::deserialize(const QByteArray &data) {
+  ScrollbackChunk chunk;
+  QDataStream stream(data);
+
+  qint32 lineCount = 0;
+  qint32 runCount = 0;
+  stream >> chunk.text >> lineCount >> runCount;
+  chunk.lines = lineCount;
+
+  for (qint32 i = 0; i < runCount && stream.status() == QDataStream::Ok; i++) {
+    qint32 start = 0;
+    qint32 length = 0;
+    ScrollbackRun run;
+    stream >> start >> length >> run.color >> run.bold;
+    run.start = start;
+    run.length = length;
+    chunk.runs.append(run);
+  }
+
+  return chunk;
+}
+
+void ScrollbackStore::compressed(quint64 id, const QByteArray &data) {
+  int index = indexOf(id);
+  if (index < 0) {
+    return; // taken back before compression finished
+  }
+
+  StoredChunk &stored = chunks[index];
+  stored.compressed = data;
+  stored.pending = ScrollbackChunk();
+}
+
+int ScrollbackStore::indexOf(quint64 id) const {
+  // recent chunks sit at the end
+  for (int index = chunks.size() - 1; index >= 0; index--) {
+    if (chunks[index].id == id) {
+      return index;
+    }
+  }
+  return -1;
+}
@@ -0,0 +1,133 @@
+#include "SessionRecorder.h"
+#include <QDateTime>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QThread>
+#include <cerrno>
+#include <cstring>
+
+SessionRecorder::~SessionRecorder() { stop(); }
+
+bool SessionRecorder::start(const QString &path, int width, int height,
+                            QString *error) {
+  stop();
+
+  file = std::fopen(QFile::encodeName(path).constData(), "w");
+  if (!file) {
+    *error = QString::fromLocal8Bit(std::strerror(errno));
+    return false;
+  }
+
+  // asciicast v2 header, one JSON object on the first line
+  QJsonObject environment;
+  environment["SHELL"] = "qshell";
+  environment["TERM"] = "xterm-256color";
+
+  QJsonObject header;
+  header["version"] = 2;
+  header["width"] = width;
+  header["height"] = height;
+  header["timestamp"] = QDateTime::currentSecsSinceEpoch();
+  header["env"] = environment;
+
+  QByteArray line = QJsonDocument(header).toJson(QJsonDocument::Compact);
+  line += '\n';
+  std::fwrite(line.constData(), 1, line.size(), file);
+
+  recordingPath = path;
+  stopping = false;
+  clock.start();
+
+  writer = QThread::create([this]() { writeEvents(); });
+  writer->start();
+  return true;
+}
+
+void SessionRecorder::stop() {
+  if (!writer) {
+    return;
+  }
+
+  {
+    QMutexLocker locker(&mutex);
+    stopping = true;
+    wake.wakeOne();
+  }
+
+  writer->wait();
+  delete writer;
+  writer = nullptr;
+
+  std::fclose(file);
+  file = nullptr;
+  recordingPath.clear();
+}
+
+bool SessionRecorder::isRecording() const { return writer != nullptr; }
+
+QString SessionRecorder::path() const { return recordingPath; }
+
+void SessionRecorder::recordOutput(const QString &text) { queue(text); }
+
+void SessionRecorder::recordError(const QString &text) {
+  queue("\x1b[31m" + text + "\x1b[0m");
+}
+
+void SessionRecorder::recordCommand(const QString &command) {
+  queue("$ " + command + "\n");
+}
+
+void SessionRecorder::queue(const QString &data) {
+  if (!writer || data.isEmpty()) {
+    return;
+  }
+
+  // the timestamp is taken now, formatting waits for the writer
+  Event event;
+  event.time = clock.nsecsElapsed() / 1e9;
+  event.data = data;
+
+  QMutexLocker locker(&mutex);
+  events.append(event);
+  wake.wakeOne();
+}
+
+void SessionRecorder::writeEvents() {
+  QList<Event> batch;
+
+  for (;;) {
+    bool done = false;
+    {
+      QMutexLocker locker(&mutex);
+      while (events.isEmpty() && !stopping) {
+        wake.wait(&mutex);
+      }
+      batch.swap(events);
+      done = stopping;
+    }
+
+    // [time, "o", data], one event per line
+    QByteArray lines;
+    for (Event &event : batch) {
+      event.data.replace("\n", "\r\n");
+
+      QJsonArray entry;
+      entry.append(event.time);
+      entry.append("o");
+      entry.append(event.data);
+      lines += QJsonDocument(entry).toJson(QJsonDocument::Compact);
+      lines += '\n';
+    }
+    batch.clear();
+
+    std::fwrite(lines.constData(), 1, lines.size(), file);
+    std::fflush(file);
+
+    if (done) {
+      return;
+    }
+  }
+}
@@ -0,0 +1,119 @@
+#include "SessionReplay.h"
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <algorithm>
+#include <cmath>
+
+// Time a fast replay emits before letting the display paint
+static constexpr int fastSliceMs = 16;
+
+SessionReplay::SessionReplay(QObject *parent) : QObject(parent) {
+  timer.setSingleShot(true);
+  connect(&timer, &QTimer::timeout, this, &SessionReplay::playDue);
+}
+
+bool SessionReplay::load(const QString &path, QString *error) {
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly)) {
+    *error = file.errorString();
+    return false;
+  }
+
+  QJsonDocument header = QJsonDocument::fromJson(file.readLine());
+  if (!header.isObject() || header.object().value("version").toInt() != 2) {
+    *error = "not an asciicast v2 recording";
+    return false;
+  }
+
+  static const QRegularExpression controlSequence(
+      "\x1b(\\[[0-9;?]*[ -/]*[@-~]|\\][^\x07]*\x07|[()][0-9A-Za-z])");
+  static const QString errorStart = "\x1b[31m";
+  static const QString errorEnd = "\x1b[0m";
+
+  // [time, "o", data] lines, input and marker events are skipped
+  while (!file.atEnd()) {
+    QJsonArray entry = QJsonDocument::fromJson(file.readLine()).array();
+    if (entry.size() < 3 || entry.at(1).toString() != "o") {
+      continue;
+    }
+
+    Event event;
+    event.time = entry.at(0).toDouble();
+    event.data = entry.at(2).toString();
+    event.data.replace("\r\n", "\n");
+
+    if (event.data.startsWith(errorStart) && event.data.endsWith(errorEnd)) {
+      event.error = true;
+      event.data = event.data.mid(errorStart.size(),
+                                  event.data.size() - errorStart.size() -
+                                      errorEnd.size());
+    }
+
+    event.data.remove(controlSequence);
+    events.append(event);
+  }
+
+  return true;
+}
+
+void SessionReplay::start(double replaySpeed) {
+  speed = replaySpeed;
+  next = 0;
+  bytes = 0;
+  clock.start();
+  timer.start(0);
+}
+
+QString SessionReplay::statistics() const {
+  double seconds = std::max<qint64>(elapsedMs, 1) / 1000.0;
+  return QString("replay: %1 events, %2 KiB in %3 ms (%4 MiB/s, %5 events/s)\n")
+      .arg(events.size())
+      .arg(bytes / 1024)
+      .arg(elapsedMs)
+      .arg(bytes / seconds / (1024 * 1024), 0, 'f', 1)
+      .arg(qRound64(events.size() / seconds));
+}
+
+void SessionReplay::playDue() {
+  if (speed <= 0) {
+    // as fast as possible, in slices so the display can paint in between
+    QElapsedTimer slice;
+    slice.start();
+    while (next < events.size() && slice.elapsed() < fastSliceMs) {
+      emitEvent(events[next++]);
+    }
+  } else {
+    double now = clock.nsecsElapsed() / 1e9 * speed;
+    while (next < events.size() && events[next].time <= now) {
+      emitEvent(events[next++]);
+    }
+  }
+
+  if (next >= events.size()) {
+    elapsedMs = clock.elapsed();
+    emit finished();
+    return;
+  }
+
+  if (speed <= 0) {
+    timer.start(0);
+    return;
+  }
+
+  // sleep until the next event is due
+  double wait = (events[next].time / speed) - clock.nsecsElapsed() / 1e9;
+  timer.start(std::max(0, int(std::ceil(wait * 1000))));
+}
+
+void SessionReplay::emitEvent(const Event &event) {
+  bytes += event.data.size();
+
+  if (event.error) {
+    emit errorReady(event.data);
+  } else {
+    emit outputReady(event.data);
+  }
+}
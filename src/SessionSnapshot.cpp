@@ -0,0 +1,300 @@
+#include "SessionSnapshot.h"
+#include "MappedFile.h"
+#include <QFile>
+#include <QSaveFile>
+#include <cstring>
+
+// Section of the file: offset and size in bytes
+struct SnapshotSection {
+  quint64 offset;
+  quint64 size;
+};
+
+struct SnapshotHeader {
+  char magic[4];
+  quint32 version;
+  qint64 coldChars;
+  SnapshotSection directory; // UTF-16
+  SnapshotSection chunks;    // SnapshotChunk records
+  SnapshotSection hotText;   // UTF-16, lines end with '\n'
+  SnapshotSection hotRuns;   // SnapshotRun records
+  SnapshotSection blocks;    // SnapshotBlock records
+  SnapshotSection strings;   // UTF-16 commands and directories of the blocks
+  qint32 hotLines;
+  quint32 reserved;
+};
+
+struct SnapshotChunk {
+  quint64 offset; // zlib data, 8-byte aligned
+  quint64 size;
+  qint64 rawBytes;
+  qint32 lines;
+  quint32 reserved;
+};
+
+struct SnapshotRun {
+  qint32 start;
+  qint32 length;
+  quint32 color;
+  quint32 bold;
+};
+
+struct SnapshotBlock {
+  qint64 start;
+  qint64 outputStart;
+  qint64 end;
+  qint64 startTime;
+  qint64 endTime;
+  qint64 bytes;
+  quint64 command; // Offset into the strings section, in UTF-16 units
+  quint32 commandLength;
+  qint32 exitCode;
+  quint32 folded;
+  quint32 directoryLength; // Follows the command, 0 in older snapshots
+};
+
+static constexpr char snapshotMagic[4] = {'Q', 'S', 'S', '1'};
+static constexpr quint32 snapshotVersion = 1;
+
+static quint64 aligned(quint64 offset) { return (offset + 7) & ~quint64(7); }
+
+// Writes sections in order, each starting 8-byte aligned
+class SectionWriter {
+public:
+  explicit SectionWriter(QSaveFile &file) : file(file) {}
+
+  SnapshotSection write(const void *data, quint64 size) {
+    pad();
+    SnapshotSection section{offset, size};
+    file.write(static_cast<const char *>(data), qint64(size));
+    offset += size;
+    return section;
+  }
+
+  void pad() {
+    static const char zeros[8] = {};
+    quint64 padding = aligned(offset) - offset;
+    file.write(zeros, qint64(padding));
+    offset += padding;
+  }
+
+  quint64 position() const { return offset; }
+
+private:
+  QSaveFile &file;
+  quint64 offset = 0;
+};
+
+SessionSnapshot::SessionSnapshot(const QString &path) : snapshotPath(path) {
+  // a newer save replaces one that hasn't started
+  pool.setMaxThreadCount(1);
+}
+
+SessionSnapshot::~SessionSnapshot() { pool.waitForDone(); }
+
+QString SessionSnapshot::path() const { return snapshotPath; }
+
+void SessionSnapshot::save(const SessionState &state) {
+  pool.clear();
+  QString path = snapshotPath;
+  pool.start([path, state]() {
+    QString error;
+    write(path, state, &error);
+  });
+}
+
+bool SessionSnapshot::saveNow(const SessionState &state, QString *error) {
+  pool.clear();
+  pool.waitForDone();
+  return write(snapshotPath, state, error);
+}
+
+bool SessionSnapshot::write(const QString &path, const SessionState &state,
+                            QString *error) {
+  QSaveFile file(path);
+  if (!file.open(QIODevice::WriteOnly)) {
+    *error = file.errorString();
+    return false;
+  }
+
+  // header first, filled in once the sections are placed
+  SnapshotHeader header = {};
+  std::memcpy(header.magic, snapshotMagic, sizeof(snapshotMagic));
+  header.version = snapshotVersion;
+  header.coldChars = state.coldChars;
+  header.hotLines = state.hot.lines;
+
+  SectionWriter writer(file);
+  writer.write(&header, sizeof(header));
+
+  header.directory = writer.write(state.directory.utf16(),
+                                  state.directory.size() * sizeof(char16_t));
+
+  // chunk table, then the chunks it points to
+  QList<SnapshotChunk> chunks(state.cold.size());
+  quint64 tableSize = chunks.size() * sizeof(SnapshotChunk);
+  quint64 dataOffset = aligned(aligned(writer.position()) + tableSize);
+  for (int i = 0; i < state.cold.size(); i++) {
+    const SessionChunk &cold = state.cold[i];
+    chunks[i] = {dataOffset, quint64(cold.compressed.size()), cold.rawBytes,
+                 cold.lines, 0};
+    dataOffset = aligned(dataOffset + cold.compressed.size());
+  }
+  header.chunks =
+      writer.write(chunks.constData(), chunks.size() * sizeof(SnapshotChunk));
+  for (const SessionChunk &cold : state.cold) {
+    writer.write(cold.compressed.constData(), cold.compressed.size());
+  }
+
+  header.hotText = writer.write(state.hot.text.utf16(),
+                                state.hot.text.size() * sizeof(char16_t));
+
+  QList<SnapshotRun> runs;
+  runs.reserve(state.hot.runs.size());
+  for (const ScrollbackRun &run : state.hot.runs) {
+    runs.append({run.start, run.length, run.color, run.bold ? 1u : 0u});
+  }
+  header.hotRuns =
+      writer.write(runs.constData(), runs.size() * sizeof(SnapshotRun));
+
+  // commands and directories go to one string pool
+  QList<SnapshotBlock> blocks;
+  QString strings;
+  for (const OutputBlock &block : state.blocks) {
+    blocks.append({block.start, block.outputStart, block.end, block.startTime,
+                   block.endTime, block.bytes, quint64(strings.size()),
+                   quint32(block.command.size()), block.exitCode,
+                   block.folded ? 1u : 0u, quint32(block.directory.size())});
+    strings += block.command;
+    strings += block.directory;
+  }
+  header.blocks =
+      writer.write(blocks.constData(), blocks.size() * sizeof(SnapshotBlock));
+  header.strings =
+      writer.write(strings.utf16(), strings.size() * sizeof(char16_t));
+
+  file.seek(0);
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+  if (!file.commit()) {
+    *error = file.errorString();
+    return false;
+  }
+  return true;
+}
+
+// Section inside a file of size bytes, holding whole records
+static bool validSection(const SnapshotSection &section, std::size_t size,
+                         std::size_t recordSize) {
+  return section.offset <= size && section.size <= size - section.offset &&
+         section.size % recordSize == 0;
+}
+
+bool SessionSnapshot::restore(SessionState *state, QString *error) const {
+  MappedFile file(QFile::encodeName(snapshotPath).constData(),
+                  MappedFile::Sequential);
+  if (!file.isValid()) {
+    *error = QString::fromLocal8Bit(std::strerror(file.error()));
+    return false;
+  }
+
+  SnapshotHeader header;
+  if (file.size() < sizeof(header)) {
+    *error = "truncated snapshot";
+    return false;
+  }
+  std::memcpy(&header, file.data(), sizeof(header));
+
+  if (std::memcmp(header.magic, snapshotMagic, sizeof(snapshotMagic)) != 0 ||
+      header.version != snapshotVersion) {
+    *error = "not a session snapshot";
+    return false;
+  }
+
+  std::size_t size = file.size();
+  if (!validSection(header.directory, size, sizeof(char16_t)) ||
+      !validSection(header.chunks, size, sizeof(SnapshotChunk)) ||
+      !validSection(header.hotText, size, sizeof(char16_t)) ||
+      !validSection(header.hotRuns, size, sizeof(SnapshotRun)) ||
+      !validSection(header.blocks, size, sizeof(SnapshotBlock)) ||
+      !validSection(header.strings, size, sizeof(char16_t))) {
+    *error = "damaged snapshot";
+    return false;
+  }
+
+  const char *data = file.data();
+  // copied verbatim, offsets into the text must not move
+  auto text = [data](const SnapshotSection &section) {
+    return QString(reinterpret_cast<const QChar *>(data + section.offset),
+                   qsizetype(section.size / sizeof(char16_t)));
+  };
+
+  SessionState restored;
+  restored.directory = text(header.directory);
+  restored.coldChars = header.coldChars;
+
+  // compressed chunks are copied as they are, nothing is inflated
+  qsizetype chunkCount = qsizetype(header.chunks.size / sizeof(SnapshotChunk));
+  restored.cold.reserve(chunkCount);
+  for (qsizetype i = 0; i < chunkCount; i++) {
+    SnapshotChunk chunk;
+    std::memcpy(&chunk, data + header.chunks.offset + i * sizeof(chunk),
+                sizeof(chunk));
+    if (!validSection({chunk.offset, chunk.size}, size, 1)) {
+      *error = "damaged snapshot";
+      return false;
+    }
+
+    SessionChunk cold;
+    cold.compressed = QByteArray(data + chunk.offset, qsizetype(chunk.size));
+    cold.lines = chunk.lines;
+    cold.rawBytes = chunk.rawBytes;
+    restored.cold.append(cold);
+  }
+
+  restored.hot.text = text(header.hotText);
+  restored.hot.lines = header.hotLines;
+
+  qsizetype runCount = qsizetype(header.hotRuns.size / sizeof(SnapshotRun));
+  restored.hot.runs.resize(runCount);
+  for (qsizetype i = 0; i < runCount; i++) {
+    SnapshotRun run;
+    std::memcpy(&run, data + header.hotRuns.offset + i * sizeof(run),
+                sizeof(run));
+    if (run.start < 0 || run.length < 0 ||
+        run.start + qint64(run.length) > restored.hot.text.size()) {
+      *error = "damaged snapshot";
+      return false;
+    }
+    restored.hot.runs[i] = {run.start, run.length, run.color, run.bold != 0};
+  }
+
+  QString strings = text(header.strings);
+  qsizetype blockCount =
+      qsizetype(header.blocks.size / sizeof(SnapshotBlock));
+  restored.blocks.reserve(blockCount);
+  for (qsizetype i = 0; i < blockCount; i++) {
+    SnapshotBlock record;
+    std::memcpy(&record, data + header.blocks.offset + i * sizeof(record),
+                sizeof(record));
+
+    OutputBlock block;
+    block.command = strings.mid(qsizetype(record.command),
+                                qsizetype(record.commandLength));
+    block.directory =
+        strings.mid(qsizetype(record.command + record.commandLength),
+                    qsizetype(record.directoryLength));
+    block.start = record.start;
+    block.outputStart = record.outputStart;
+    block.end = record.end;
+    block.exitCode = record.exitCode;
+    block.startTime = record.startTime;
+    block.endTime = record.endTime;
+    block.bytes = record.bytes;
+    block.folded = record.folded != 0;
+    restored.blocks.append(block);
+  }
+
+  *state = restored;
+  return true;
+}
@@ -0,0 +1,312 @@
+#include "TextScan.h"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define QSHELL_X86_SIMD 1
+#endif
+
+namespace {
+
+// Buffers below this size are not worth a thread
+constexpr std::size_t parallelThreshold = 8 * 1024 * 1024;
+
+std::size_t countNewlinesScalar(const char *data, std::size_t size) {
+  std::size_t count = 0;
+  const char *end = data + size;
+
+  while (const char *found =
+             static_cast<const char *>(std::memchr(data, '\n', end - data))) {
+    count++;
+    data = found + 1;
+  }
+
+  return count;
+}
+
+#ifdef QSHELL_X86_SIMD
+
+// Byte counters are summed with psadbw before they can overflow (255 rounds)
+__attribute__((target("sse2"))) std::size_t
+countNewlinesSse2(const char *data, std::size_t size) {
+  const __m128i newline = _mm_set1_epi8('\n');
+  const __m128i zero = _mm_setzero_si128();
+  std::size_t count = 0;
+  std::size_t i = 0;
+
+  while (i + 16 <= size) {
+    __m128i counters = zero;
+    for (int round = 0; round < 255 && i + 16 <= size; round++, i += 16) {
+      __m128i chunk =
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+      counters = _mm_sub_epi8(counters, _mm_cmpeq_epi8(chunk, newline));
+    }
+
+    __m128i sums = _mm_sad_epu8(counters, zero);
+    count += _mm_cvtsi128_si32(sums) +
+             _mm_cvtsi128_si32(_mm_unpackhi_epi64(sums, sums));
+  }
+
+  return count + countNewlinesScalar(data + i, size - i);
+}
+
+__attribute__((target("avx2"))) std::size_t
+countNewlinesAvx2(const char *data, std::size_t size) {
+  const __m256i newline = _mm256_set1_epi8('\n');
+  const __m256i zero = _mm256_setzero_si256();
+  std::size_t count = 0;
+  std::size_t i = 0;
+
+  while (i + 32 <= size) {
+    __m256i counters = zero;
+    for (int round = 0; round < 255 && i + 32 <= size; round++, i += 32) {
+      __m256i chunk =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+      counters = _mm256_sub_epi8(counters, _mm256_cmpeq_epi8(chunk, newline));
+    }
+
+    __m256i sums = _mm256_sad_epu8(counters, zero);
+    count += _mm256_extract_epi64(sums, 0) + _mm256_extract_epi64(sums, 1) +
+             _mm256_extract_epi64(sums, 2) + _mm256_extract_epi64(sums, 3);
+  }
+
+  return count + countNewlinesScalar(data + i, size - i);
+}
+
+// Candidate positions have matching first and last needle bytes, the middle
+// is verified with memcmp (needle size >= 2)
+__attribute__((target("sse2"))) const char *
+findLiteralSse2(const char *data, std::size_t size, const char *needle,
+                std::size_t needleSize) {
+  const __m128i first = _mm_set1_epi8(needle[0]);
+  const __m128i last = _mm_set1_epi8(needle[needleSize - 1]);
+  std::size_t i = 0;
+
+  for (; i + needleSize - 1 + 16 <= size; i += 16) {
+    __m128i blockFirst =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+    __m128i blockLast = _mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(data + i + needleSize - 1));
+    unsigned mask = _mm_movemask_epi8(_mm_and_si128(
+        _mm_cmpeq_epi8(first, blockFirst), _mm_cmpeq_epi8(last, blockLast)));
+
+    while (mask) {
+      unsigned bit = __builtin_ctz(mask);
+      if (std::memcmp(data + i + bit + 1, needle + 1, needleSize - 2) == 0) {
+        return data + i + bit;
+      }
+      mask &= mask - 1;
+    }
+  }
+
+  return static_cast<const char *>(
+      ::memmem(data + i, size - i, needle, needleSize));
+}
+
+__attribute__((target("avx2"))) const char *
+findLiteralAvx2(const char *data, std::size_t size, const char *needle,
+                std::size_t needleSize) {
+  const __m256i first = _mm256_set1_epi8(needle[0]);
+  const __m256i last = _mm256_set1_epi8(needle[needleSize - 1]);
+  std::size_t i = 0;
+
+  for (; i + needleSize - 1 + 32 <= size; i += 32) {
+    __m256i blockFirst =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+    __m256i blockLast = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i *>(data + i + needleSize - 1));
+    unsigned mask = _mm256_movemask_epi8(
+        _mm256_and_si256(_mm256_cmpeq_epi8(first, blockFirst),
+                         _mm256_cmpeq_epi8(last, blockLast)));
+
+    while (mask) {
+      unsigned bit = __builtin_ctz(mask);
+      if (std::memcmp(data + i + bit + 1, needle + 1, needleSize - 2) == 0) {
+        return data + i + bit;
+      }
+      mask &= mask - 1;
+    }
+  }
+
+  return static_cast<const char *>(
+      ::memmem(data + i, size - i, needle, needleSize));
+}
+
+#endif
+
+using CountFunction = std::size_t (*)(const char *, std::size_t);
+using FindFunction = const char *(*)(const char *, std::size_t, const char *,
+                                     std::size_t);
+
+const char *findLiteralScalar(const char *data, std::size_t size,
+                              const char *needle, std::size_t needleSize) {
+  return static_cast<const char *>(::memmem(data, size, needle, needleSize));
+}
+
+// Picks the widest instruction set once
+CountFunction selectCountFunction() {
+#ifdef QSHELL_X86_SIMD
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return countNewlinesAvx2;
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    return countNewlinesSse2;
+  }
+#endif
+  return countNewlinesScalar;
+}
+
+FindFunction selectFindFunction() {
+#ifdef QSHELL_X86_SIMD
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return findLiteralAvx2;
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    return findLiteralSse2;
+  }
+#endif
+  return findLiteralScalar;
+}
+
+inline bool isSpace(unsigned char character) {
+  return character == ' ' || (character >= '\t' && character <= '\r');
+}
+
+std::size_t countWordsScalar(const char *data, std::size_t size,
+                             bool previousSpace) {
+  std::size_t words = 0;
+
+  for (std::size_t i = 0; i < size; i++) {
+    bool space = isSpace(static_cast<unsigned char>(data[i]));
+    if (!space && previousSpace) {
+      words++;
+    }
+    previousSpace = space;
+  }
+
+  return words;
+}
+
+// Runs count(chunk, previousByteIsSpace) over per-thread chunks and sums them
+template <typename Count>
+std::size_t sumChunks(const char *data, std::size_t size, Count count) {
+  unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+  threads = std::min<std::size_t>(threads, size / parallelThreshold + 1);
+
+  if (threads <= 1) {
+    return count(data, size, true);
+  }
+
+  std::size_t chunkSize = size / threads;
+  std::vector<std::size_t> results(threads, 0);
+  std::vector<std::thread> workers;
+  workers.reserve(threads - 1);
+
+  auto runChunk = [&](unsigned index) {
+    std::size_t begin = index * chunkSize;
+    std::size_t end = index == threads - 1 ? size : begin + chunkSize;
+    bool previousSpace =
+        begin == 0 || isSpace(static_cast<unsigned char>(data[begin - 1]));
+    results[index] = count(data + begin, end - begin, previousSpace);
+  };
+
+  for (unsigned index = 1; index < threads; index++) {
+    workers.emplace_back(runChunk, index);
+  }
+  runChunk(0);
+
+  for (std::thread &worker : workers) {
+    worker.join();
+  }
+
+  std::size_t total = 0;
+  for (std::size_t result : results) {
+    total += result;
+  }
+
+  return total;
+}
+
+} // namespace
+
+namespace TextScan {
+
+std::size_t countNewlines(const char *data, std::size_t size) {
+  static const CountFunction count = selectCountFunction();
+  return count(data, size);
+}
+
+std::size_t countNewlinesParallel(const char *data, std::size_t size) {
+  return sumChunks(data, size,
+                   [](const char *chunk, std::size_t length, bool) {
+                     return countNewlines(chunk, length);
+                   });
+}
+
+std::size_t countWords(const char *data, std::size_t size) {
+  return sumChunks(data, size, countWordsScalar);
+}
+
+std::size_t headLength(const char *data, std::size_t size, std::size_t lines) {
+  std::size_t offset = 0;
+
+  while (lines > 0 && offset < size) {
+    const void *found = std::memchr(data + offset, '\n', size - offset);
+    if (!found) {
+      return size;
+    }
+    offset = static_cast<const char *>(found) - data + 1;
+    lines--;
+  }
+
+  return offset;
+}
+
+std::size_t tailOffset(const char *data, std::size_t size, std::size_t lines) {
+  if (lines == 0 || size == 0) {
+    return size;
+  }
+
+  // the final newline terminates the last line, it does not start one
+  std::size_t end = data[size - 1] == '\n' ? size - 1 : size;
+
+  while (end > 0) {
+    const void *found = ::memrchr(data, '\n', end);
+    if (!found) {
+      return 0;
+    }
+
+    std::size_t newline = static_cast<const char *>(found) - data;
+    if (--lines == 0) {
+      return newline + 1;
+    }
+    end = newline;
+  }
+
+  return 0;
+}
+
+const char *findLiteral(const char *data, std::size_t size, const char *needle,
+                        std::size_t needleSize) {
+  if (needleSize == 0) {
+    return data;
+  }
+
+  if (needleSize > size) {
+    return nullptr;
+  }
+
+  if (needleSize == 1) {
+    return static_cast<const char *>(std::memchr(data, needle[0], size));
+  }
+
+  static const FindFunction find = selectFindFunction();
+  return find(data, size, needle, needleSize);
+}
+
+} // namespace TextScan
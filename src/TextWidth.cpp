@@ -0,0 +1,312 @@
+#include "TextWidth.h"
+#include "UnicodeRanges.h"
+#include <array>
+
+namespace TextWidth {
+namespace {
+
+// Code points per second level block
+constexpr std::size_t blockBits = 8;
+constexpr std::size_t blockSize = std::size_t(1) << blockBits;
+constexpr std::size_t blockCount = 0x110000 >> blockBits;
+
+// Precomposed Hangul syllables, LV every 28 code points, LVT in between
+constexpr char32_t hangulFirst = 0xAC00;
+constexpr char32_t hangulLast = 0xD7A3;
+
+template <std::size_t N>
+constexpr std::size_t firstRangeEndingAfter(const ranges::Range (&list)[N],
+                                            char32_t codePoint) {
+  std::size_t low = 0;
+  std::size_t high = N;
+  while (low < high) {
+    std::size_t middle = (low + high) / 2;
+    if (list[middle].last < codePoint) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return low;
+}
+
+template <std::size_t N>
+constexpr std::uint8_t lookup(const ranges::Range (&list)[N],
+                              char32_t codePoint, std::uint8_t fallback) {
+  std::size_t index = firstRangeEndingAfter(list, codePoint);
+  if (index < N && list[index].first <= codePoint) {
+    return list[index].value;
+  }
+  return fallback;
+}
+
+constexpr std::uint8_t property(char32_t codePoint) {
+  std::uint8_t width = lookup(ranges::width, codePoint, 1);
+  std::uint8_t grapheme = lookup(ranges::grapheme, codePoint, Other);
+
+  if (codePoint >= hangulFirst && codePoint <= hangulLast) {
+    grapheme = (codePoint - hangulFirst) % 28 == 0 ? LV : LVT;
+  }
+
+  return std::uint8_t(width | grapheme << 2);
+}
+
+// True if a range starts or ends inside [first, last]
+template <std::size_t N>
+constexpr bool splits(const ranges::Range (&list)[N], char32_t first,
+                      char32_t last) {
+  for (std::size_t index = firstRangeEndingAfter(list, first);
+       index < N && list[index].first <= last; index++) {
+    if (list[index].first > first || list[index].last < last) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Blocks with a single value share one second level block
+constexpr bool isUniform(std::size_t block) {
+  char32_t first = char32_t(block << blockBits);
+  char32_t last = char32_t(first + blockSize - 1);
+
+  if (first <= hangulLast && last >= hangulFirst) {
+    return false;
+  }
+
+  return !splits(ranges::width, first, last) &&
+         !splits(ranges::grapheme, first, last);
+}
+
+constexpr std::size_t countBlocks() {
+  std::array<bool, 256> seen{};
+  std::size_t count = 0;
+
+  for (std::size_t block = 0; block < blockCount; block++) {
+    if (!isUniform(block)) {
+      count++;
+      continue;
+    }
+
+    std::uint8_t value = property(char32_t(block << blockBits));
+    if (!seen[value]) {
+      seen[value] = true;
+      count++;
+    }
+  }
+
+  return count;
+}
+
+constexpr std::size_t tableBlocks = countBlocks();
+
+struct Tables {
+  std::array<std::uint16_t, blockCount> index{};
+  std::array<std::array<std::uint8_t, blockSize>, tableBlocks> blocks{};
+};
+
+constexpr Tables buildTables() {
+  Tables tables;
+  std::array<int, 256> uniformBlock{};
+  for (int &block : uniformBlock) {
+    block = -1;
+  }
+
+  std::size_t next = 0;
+  for (std::size_t block = 0; block < blockCount; block++) {
+    char32_t first = char32_t(block << blockBits);
+
+    if (isUniform(block)) {
+      std::uint8_t value = property(first);
+      if (uniformBlock[value] < 0) {
+        uniformBlock[value] = int(next);
+        tables.blocks[next++].fill(value);
+      }
+      tables.index[block] = std::uint16_t(uniformBlock[value]);
+      continue;
+    }
+
+    for (std::size_t offset = 0; offset < blockSize; offset++) {
+      tables.blocks[next][offset] = property(char32_t(first + offset));
+    }
+    tables.index[block] = std::uint16_t(next++);
+  }
+
+  return tables;
+}
+
+constexpr Tables tables = buildTables();
+
+constexpr std::uint8_t tableLookup(char32_t codePoint) {
+  return tables.blocks[tables.index[codePoint >> blockBits]]
+                      [codePoint & (blockSize - 1)];
+}
+
+static_assert(tableLookup(U'A') == (1 | Other << 2));
+static_assert(tableLookup(U'\u4E00') == (2 | Other << 2));
+static_assert(tableLookup(U'\u0301') == (0 | Extend << 2));
+static_assert(tableLookup(U'\uAC00') == (2 | LV << 2));
+static_assert(tableLookup(U'\U0001F600') == (2 | ExtendedPictographic << 2));
+
+// Decodes the code point at position, advancing past it
+char32_t decode(const char16_t *text, std::size_t length,
+                std::size_t &position) {
+  char32_t unit = text[position++];
+  if (unit >= 0xD800 && unit <= 0xDBFF && position < length) {
+    char32_t low = text[position];
+    if (low >= 0xDC00 && low <= 0xDFFF) {
+      position++;
+      return 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+    }
+  }
+  return unit;
+}
+
+// UAX #29 rules GB3-GB9b, GB11-GB13 are handled with the cluster state
+bool breaksBetween(GraphemeBreak before, GraphemeBreak after) {
+  if (before == CR && after == LF) {
+    return false;
+  }
+  if (before == CR || before == LF || before == Control || after == CR ||
+      after == LF || after == Control) {
+    return true;
+  }
+  if (before == L && (after == L || after == V || after == LV || after == LVT)) {
+    return false;
+  }
+  if ((before == LV || before == V) && (after == V || after == T)) {
+    return false;
+  }
+  if ((before == LVT || before == T) && after == T) {
+    return false;
+  }
+  if (after == Extend || after == ZWJ || after == SpacingMark ||
+      before == Prepend) {
+    return false;
+  }
+  return true;
+}
+
+} // namespace
+
+std::uint8_t properties(char32_t codePoint) {
+  if (codePoint > 0x10FFFF) {
+    return 1 | Other << 2;
+  }
+  return tableLookup(codePoint);
+}
+
+std::size_t nextGrapheme(const char16_t *text, std::size_t length,
+                         std::size_t position, int *width) {
+  if (position >= length) {
+    if (width) {
+      *width = 0;
+    }
+    return length;
+  }
+
+  char32_t codePoint = decode(text, length, position);
+  std::uint8_t packed = properties(codePoint);
+
+  GraphemeBreak previous = GraphemeBreak(packed >> 2);
+  int columns = packed & 0x3;
+  bool pictographic = previous == ExtendedPictographic; // GB11 sequence
+  int regionalIndicators = previous == RegionalIndicator ? 1 : 0;
+
+  while (position < length) {
+    std::size_t nextPosition = position;
+    char32_t nextCodePoint = decode(text, length, nextPosition);
+
+    // ASCII after ASCII always starts a new cluster (except CR LF)
+    if (nextCodePoint < 0x80 && codePoint < 0x80 &&
+        !(codePoint == '\r' && nextCodePoint == '\n')) {
+      break;
+    }
+
+    std::uint8_t nextPacked = properties(nextCodePoint);
+    GraphemeBreak current = GraphemeBreak(nextPacked >> 2);
+
+    bool joins = !breaksBetween(previous, current);
+    if (previous == ZWJ && current == ExtendedPictographic && pictographic) {
+      joins = true; // GB11
+    }
+    if (previous == RegionalIndicator && current == RegionalIndicator) {
+      joins = regionalIndicators % 2 == 1; // GB12, GB13
+    }
+
+    if (!joins) {
+      break;
+    }
+
+    if (current == RegionalIndicator) {
+      regionalIndicators++;
+      columns = 2; // flag
+    } else if (nextCodePoint == 0xFE0F) {
+      columns = 2; // emoji presentation
+    } else if ((nextPacked & 0x3) > columns) {
+      columns = nextPacked & 0x3;
+    }
+
+    if (current == ExtendedPictographic) {
+      pictographic = true;
+    } else if (current != Extend && current != ZWJ) {
+      pictographic = false;
+    }
+
+    previous = current;
+    codePoint = nextCodePoint;
+    position = nextPosition;
+  }
+
+  if (width) {
+    *width = columns;
+  }
+  return position;
+}
+
+int displayWidth(const char16_t *text, std::size_t length) {
+  int columns = 0;
+  std::size_t position = 0;
+
+  while (position < length) {
+    // ASCII fast path, the last ASCII character may start a cluster
+    // (e + U+0301, keycaps) and goes through the tables
+    while (position + 1 < length && text[position] < 0x80 &&
+           text[position + 1] < 0x80) {
+      char16_t unit = text[position++];
+      columns += unit >= 0x20 && unit != 0x7F ? 1 : 0;
+    }
+
+    if (position >= length) {
+      break;
+    }
+
+    int clusterWidth = 0;
+    position = nextGrapheme(text, length, position, &clusterWidth);
+    columns += clusterWidth;
+  }
+
+  return columns;
+}
+
+std::size_t fitColumns(const char16_t *text, std::size_t length, int columns,
+                       int *width) {
+  int used = 0;
+  std::size_t position = 0;
+
+  while (position < length) {
+    int clusterWidth = 0;
+    std::size_t end = nextGrapheme(text, length, position, &clusterWidth);
+    if (used + clusterWidth > columns) {
+      break;
+    }
+    used += clusterWidth;
+    position = end;
+  }
+
+  if (width) {
+    *width = used;
+  }
+  return position;
+}
+
+} // namespace TextWidth
@@ -0,0 +1,152 @@
+#include "Trace.h"
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+
+namespace Trace {
+
+// Events kept, a power of two
+static constexpr std::uint64_t capacity = 1 << 16;
+
+// Fields are relaxed atomics, a reader may copy a slot being rewritten and
+// drops it when the sequence changed underneath
+struct Slot {
+  std::atomic<std::uint64_t> sequence{0}; // 2n + 2 once event n is complete
+  std::atomic<const char *> name{nullptr};
+  std::atomic<std::int64_t> start{0};
+  std::atomic<std::int64_t> duration{0};
+  std::atomic<std::int64_t> value{0};
+  std::atomic<std::uint32_t> thread{0};
+};
+
+static Slot ring[capacity];
+static std::atomic<std::uint64_t> head{0};    // Next event number
+static std::atomic<std::uint64_t> cleared{0}; // First event dumps include
+static std::atomic<std::uint32_t> threads{0}; // Thread numbers handed out
+
+static std::uint32_t threadNumber() {
+  thread_local std::uint32_t number = ++threads;
+  return number;
+}
+
+std::int64_t now() {
+  static const auto epoch = std::chrono::steady_clock::now();
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - epoch)
+      .count();
+}
+
+static void record(const char *name, std::int64_t start,
+                   std::int64_t duration, std::int64_t value) {
+  std::uint64_t n = head.fetch_add(1, std::memory_order_relaxed);
+  Slot &slot = ring[n & (capacity - 1)];
+
+  slot.sequence.store(2 * n + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.name.store(name, std::memory_order_relaxed);
+  slot.start.store(start, std::memory_order_relaxed);
+  slot.duration.store(duration, std::memory_order_relaxed);
+  slot.value.store(value, std::memory_order_relaxed);
+  slot.thread.store(threadNumber(), std::memory_order_relaxed);
+  slot.sequence.store(2 * n + 2, std::memory_order_release);
+}
+
+void complete(const char *name, std::int64_t start, std::int64_t value) {
+  record(name, start, now() - start, value);
+}
+
+void counter(const char *name, std::int64_t value) {
+  record(name, now(), -1, value);
+}
+
+std::uint64_t read(std::uint64_t position, std::vector<Event> *events) {
+  std::uint64_t end = head.load(std::memory_order_acquire);
+  if (end > capacity && position < end - capacity) {
+    position = end - capacity; // older events were overwritten
+  }
+
+  for (std::uint64_t n = position; n < end; n++) {
+    const Slot &slot = ring[n & (capacity - 1)];
+    std::uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+    if (sequence != 2 * n + 2) {
+      continue; // still being written, or already reused
+    }
+
+    Event event;
+    event.name = slot.name.load(std::memory_order_relaxed);
+    event.start = slot.start.load(std::memory_order_relaxed);
+    event.duration = slot.duration.load(std::memory_order_relaxed);
+    event.value = slot.value.load(std::memory_order_relaxed);
+    event.thread = slot.thread.load(std::memory_order_relaxed);
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.sequence.load(std::memory_order_relaxed) == sequence) {
+      events->push_back(event);
+    }
+  }
+  return end;
+}
+
+void clear() { cleared = head.load(); }
+
+// Names are literals from the trace points, escaped all the same
+static void writeString(std::FILE *file, const char *text) {
+  std::fputc('"', file);
+  for (; *text; text++) {
+    unsigned char c = static_cast<unsigned char>(*text);
+    if (c == '"' || c == '\\') {
+      std::fprintf(file, "\\%c", c);
+    } else if (c < 0x20) {
+      std::fprintf(file, "\\u%04x", c);
+    } else {
+      std::fputc(c, file);
+    }
+  }
+  std::fputc('"', file);
+}
+
+long writeChromeTrace(const std::string &path, std::string *error) {
+  std::vector<Event> events;
+  events.reserve(capacity);
+  read(cleared, &events);
+
+  std::FILE *file = std::fopen(path.c_str(), "w");
+  if (!file) {
+    *error = std::strerror(errno);
+    return -1;
+  }
+
+  // timestamps are microseconds, fractions keep the nanoseconds
+  int pid = int(::getpid());
+  std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", file);
+  for (std::size_t i = 0; i < events.size(); i++) {
+    const Event &event = events[i];
+    std::fputs("{\"name\":", file);
+    writeString(file, event.name);
+    std::fprintf(file, ",\"pid\":%d,\"tid\":%u,\"ts\":%.3f", pid,
+                 event.thread, double(event.start) / 1000);
+    if (event.duration < 0) {
+      std::fprintf(file, ",\"ph\":\"C\",\"args\":{\"value\":%lld}}",
+                   static_cast<long long>(event.value));
+    } else {
+      std::fprintf(file,
+                   ",\"ph\":\"X\",\"dur\":%.3f,\"args\":{\"size\":%lld}}",
+                   double(event.duration) / 1000,
+                   static_cast<long long>(event.value));
+    }
+    std::fputs(i + 1 < events.size() ? ",\n" : "\n", file);
+  }
+  std::fputs("]}\n", file);
+
+  bool failed = std::ferror(file);
+  if (std::fclose(file) != 0 || failed) {
+    *error = std::strerror(errno);
+    return -1;
+  }
+  return long(events.size());
+}
+
+} // namespace Trace
@@ -0,0 +1,88 @@
+#include "TreeWalk.h"
+#include <QFile>
+#include <QMutexLocker>
+#include <QThread>
+#include <cstring>
+
+// Interval between output batches while walking
+static constexpr int flushInterval = 50;
+
+TreeWalk::TreeWalk(const QString &name, const WalkOptions &options,
+                   QObject *parent)
+    : QObject(parent), name(name), walker(options) {
+  flushTimer.setInterval(flushInterval);
+  connect(&flushTimer, &QTimer::timeout, this, &TreeWalk::flush);
+}
+
+TreeWalk::~TreeWalk() {
+  if (thread) {
+    walker.cancel();
+    thread->wait();
+    delete thread;
+  }
+}
+
+int TreeWalk::threadCount() const { return walker.threadCount(); }
+
+void TreeWalk::start(const QStringList &roots,
+                     const DirectoryWalker::Visitor &visitor,
+                     const std::function<void()> &finish) {
+  std::vector<std::string> paths;
+  for (const QString &root : roots) {
+    paths.push_back(QFile::encodeName(root).toStdString());
+  }
+
+  thread = QThread::create([this, paths, visitor, finish]() {
+    DirectoryWalker::ErrorHandler onError =
+        [this](const std::string &path, int error, int) {
+          reportError(path, error);
+        };
+
+    if (walker.walk(paths, visitor, onError) && finish) {
+      finish();
+    }
+  });
+
+  // queued to this thread, flushes whatever the finish step added
+  connect(thread, &QThread::finished, this, [this]() {
+    flushTimer.stop();
+    flush();
+    emit finished(hadError ? 1 : 0);
+  });
+
+  flushTimer.start();
+  thread->start();
+}
+
+void TreeWalk::appendOutput(const QString &output) {
+  QMutexLocker locker(&mutex);
+  pendingOutput += output;
+}
+
+void TreeWalk::reportError(const std::string &path, int error) {
+  QString message = QString("%1: '%2': %3\n")
+                        .arg(name, QFile::decodeName(path.c_str()),
+                             QString::fromLocal8Bit(std::strerror(error)));
+
+  QMutexLocker locker(&mutex);
+  pendingErrors += message;
+  hadError = true;
+}
+
+void TreeWalk::flush() {
+  QString output;
+  QString errors;
+  {
+    QMutexLocker locker(&mutex);
+    output.swap(pendingOutput);
+    errors.swap(pendingErrors);
+  }
+
+  if (!errors.isEmpty()) {
+    emit errorReady(errors);
+  }
+
+  if (!output.isEmpty()) {
+    emit outputReady(output);
+  }
+}
@@ -0,0 +1,167 @@
+#include "WatchCommand.h"
+#include "ChildProcess.h"
+#include "TextWidth.h"
+#include <QDateTime>
+#include <QTimer>
+#include <algorithm>
+
+// Output kept from one run, a runaway command can't grow the region forever
+static constexpr int maxLines = 1000;
+
+// Tabs are expanded so cut lines and changed columns line up
+static QString expandTabs(const QString &line) {
+  if (!line.contains('\t')) {
+    return line;
+  }
+
+  QString expanded;
+  for (QChar character : line) {
+    if (character == '\t') {
+      expanded += QString(8 - expanded.size() % 8, QChar(' '));
+    } else {
+      expanded += character;
+    }
+  }
+  return expanded;
+}
+
+WatchCommand::WatchCommand(const QString &command, double interval,
+                           int columns, bool highlight, bool title,
+                           QObject *parent)
+    : QObject(parent), command(command),
+      interval(std::max(100, int(interval * 1000))), columns(columns),
+      highlight(highlight), title(title) {
+  timer = new QTimer(this);
+  timer->setSingleShot(true);
+  connect(timer, &QTimer::timeout, this, &WatchCommand::run);
+}
+
+WatchCommand::~WatchCommand() {
+  // kills a run that is still going
+  delete child;
+}
+
+void WatchCommand::start() { run(); }
+
+void WatchCommand::run() {
+  output.clear();
+
+  child = new ChildProcess(this);
+  connect(child, &ChildProcess::outputReady, this,
+          [this](QString data) { output += data; });
+  connect(child, &ChildProcess::errorReady, this,
+          [this](QString data) { output += data; });
+  connect(child, &ChildProcess::finished, this, &WatchCommand::runFinished);
+
+  if (!child->start("/bin/sh", {"-c", command})) {
+    delete child;
+    child = nullptr;
+    emit errorReady("watch: cannot run /bin/sh");
+    timer->start(interval);
+  }
+}
+
+void WatchCommand::runFinished(int exitCode) {
+  child->deleteLater();
+  child = nullptr;
+
+  QStringList lines = screen(exitCode);
+  QList<WatchLine> changed;
+
+  // same row compared with the previous run, unchanged rows are not sent
+  for (int row = 0; row < lines.size(); row++) {
+    bool existed = row < shown.size();
+    if (existed && lines[row] == shown[row]) {
+      continue;
+    }
+
+    WatchLine line;
+    line.row = row;
+    line.text = lines[row];
+    if (highlight && existed && !(title && row == 0)) {
+      line.highlights = changedSpans(lines[row], shown[row]);
+    }
+    changed.append(line);
+  }
+
+  bool shrunk = lines.size() < shown.size();
+  shown = lines;
+
+  if (!changed.isEmpty() || shrunk) {
+    emit regionUpdated(shown.size(), changed);
+  }
+
+  timer->start(interval);
+}
+
+QStringList WatchCommand::screen(int exitCode) const {
+  QStringList lines;
+
+  if (title) {
+    QString header = QString("Every %1s: %2")
+                         .arg(interval / 1000.0, 0, 'f', 1)
+                         .arg(command);
+    if (exitCode != 0) {
+      header += QString(" (exit %1)").arg(exitCode);
+    }
+
+    // the clock goes to the right edge like watch does
+    QString clock = QDateTime::currentDateTime().toString("ddd MMM d HH:mm:ss yyyy");
+    int padding = columns - header.size() - clock.size();
+    header += padding > 1 ? QString(padding, QChar(' ')) : QString("  ");
+    header += clock;
+
+    lines << header << QString();
+  }
+
+  QStringList outputLines = output.split('\n');
+  if (output.endsWith('\n')) {
+    outputLines.removeLast();
+  }
+
+  for (const QString &outputLine : outputLines) {
+    if (lines.size() >= maxLines) {
+      break;
+    }
+
+    QString line = expandTabs(outputLine);
+    if (line.endsWith('\r')) {
+      line.chop(1);
+    }
+
+    // cut at the terminal width, a wrapped line would shift the rows below
+    if (columns > 0) {
+      line.truncate(int(TextWidth::fitColumns(
+          reinterpret_cast<const char16_t *>(line.utf16()), line.size(),
+          columns)));
+    }
+    lines << line;
+  }
+
+  return lines;
+}
+
+QList<OutputSpan> WatchCommand::changedSpans(const QString &line,
+                                             const QString &previous) {
+  QList<OutputSpan> spans;
+
+  for (int position = 0; position < line.size();) {
+    if (position < previous.size() && line[position] == previous[position]) {
+      position++;
+      continue;
+    }
+
+    // one span per run of differing characters
+    OutputSpan span;
+    span.start = position;
+    while (position < line.size() &&
+           (position >= previous.size() ||
+            line[position] != previous[position])) {
+      position++;
+    }
+    span.length = position - span.start;
+    spans.append(span);
+  }
+
+  return spans;
+}
@@ -1,8 +1,63 @@
 #include <QApplication>
+#include <QCoreApplication>
 #include <QDebug>
+#include <QStringList>
+#include <QTextStream>
+#include <HeadlessShell.h>
 #include <QShellUI.h>
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// stdin holds a script when redirected from a file or a pipe (not /dev/null)
+static bool stdinIsScript() {
+  if (isatty(STDIN_FILENO)) {
+    return false;
+  }
+
+  struct stat info;
+  if (fstat(STDIN_FILENO, &info) != 0) {
+    return false;
+  }
+
+  return S_ISREG(info.st_mode) || S_ISFIFO(info.st_mode);
+}
 
 int main(int argc, char *argv[]) {
+  // headless mode: qshell -c "cmd"
+  if (argc > 1 && std::strcmp(argv[1], "-c") == 0) {
+    if (argc < 3) {
+      std::fprintf(stderr, "qshell: -c: option requires an argument\n");
+      return 2;
+    }
+
+    QCoreApplication app(argc, argv);
+    HeadlessShell shell;
+    return shell.runCommand(QString::fromLocal8Bit(argv[2]));
+  }
+
+  // headless mode: qshell script.qsh [args...]
+  if (argc > 1 && argv[1][0] != '-') {
+    QCoreApplication app(argc, argv);
+    HeadlessShell shell;
+
+    QStringList args;
+    for (int i = 2; i < argc; i++) {
+      args.append(QString::fromLocal8Bit(argv[i]));
+    }
+
+    return shell.runFile(QString::fromLocal8Bit(argv[1]), args);
+  }
+
+  // headless mode: qshell < script
+  if (argc == 1 && stdinIsScript()) {
+    QCoreApplication app(argc, argv);
+    HeadlessShell shell;
+    QTextStream input(stdin, QIODevice::ReadOnly);
+    return shell.runScript(input);
+  }
+
   // create app
   QApplication app(argc, argv);
 
@@ -15,4 +70,3 @@ int main(int argc, char *argv[]) {
   // start event loop
   return app.exec();
 }
-
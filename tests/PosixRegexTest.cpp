@@ -0,0 +1,99 @@
+// Checks PosixRegex::toPcre on patterns whose meaning differs between
+// POSIX (GNU grep -G / -E) and PCRE2
+//
+// Each case gives a pattern, a line and whether GNU grep selects the line;
+// the rewritten pattern must be valid and agree.
+
+#include "PosixRegex.h"
+#include <QRegularExpression>
+#include <cstdio>
+
+struct Case {
+  bool extended;
+  const char *pattern;
+  const char *line;
+  bool matches;
+};
+
+static const Case cases[] = {
+    // intervals, an empty low bound is 0
+    {false, "ab\\{2,3\\}c", "abbc", true},
+    {false, "ab\\{2,3\\}c", "abc", false},
+    {false, "ab\\{2,3\\}c", "abbbbc", false},
+    {false, "^x\\{,3\\}y", "y", true},
+    {false, "^x\\{,3\\}y", "xxxy", true},
+    {false, "^x\\{,3\\}y", "xxxxy", false},
+    {true, "^x{,3}y", "xxy", true},
+    {true, "^x{,3}y", "xxxxy", false},
+    {true, "a{1,2", "a{1,2", true},
+    {true, "a{x}", "a{x}", true},
+
+    // repeated repetitions, not possessive or lazy
+    {false, "ba**c", "baac", true},
+    {false, "ba**c", "bc", true},
+    {false, "ba**c", "ba*c", false},
+    {true, "ba**c", "baac", true},
+    {true, "ba*+c", "baac", true},
+
+    // '*' with nothing to repeat
+    {false, "^*", "*x", true},
+    {false, "^*", "x*", false},
+    {false, "*a", "*a", true},
+    {true, "^*", "x", true},
+
+    // anchors in groups and in the middle
+    {false, "\\(^a\\)", "ab", true},
+    {false, "\\(^a\\)", "ba", false},
+    {false, "a^b", "a^b", true},
+    {false, "a$b", "a$b", true},
+
+    // bracket expressions
+    {false, "[]a]", "]", true},
+    {false, "[]a]", "a", true},
+    {false, "[]a]", "b", false},
+    {false, "[a\\]", "\\", true},
+    {false, "[a\\]", "a", true},
+    {false, "[a\\]", "]", false},
+    {false, "[[:digit:]]x", "7x", true},
+
+    // basic operators are escaped, their bare forms literal
+    {false, "a+b", "a+b", true},
+    {false, "a+b", "aab", false},
+    {false, "a\\+b", "aab", true},
+    {true, "a+b", "aab", true},
+    {false, "\\(a\\|b\\)c", "bc", true},
+    {true, "(a|b)c", "bc", true},
+    {true, ")", "a)", true},
+    {false, "\\(a\\)\\1", "aa", true},
+    {false, "\\(a\\)\\1", "ab", false},
+
+    // word starts
+    {false, "\\<is", "this", false},
+    {false, "\\<is", "is it", true},
+};
+
+int main() {
+  int failures = 0;
+
+  for (const Case &test : cases) {
+    QString pcre = PosixRegex::toPcre(test.pattern, test.extended);
+    QRegularExpression regex(pcre);
+    bool matches = regex.match(QString(test.line)).hasMatch();
+
+    if (!regex.isValid() || matches != test.matches) {
+      failures++;
+      std::printf("%s '%s' on '%s' (as '%s'): %s, grep %d\n",
+                  test.extended ? "-E" : "-G", test.pattern, test.line,
+                  pcre.toUtf8().constData(),
+                  regex.isValid() ? (matches ? "1" : "0")
+                                  : regex.errorString().toUtf8().constData(),
+                  test.matches);
+    }
+  }
+
+  if (failures) {
+    std::printf("%d mismatches\n", failures);
+    return 1;
+  }
+  return 0;
+}